@@ -2,6 +2,7 @@ import simdgen
 import numpy
 import timeit
 import math
+import platform
 
 N = 8192
 C = 1000
@@ -11,14 +12,22 @@ b = numpy.arange(N, dtype='float32')
 for i in range(N):
 	a[i] = math.sin(i * 0.1) * 3
 
+isaTbl = [None]
+if platform.machine() in ['x86_64', 'AMD64']:
+	isaTbl = ['avx512', 'avx512vl', 'avx2']
+
 src = "log(cosh(x))"
-sg = simdgen.SgCode(src)
 print("func", src)
-print("simdgen", timeit.timeit(lambda: sg.calc(b, a), number=C))
+for isa in isaTbl:
+	try:
+		sg = simdgen.SgCode(src, isa and "isa=" + isa)
+	except RuntimeError:
+		print(isa, "is not supported")
+		continue
+	print("simdgen", timeit.timeit(lambda: sg.calc(b, a), number=C), isa or "")
+	sg.destroy()
 print("numpy  ", timeit.timeit(lambda: numpy.log(numpy.cosh(a)), number=C))
 
-sg.destroy()
-
 print("result top")
 c = numpy.log(numpy.cosh(a))
 for i in range(10):
@@ -35,13 +35,15 @@ def convert_ndarray_to_ctypes(a):
 	return a.ctypes.data_as(POINTER(c_float * len(a.flat))).contents
 
 class SgCode(Structure):
-	def __init__(self, src):
+	def __init__(self, src, opt=None):
 		if not g_lib:
 			init()
 		g_lib.SgCreate.restype = CFUNCTYPE(c_void_p)
 		self.p = g_lib.SgCreate()
 		if self.p == 0:
 			raise RuntimeError("SgCreate")
+		if opt and g_lib.SgSetOpt(self.p, c_char_p(opt.encode())) != 0:
+			raise RuntimeError("bad opt", opt)
 		self.reduce = src.find("red_sum") >= 0
 		if self.reduce:
 			g_lib.SgGetFuncAddr.restype = CFUNCTYPE(c_float, POINTER(c_float), c_size_t)
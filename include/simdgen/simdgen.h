@@ -32,11 +32,17 @@
 		#define SG_X64
 	#else
 		#define SG_AARCH64
-		#ifdef __APPLE__
-			#define SG_NEON
-		#else
-			#define SG_SVE
-		#endif
+	#endif
+#endif
+
+/*
+	define SG_NEON to use NEON instead of SVE
+*/
+#if defined(SG_AARCH64) && !(defined(SG_NEON) || defined(SG_SVE))
+	#ifdef __APPLE__
+		#define SG_NEON
+	#else
+		#define SG_SVE
 	#endif
 #endif
 
@@ -47,6 +53,55 @@ extern "C" {
 typedef struct SgCode SgCode;
 typedef void (*SgFuncFloat1)(float *dst, const float *src, size_t n);
 typedef float (*SgFuncFloat1Reduce)(const float *src, size_t n);
+typedef void (*SgFuncDouble1)(double *dst, const double *src, size_t n);
+typedef double (*SgFuncDouble1Reduce)(const double *src, size_t n);
+/*
+	the types of dst and src are given by SgSetType
+	the return value of SgFunc1Reduce is float
+*/
+typedef void (*SgFunc1)(void *dst, const void *src, size_t n);
+typedef float (*SgFunc1Reduce)(const void *src, size_t n);
+/*
+	functions with runtime parameters such as "exp(x*$a)+$b"
+	params[i] is the i-th parameter in order of appearance
+	params is double[] if the computation is done in double
+	the functions of the other types also take params as the last argument
+*/
+typedef void (*SgFuncFloat1Param)(float *dst, const float *src, size_t n, const float *params);
+typedef float (*SgFuncFloat1ReduceParam)(const float *src, size_t n, const float *params);
+/*
+	functions of several variables such as "var=x,y,z" in SG_OPT
+	srcs[i] is the array of the i-th variable
+*/
+typedef void (*SgFuncFloatN)(float *dst, const float *const *srcs, size_t n);
+typedef float (*SgFuncFloatNReduce)(const float *const *srcs, size_t n);
+typedef void (*SgFuncDoubleN)(double *dst, const double *const *srcs, size_t n);
+typedef double (*SgFuncDoubleNReduce)(const double *const *srcs, size_t n);
+typedef void (*SgFuncN)(void *dst, const void *const *srcs, size_t n);
+typedef float (*SgFuncNReduce)(const void *const *srcs, size_t n);
+/*
+	functions of several outputs such as "y0=exp(x); y1=log(x)"
+	dsts[i] is the array of the i-th output
+*/
+typedef void (*SgFuncFloatM)(float *const *dsts, const float *src, size_t n);
+typedef void (*SgFuncFloatMN)(float *const *dsts, const float *const *srcs, size_t n);
+typedef void (*SgFuncM)(void *const *dsts, const void *src, size_t n);
+typedef void (*SgFuncMN)(void *const *dsts, const void *const *srcs, size_t n);
+
+/*
+	element types of arrays (see SgSetType)
+*/
+enum {
+	SG_FLOAT = 0,
+	SG_DOUBLE = 1,
+	SG_FLOAT16 = 2, // IEEE 754 binary16
+	SG_BFLOAT16 = 3,
+	SG_UINT8 = 4, // integers are rounded and saturated as dst
+	SG_INT8 = 5,
+	SG_INT16 = 6,
+	SG_INT32 = 7
+};
+
 /*
 	create SgCode handler
 */
@@ -56,6 +111,32 @@ SG_DLL_API SgCode* SgCreate();
 */
 SG_DLL_API void SgDestroy(SgCode *sg);
 
+/*
+	set options such as "unroll=2 isa=avx512vl" (see SG_OPT in readme.md)
+	return 0 if success
+*/
+SG_DLL_API int SgSetOpt(SgCode *sg, const char *opt);
+
+/*
+	set the element types of dst and src of the function created by SgGetFuncAddr
+	SG_FLOAT ; SgFuncFloat1/SgFuncFloat1Reduce (default)
+	SG_DOUBLE ; SgFuncDouble1/SgFuncDouble1Reduce (both types must be SG_DOUBLE)
+	SG_FLOAT16/SG_BFLOAT16 ; SgFunc1/SgFunc1Reduce, computed in float
+	SG_UINT8/SG_INT8/SG_INT16/SG_INT32 ; SgFunc1/SgFunc1Reduce, computed in float
+	  the result is rounded by "round" of SG_OPT and saturated if dstType is one of them
+	dstType and srcType are independent except for SG_DOUBLE
+	return 0 if success
+*/
+SG_DLL_API int SgSetType(SgCode *sg, int dstType, int srcType);
+
+/*
+	define a function such as proto = "softclip(x,a)" and body = "a*tanh(x/a)"
+	it is expanded inline in src of SgGetFuncAddr
+	body is an expression of the params and may use the functions defined before
+	return 0 if success
+*/
+SG_DLL_API int SgDefine(SgCode *sg, const char *proto, const char *body);
+
 /*
 	create JIT function and return the function address
 	return 0 if error
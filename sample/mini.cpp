@@ -115,6 +115,33 @@ int red_sum()
 	double sum3 = sum_log_cosh_double(xd, N);
 	printf("sum1=%f sum2=%f sum3=%f\n", sum1/C, sum2/C, sum3);
 	SgDestroy(sg);
+
+	puts("red_sum double");
+	sg = SgCreate();
+	if (sg == 0 || SgSetType(sg, SG_DOUBLE, SG_DOUBLE) != 0) {
+		printf("init err\n");
+		return 1;
+	}
+	SgFuncDouble1Reduce addrD = (SgFuncDouble1Reduce)SgGetFuncAddr(sg, src);
+	if (addrD == 0) {
+		return 1;
+	}
+	begin = clock();
+	double sumD1 = 0;
+	for (size_t i = 0; i < C; i++) {
+		sumD1 += sum_log_cosh_double(xd, N);
+	}
+	end = clock();
+	printf("C  %6.2f usec\n", (end - begin) / (double)CLOCKS_PER_SEC / C * 1e6);
+	begin = clock();
+	double sumD2 = 0;
+	for (size_t i = 0; i < C; i++) {
+		sumD2 += addrD(xd, N);
+	}
+	end = clock();
+	printf("sg %6.2f usec\n", (end - begin) / (double)CLOCKS_PER_SEC / C * 1e6);
+	printf("sum1=%.15f sum2=%.15f\n", sumD1/C, sumD2/C);
+	SgDestroy(sg);
 	return 0;
 }
 
@@ -3,11 +3,13 @@
 #include <simdgen/simdgen.h>
 #include <cybozu/exception.hpp>
 #include <cmath>
+#include <list>
 #include "const.hpp"
 
 using namespace Xbyak_aarch64;
 
 typedef std::vector<ZRegS> ZRegSVec;
+typedef std::vector<ZRegD> ZRegDVec;
 typedef std::vector<PRegS> PRegSVec;
 
 namespace sg {
@@ -27,48 +29,207 @@ static const int savePredBegin = 4;
 
 struct Generator : CodeGenerator, sg::GeneratorBase {
 	static const size_t dataSize = 4096;
-	static const size_t codeSize = 8192;
-	static const size_t totalSize = dataSize + codeSize;
+	static const size_t minCodeSize = 8192;
+	static const size_t maxCodeSize = 1 << 20;
+	size_t codeSize_; // SgGetFuncAddr doubles it if the code is too big
 	XReg dataReg_;
 	XReg tmp64_;
 	WReg tmp32_;
 	XReg loop_i_;
+	XReg stepN_; // # of elements processed by one unrolled loop
+	XReg paramReg_; // params given as the last argument
+	std::list<Label> skipL_; // labels for gen_beginSkip/gen_endSkip
 
-	Generator()
-		: CodeGenerator(totalSize)
+	/*
+		the vector length is not fixed (128, ..., 2048 bits),
+		so the generated code uses cntw/incw/addvl instead of it.
+		simdByte_ is the maximum length.
+	*/
+	explicit Generator(size_t codeSize = minCodeSize)
+		: CodeGenerator(dataSize + codeSize)
+		, codeSize_(codeSize)
 		, dataReg_(x3)
 		, tmp64_(x4)
 		, tmp32_(w4)
 		, loop_i_(x5)
+		, stepN_(x6)
+		, paramReg_(x15)
 	{
-#ifdef SG_NEON
-		simdByte_ = 128 / 8;
+		simdByte_ = SimdArray::byteSize;
 		maxSimdRegN_ = 32;
-#else
-		simdByte_ = 512 / 8;
-		maxSimdRegN_ = 32;
-#endif
 	}
-	// x[0] = sum(s[0:...15])
+	bool isCodeSizeError(const std::exception& e) const
+	{
+		const Xbyak_aarch64::Error *p = dynamic_cast<const Xbyak_aarch64::Error*>(&e);
+		return p != 0 && int(*p) == ERR_CODE_IS_TOO_BIG;
+	}
+	// x[0] = sum of all lanes of s
 	void reduceOne_sum(int d, int s)
 	{
 		assert(d != s);
-		faddv(SReg(d), p0, ZRegS(s));
+		if (isDouble()) {
+			faddv(DReg(d), p0, ZRegD(s));
+		} else {
+			faddv(SReg(d), p0, ZRegS(s));
+		}
+	}
+	static int getShift(int byte)
+	{
+		return byte == 1 ? 0 : byte == 2 ? 1 : byte == 4 ? 2 : 3;
+	}
+	/*
+		load float16/bfloat16/integers into each lane and convert it to float
+		the immediate of MUL_VL of ld1h/ld1b for .s is a multiple of VL/2 (VL/4) bytes
+	*/
+	template<class Addr>
+	void loadSrc(int idx, const _PReg& p, const Addr& addr)
+	{
+		ZRegS z(idx);
+		switch (srcType_) {
+		case SG_FLOAT16:
+			ld1h(z, p/T_z, addr);
+			fcvt(z, p0/T_m, ZRegH(idx));
+			break;
+		case SG_BFLOAT16:
+			ld1h(z, p/T_z, addr);
+			lsl(z, z, 16);
+			break;
+		case SG_UINT8:
+			ld1b(z, p/T_z, addr);
+			scvtf(z, p0/T_m, z);
+			break;
+		case SG_INT8:
+			ld1sb(z, p/T_z, addr);
+			scvtf(z, p0/T_m, z);
+			break;
+		case SG_INT16:
+			ld1sh(z, p/T_z, addr);
+			scvtf(z, p0/T_m, z);
+			break;
+		case SG_INT32:
+			ld1w(z, p/T_z, addr);
+			scvtf(z, p0/T_m, z);
+			break;
+		default:
+			ld1w(z, p/T_z, addr);
+			break;
+		}
 	}
-	void outputOne(const XReg& dst, int i, const XReg *tmpX = 0)
+	/*
+		convert float in idx to dstType_ and store it
+		w is a work register
+	*/
+	template<class Addr>
+	void storeDst(const Addr& addr, const _PReg& p, int idx, int w)
+	{
+		ZRegS z(idx);
+		switch (dstType_) {
+		case SG_FLOAT16:
+			fcvt(ZRegH(idx), p0/T_m, z);
+			st1h(z, p, addr);
+			break;
+		case SG_BFLOAT16:
+			{
+				/*
+					round to nearest even in integer
+					(x + 0x7fff + ((x >> 16) & 1)) >> 16
+				*/
+				ZRegS t(w);
+				lsr(t, z, 16);
+				and_(t, 1);
+				sub(t, 1);
+				add(t, t, z);
+				add(t, 0x80, LSL, 8);
+				lsr(t, t, 16);
+				st1h(t, p, addr);
+			}
+			break;
+		case SG_UINT8:
+		case SG_INT8:
+		case SG_INT16:
+		case SG_INT32:
+			storeInt(addr, p, idx);
+			break;
+		default:
+			st1w(z, p, addr);
+			break;
+		}
+	}
+	/*
+		round ZRegS(idx) by opt.roundMode, saturate it and store it as dstType_
+		fcvtzs saturates to int32 and sqxtnb/sqxtunb/uqxtnb (SVE2) narrow it into the bottom of each lane
+	*/
+	template<class Addr>
+	void storeInt(const Addr& addr, const _PReg& p, int idx)
+	{
+		ZRegS z(idx);
+		switch (opt.roundMode) {
+		case 0: frintn(z, p0/T_m, z); break;
+		case 1: frintm(z, p0/T_m, z); break;
+		case 2: frintp(z, p0/T_m, z); break;
+		default: frintz(z, p0/T_m, z); break;
+		}
+		fcvtzs(z, p0/T_m, z);
+		switch (dstType_) {
+		case SG_UINT8:
+			sqxtunb(ZRegH(idx), z);
+			uqxtnb(ZRegB(idx), ZRegH(idx));
+			st1b(z, p, addr);
+			break;
+		case SG_INT8:
+			sqxtnb(ZRegH(idx), z);
+			sqxtnb(ZRegB(idx), ZRegH(idx));
+			st1b(z, p, addr);
+			break;
+		case SG_INT16:
+			sqxtnb(ZRegH(idx), z);
+			st1h(z, p, addr);
+			break;
+		default:
+			st1w(z, p, addr);
+			break;
+		}
+	}
+	// output ZReg(idx) for the i-th unroll
+	void outputOne(const XReg& dst, int i, int idx, const XReg *tmpX = 0)
 	{
 		if (reduceFuncType_ >= 0) {
 			int red = getReduceVarIdx() + i;
-			int src = getTmpIdx(i);
-			gen_reduce(red, src);
-		} else {
+			int src = idx;
 			if (tmpX) {
-				st1w(ZReg(getTmpIdx(0)).s, p1, ptr(dst, *tmpX, LSL, 2));
+				// add only active lanes of the tail
+				assert(reduceFuncType_ == RedSum);
+				if (isDouble()) {
+					fadd(ZRegD(red), p1/T_m, ZRegD(src));
+				} else {
+					fadd(ZRegS(red), p1/T_m, ZRegS(src));
+				}
+			} else {
+				gen_reduce(red, src);
+			}
+		} else {
+			if (isDouble()) {
+				if (tmpX) {
+					st1d(ZReg(idx).d, p1, ptr(dst, *tmpX, LSL, 3));
+				} else {
+					st1d(ZReg(idx).d, p0, ptr(dst, i, MUL_VL));
+				}
 			} else {
-				str(ZReg(getTmpIdx(i)), ptr(dst, i));
+				if (tmpX) {
+					storeDst(ptr(dst, *tmpX, LSL, getShift(getDstByte())), p1, idx, getVarIdx(0));
+				} else {
+					storeDst(ptr(dst, i, MUL_VL), p0, idx, getVarIdx(i));
+				}
 			}
 		}
 	}
+	// caller-saved registers for srcs[] and dsts[]
+	XReg getPtrReg(int i) const
+	{
+		static const int tbl[] = { 7, 8, 9, 10, 11, 12, 13, 14, 16, 17 };
+		if (i >= (int)CYBOZU_NUM_OF_ARRAY(tbl)) throw cybozu::Exception("too many variables and outputs") << i;
+		return XReg(tbl[i]);
+	}
 	void exec(const sg::TokenList& tl)
 	{
 		Label dataL = L();
@@ -81,7 +242,9 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			}
 		}
 		for (uint32_t i = 0; i < constMem_.size(); i++) {
-			dd(constMem_.getVal(i));
+			const uint64_t v = constMem_.getVal(i);
+			dd(uint32_t(v));
+			dd(uint32_t(v >> 32));
 		}
 		if (getSize() > dataSize) {
 			throw cybozu::Exception("bad data size") << getSize();
@@ -90,6 +253,8 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		addr_ = getCurr<void*>();
 		if (opt.break_point) brk(0);
 
+		// params is x2 or x3 (= dataReg_)
+		if (paramN_ > 0) mov(paramReg_, reduceFuncType_ >= 0 ? x2 : x3);
 		adr(dataReg_, dataL);
 #ifdef SG_SVE
 		ptrue(p0.s);
@@ -97,14 +262,21 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		// store regs
 		if (debug) printf("saveRegBegin=%d saveRegEnd=%d totalN_=%d\n", saveRegBegin, saveRegEnd, totalN_);
 		const int saveN = std::min(saveRegEnd, totalN_);
-		for (int i = saveRegBegin; i < saveN; i++) {
-			sub(sp, sp, 64);
-			st1w(ZReg(i).s, p0, ptr(sp));
+		const int saveRegVL = std::max(saveN - saveRegBegin, 0);
+		if (saveRegVL > 0) {
+			addvl(sp, sp, -saveRegVL);
+			for (int i = saveRegBegin; i < saveN; i++) {
+				str(ZReg(i), ptr(sp, i - saveRegBegin, MUL_VL));
+			}
 		}
+		// a predicate register is VL/8 bytes, so one VL keeps eight of them and sp is kept 16-byte aligned
 		const int saveMaskN = funcTmpMask_.getMax();
-		for (int i = savePredBegin; i < saveMaskN; i++) {
-			sub(sp, sp, 16);
-			str(PReg(i).s, ptr(sp));
+		const int savePredVL = (std::max(saveMaskN - savePredBegin, 0) + 7) / 8;
+		if (savePredVL > 0) {
+			addvl(sp, sp, -savePredVL);
+			for (int i = savePredBegin; i < saveMaskN; i++) {
+				str(PReg(i), ptr(sp, i - savePredBegin, MUL_VL));
+			}
 		}
 
 		XReg dst = x0, src = x1, n = x2;
@@ -113,26 +285,66 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			src = x0;
 			n = x1;
 		}
+		// src is srcs[] if srcN_ > 1 and getPtrReg() keeps srcs[1], srcs[2], ...
+		int ptrRegN = 0;
+		std::vector<XReg> srcTbl(srcN_, src);
+		for (int i = 1; i < srcN_; i++) {
+			srcTbl[i] = getPtrReg(ptrRegN++);
+			ldr(srcTbl[i], ptr(src, i * 8));
+		}
+		if (srcN_ > 1) ldr(src, ptr(src));
+		// dst is dsts[] if dstN_ > 1
+		std::vector<XReg> dstTbl(dstN_, dst);
+		for (int i = 1; i < dstN_; i++) {
+			dstTbl[i] = getPtrReg(ptrRegN++);
+			ldr(dstTbl[i], ptr(dst, i * 8));
+		}
+		if (dstN_ > 1) ldr(dst, ptr(dst));
 		gen_setConst();
 		if (reduceFuncType_ >= 0) {
 			LP_(i, unrollN_) {
-				ZRegS red(getReduceVarIdx() + i);
+				ZRegD red(getReduceVarIdx() + i);
 				mov(red, 0);
 			}
 		}
 
+		if (isDouble()) {
+			cntd(stepN_, ALL, MUL, unrollN_);
+		} else {
+			cntw(stepN_, ALL, MUL, unrollN_);
+		}
 		Label skipL, exitL;
 		b(skipL);
 	Label lp = L();
-		LP_(i, unrollN_) ldr(ZReg(getVarIdx(i)), ptr(src, i));
-		add(src, src, 64 * unrollN_);
+		for (int j = 0; j < srcN_; j++) {
+			const XReg& s = srcTbl[j];
+			LP_(i, unrollN_) {
+				if (isDouble()) {
+					ld1d(ZReg(getVarIdx(j, i)).d, p0/T_z, ptr(s, i, MUL_VL));
+				} else {
+					loadSrc(getVarIdx(j, i), p0, ptr(s, i, MUL_VL));
+				}
+			}
+			if (isSrcConv()) {
+				add(s, s, stepN_, LSL, getShift(getSrcByte()));
+			} else {
+				addvl(s, s, unrollN_);
+			}
+		}
 		execOneLoop(tl, unrollN_);
-		LP_(i, unrollN_) outputOne(dst, i);
-		if (reduceFuncType_ < 0) add(dst, dst, 64 * unrollN_);
-		sub(n, n, 16 * unrollN_);
+		for (int k = 0; k < dstN_; k++) {
+			const XReg& d = dstTbl[k];
+			LP_(i, unrollN_) outputOne(d, i, getOutIdx(k, i, unrollN_));
+			if (isDstConv()) {
+				add(d, d, stepN_, LSL, getShift(getDstByte()));
+			} else if (reduceFuncType_ < 0) {
+				addvl(d, d, unrollN_);
+			}
+		}
+		sub(n, n, stepN_);
 	L(skipL);
-		cmp(n, 16 * unrollN_);
-		bge(lp);
+		cmp(n, stepN_);
+		bhs(lp);
 
 		cmp(n, 0);
 		beq(exitL);
@@ -141,12 +353,26 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		mov(loop_i_, 0);
 		b(cond);
 	Label lp2 = L();
-		ld1w(ZReg(getVarIdx(0)).s, p1, ptr(src, loop_i_, LSL, 2));
+		for (int j = 0; j < srcN_; j++) {
+			if (isDouble()) {
+				ld1d(ZReg(getVarIdx(j, 0)).d, p1, ptr(srcTbl[j], loop_i_, LSL, 3));
+			} else {
+				loadSrc(getVarIdx(j, 0), p1, ptr(srcTbl[j], loop_i_, LSL, getShift(getSrcByte())));
+			}
+		}
 		execOneLoop(tl, 1);
-		outputOne(dst, 0, &loop_i_);
-		incw(loop_i_);
+		for (int k = 0; k < dstN_; k++) outputOne(dstTbl[k], 0, getOutIdx(k, 0, 1), &loop_i_);
+		if (isDouble()) {
+			incd(loop_i_);
+		} else {
+			incw(loop_i_);
+		}
 	L(cond);
-		whilelt(p1.s, loop_i_, n);
+		if (isDouble()) {
+			whilelt(p1.d, loop_i_, n);
+		} else {
+			whilelt(p1.s, loop_i_, n);
+		}
 		b_first(lp2);
 	L(exitL);
 
@@ -155,13 +381,17 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		}
 
 		// restore regs
-		for (int i = savePredBegin; i < saveMaskN; i++) {
-			ldr(PReg(saveMaskN + savePredBegin - 1 - i).s, ptr(sp));
-			add(sp, sp, 16);
+		if (savePredVL > 0) {
+			for (int i = savePredBegin; i < saveMaskN; i++) {
+				ldr(PReg(i), ptr(sp, i - savePredBegin, MUL_VL));
+			}
+			addvl(sp, sp, savePredVL);
 		}
-		for (int i = saveRegBegin; i < saveN; i++) {
-			ld1w(ZReg(saveN + saveRegBegin - 1 - i).s, p0, ptr(sp));
-			add(sp, sp, 64);
+		if (saveRegVL > 0) {
+			for (int i = saveRegBegin; i < saveN; i++) {
+				ldr(ZReg(i), ptr(sp, i - saveRegBegin, MUL_VL));
+			}
+			addvl(sp, sp, saveRegVL);
 		}
 		ret();
 		ready();
@@ -190,14 +420,23 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		}
 		return t;
 	}
-	void gen_setInt(int dst, uint32_t u)
+	void gen_setInt(int dst, uint64_t u)
 	{
-#if 0
-		ldr(tmp32_, ptr(dataReg_, getConstOffsetToDataReg(u)));
-		cpy(ZRegS(dst), p0, tmp32_);
-#else
-		ld1rw(ZRegS(dst), p0, ptr(dataReg_, (int)getConstOffsetToDataReg(u)));
-#endif
+		// the offset may exceed the range of the immediate of ld1rw (252)
+		add(tmp64_, dataReg_, getConstOffsetToDataReg(u));
+		if (isDouble()) {
+			ld1rd(ZRegD(dst), p0, ptr(tmp64_));
+		} else {
+			ld1rw(ZRegS(dst), p0, ptr(tmp64_));
+		}
+	}
+	void gen_loadParam(int dst, int i)
+	{
+		if (isDouble()) {
+			ld1rd(ZRegD(dst), p0, ptr(paramReg_, i * 8));
+		} else {
+			ld1rw(ZRegS(dst), p0, ptr(paramReg_, i * 4));
+		}
 	}
 	void setInt(const ZRegS& z, uint32_t u)
 	{
@@ -212,9 +451,21 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			setInt(z, f2u(f));
 		}
 	}
+	// set u to each 64-bit element of z from the data area
+	void setInt64(const ZRegD& z, uint64_t u)
+	{
+		add(tmp64_, dataReg_, getConstOffsetToDataReg(u));
+		ld1rd(z, p0, ptr(tmp64_));
+	}
+	void setDouble(const ZRegD& z, double d)
+	{
+		setInt64(z, d2u(d));
+	}
 	void gen_fullLoad(int dst, uint32_t offset)
 	{
-		ld1w(ZRegS(dst), p0, ptr(dataReg_, int(offset / SimdArray::byteSize)));
+		// the immediate of ld1w is a multiple of VL, so use the byte offset
+		add(tmp64_, dataReg_, offset);
+		ld1w(ZRegS(dst), p0, ptr(tmp64_));
 	}
 	void gen_copy(int dst, int src)
 	{
@@ -222,23 +473,223 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 	}
 	void gen_add(int dst, int src1, int src2)
 	{
-		fadd(ZReg(dst).s, ZReg(src1).s, ZReg(src2).s);
+		if (isDouble()) {
+			fadd(ZReg(dst).d, ZReg(src1).d, ZReg(src2).d);
+		} else {
+			fadd(ZReg(dst).s, ZReg(src1).s, ZReg(src2).s);
+		}
 	}
 	void gen_sub(int dst, int src1, int src2)
 	{
-		fsub(ZReg(dst).s, ZReg(src1).s, ZReg(src2).s);
+		if (isDouble()) {
+			fsub(ZReg(dst).d, ZReg(src1).d, ZReg(src2).d);
+		} else {
+			fsub(ZReg(dst).s, ZReg(src1).s, ZReg(src2).s);
+		}
 	}
 	void gen_mul(int dst, int src1, int src2)
 	{
-		fmul(ZReg(dst).s, ZReg(src1).s, ZReg(src2).s);
+		if (isDouble()) {
+			fmul(ZReg(dst).d, ZReg(src1).d, ZReg(src2).d);
+		} else {
+			fmul(ZReg(dst).s, ZReg(src1).s, ZReg(src2).s);
+		}
 	}
 	void gen_div(int dst, int src1, int src2)
 	{
+		if (dst == src2) {
+			// dst = src1 / dst
+			if (isDouble()) {
+				fdivr(ZReg(dst).d, p0, ZReg(src1).d);
+			} else {
+				fdivr(ZReg(dst).s, p0, ZReg(src1).s);
+			}
+			return;
+		}
 		movprfx(ZReg(dst), ZReg(src1));
-		fdiv(ZReg(dst).s, p0, ZReg(src2).s);
+		if (isDouble()) {
+			fdiv(ZReg(dst).d, p0, ZReg(src2).d);
+		} else {
+			fdiv(ZReg(dst).s, p0, ZReg(src2).s);
+		}
+	}
+	void gen_max(int dst, int src1, int src2)
+	{
+		if (dst == src2) std::swap(src1, src2);
+		if (dst != src1) movprfx(ZReg(dst), ZReg(src1));
+		if (isDouble()) {
+			fmax(ZReg(dst).d, p0, ZReg(src2).d);
+		} else {
+			fmax(ZReg(dst).s, p0, ZReg(src2).s);
+		}
+	}
+	void gen_min(int dst, int src1, int src2)
+	{
+		if (dst == src2) std::swap(src1, src2);
+		if (dst != src1) movprfx(ZReg(dst), ZReg(src1));
+		if (isDouble()) {
+			fmin(ZReg(dst).d, p0, ZReg(src2).d);
+		} else {
+			fmin(ZReg(dst).s, p0, ZReg(src2).s);
+		}
+	}
+	// dst = (neg ? -1 : 1) * src1 * src2 + src3
+	template<class Z>
+	void fmaddT(bool neg, const Z& d, int src1, int src2, int src3)
+	{
+		const int dst = d.getIdx();
+		if (dst == src3) {
+			if (neg) {
+				fmls(d, p0, Z(src1), Z(src2));
+			} else {
+				fmla(d, p0, Z(src1), Z(src2));
+			}
+			return;
+		}
+		if (dst == src2) std::swap(src1, src2);
+		if (dst != src1) movprfx(ZReg(dst), ZReg(src1));
+		if (neg) {
+			fmsb(d, p0, Z(src2), Z(src3));
+		} else {
+			fmad(d, p0, Z(src2), Z(src3));
+		}
+	}
+	void gen_fmadd(int dst, int src1, int src2, int src3)
+	{
+		if (isDouble()) {
+			fmaddT(false, ZRegD(dst), src1, src2, src3);
+		} else {
+			fmaddT(false, ZRegS(dst), src1, src2, src3);
+		}
+	}
+	void gen_fnmadd(int dst, int src1, int src2, int src3)
+	{
+		if (isDouble()) {
+			fmaddT(true, ZRegD(dst), src1, src2, src3);
+		} else {
+			fmaddT(true, ZRegS(dst), src1, src2, src3);
+		}
+	}
+	void gen_abs(int dst, int src)
+	{
+		if (isDouble()) {
+			fabs(ZReg(dst).d, p0, ZReg(src).d);
+		} else {
+			fabs(ZReg(dst).s, p0, ZReg(src).s);
+		}
+	}
+	void gen_copysign(int dst, int x, int y)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const ZRegD t(ftr.allocIdx());
+		const ZRegD sign(getValIdx(-0.0));
+		and_(t, ZRegD(y), sign);
+		bic(ZRegD(dst), ZRegD(x), sign);
+		orr(ZRegD(dst), ZRegD(dst), t);
+	}
+	void gen_sqrt(int dst, int src)
+	{
+		if (isDouble()) {
+			fsqrt(ZReg(dst).d, p0, ZReg(src).d);
+		} else {
+			fsqrt(ZReg(dst).s, p0, ZReg(src).s);
+		}
+	}
+	// frsqrte has only 8 bits and one frsqrts step is applied
+	template<class Z>
+	void rsqrtEstT(const Z& y, const Z& x, const Z& t)
+	{
+		frsqrte(y, x);
+		fmul(t, y, y);
+		frsqrts(t, x, t);
+		fmul(y, y, t);
+	}
+	void gen_rsqrtEst(int dst, int src)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = ftr.allocIdx();
+		if (isDouble()) {
+			rsqrtEstT(ZRegD(dst), ZRegD(src), ZRegD(t));
+		} else {
+			rsqrtEstT(ZRegS(dst), ZRegS(src), ZRegS(t));
+		}
+	}
+	template<class P, class Z>
+	void cmpT(int cmp, const P& k, const Z& a, const Z& b)
+	{
+		switch (cmp) {
+		case CmpEq: fcmeq(k, p0, a, b); break;
+		case CmpNeq: fcmne(k, p0, a, b); break;
+		case CmpLt: fcmgt(k, p0, b, a); break;
+		case CmpLe: fcmge(k, p0, b, a); break;
+		case CmpGt: fcmgt(k, p0, a, b); break;
+		case CmpGe: fcmge(k, p0, a, b); break;
+		default:
+			throw cybozu::Exception("bad cmp") << cmp;
+		}
+	}
+	void gen_cmpSelect(int dst, int cmp, int src1, int src2, int x, int y)
+	{
+		IndexRangeManager ftm(funcTmpMask_);
+		const int k = ftm.allocIdx();
+		if (isDouble()) {
+			cmpT(cmp, PRegD(k), ZReg(src1).d, ZReg(src2).d);
+			sel(ZReg(dst).d, PReg(k), ZReg(x).d, ZReg(y).d);
+		} else {
+			cmpT(cmp, PRegS(k), ZReg(src1).s, ZReg(src2).s);
+			sel(ZReg(dst).s, PReg(k), ZReg(x).s, ZReg(y).s);
+		}
+	}
+	template<class Z>
+	void roundT(const Z& d, const Z& s, int mode)
+	{
+		switch (mode) {
+		case RoundEven: frintn(d, p0, s); break;
+		case RoundDown: frintm(d, p0, s); break;
+		case RoundUp: frintp(d, p0, s); break;
+		case RoundZero: frintz(d, p0, s); break;
+		default:
+			throw cybozu::Exception("bad round mode") << mode;
+		}
+	}
+	void gen_round(int dst, int src, int mode)
+	{
+		if (isDouble()) {
+			roundT(ZRegD(dst), ZRegD(src), mode);
+		} else {
+			roundT(ZRegS(dst), ZRegS(src), mode);
+		}
+	}
+	void gen_beginSkip(int cmp, int src1, int src2)
+	{
+		IndexRangeManager ftm(funcTmpMask_);
+		const int k = ftm.allocIdx();
+		if (funcTmpReg_.seekMode_) return;
+		if (isDouble()) {
+			cmpT(cmp, PRegD(k), ZReg(src1).d, ZReg(src2).d);
+		} else {
+			cmpT(cmp, PRegS(k), ZReg(src1).s, ZReg(src2).s);
+		}
+		ptest(p0, PReg(k).b);
+		skipL_.push_back(Label());
+		b_none(skipL_.back());
+	}
+	void gen_endSkip()
+	{
+		if (funcTmpReg_.seekMode_) return;
+		L(skipL_.back());
+		skipL_.pop_back();
+	}
+	void resetCode()
+	{
+		setSize(0);
 	}
 	void gen_neg(int inout, int n)
 	{
+		if (isDouble()) {
+			LP_(i, n) fneg(ZRegD(inout + i), p0, ZRegD(inout + i));
+			return;
+		}
 		IndexRangeManager ftr(funcTmpReg_);
 		const ZRegSVec t = getInputRegVec(inout, n);
 		const ZRegS sign(ftr.allocIdx());
@@ -247,6 +698,10 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 	}
 	void gen_inv(int inout, int n)
 	{
+		if (isDouble()) {
+			gen_invD(inout, n);
+			return;
+		}
 		IndexRangeManager ftr(funcTmpReg_);
 		const ZRegSVec t0 = getInputRegVec(inout, n);
 		const ZRegSVec t1 = getTmpRegVec(ftr, n);
@@ -261,6 +716,19 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 	}
 	void gen_exp(int inout, int n)
 	{
+		gen_expCore(inout, n, false);
+	}
+	void gen_exp2(int inout, int n)
+	{
+		gen_expCore(inout, n, true);
+	}
+	// inout = exp(inout) or 2^inout if isExp2
+	void gen_expCore(int inout, int n, bool isExp2)
+	{
+		if (isDouble()) {
+			gen_expD(inout, n, isExp2);
+			return;
+		}
 		IndexRangeManager ftr(funcTmpReg_);
 		const ZRegSVec t0 = getInputRegVec(inout, n);
 		const ZRegSVec t1 = getTmpRegVec(ftr, n);
@@ -270,10 +738,15 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			const ZRegS c1(ftr.allocIdx());
 			const ZRegS c2(ftr.allocIdx());
 
-	//		fmin(t0, p0, expMax.s);
-	//		fmax(t0, p0, expMin.s);
-			setFloat(c1, g_expTbl.log2_e);
-			LP_(i, n) fmul(t0[i], t0[i], c1);
+			if (!isExp2) {
+				setFloat(c1, g_expTbl.log2_e);
+				LP_(i, n) fmul(t0[i], t0[i], c1);
+			}
+			// clamp x before floor to avoid inf - inf ; fmax/fmin keep NaN
+			setFloat(c1, g_expTbl.minX);
+			LP_(i, n) fmax(t0[i], p0, c1);
+			setFloat(c1, g_expTbl.maxX);
+			LP_(i, n) fmin(t0[i], p0, c1);
 			LP_(i, n) {
 				movprfx(t1[i], p0, t0[i]); // clear implicit dependency
 				frintm(t1[i], p0, t0[i]); // floor : float -> float
@@ -299,15 +772,20 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			LP_(i, n) fmad(t0[i], p0, t2[i], c1);
 			LP_(i, n) fmul(t0[i], t1[i], t0[i]);
 		} else {
-			const ZRegS log2_e(getFloatIdx(g_expTbl.log2_e));
 			const ZRegD not_mask17(getFloatIdx(u2f(g_expTbl.not_mask17)));
 			const ZRegS one(getFloatIdx(1.0));
 			const ZRegS coeff1(getFloatIdx(g_expTbl.coeff1));
 			const ZRegS coeff2(getFloatIdx(g_expTbl.coeff2));
+			const ZRegS minX(getFloatIdx(g_expTbl.minX));
+			const ZRegS maxX(getFloatIdx(g_expTbl.maxX));
 
-	//		fmin(t0, p0, expMax.s);
-	//		fmax(t0, p0, expMin.s);
-			LP_(i, n) fmul(t0[i], t0[i], log2_e);
+			if (!isExp2) {
+				const ZRegS log2_e(getFloatIdx(g_expTbl.log2_e));
+				LP_(i, n) fmul(t0[i], t0[i], log2_e);
+			}
+			// clamp x before floor to avoid inf - inf ; fmax/fmin keep NaN
+			LP_(i, n) fmax(t0[i], p0, minX);
+			LP_(i, n) fmin(t0[i], p0, maxX);
 			LP_(i, n) {
 				movprfx(t1[i], p0, t0[i]); // clear implicit dependency
 				frintm(t1[i], p0, t0[i]); // floor : float -> float
@@ -330,22 +808,46 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 	}
 	void gen_cosh(int inout, int n)
 	{
-		const ZRegSVec t0 = getInputRegVec(inout, n);
+		if (isDouble()) {
+			gen_coshD(inout, n);
+			return;
+		}
 		/*
-			X = exp(|x|)
-			cosh(x) = (X + 1/X) * 0.5
+			X = exp(|x| - h) for h = log(2) rounded to 9 bits to avoid the overflow of exp(|x|)
+			cosh(x) = k (X + (1/4k^2)/X) for k = exp(h)/2
+			1/X is computed for min(X, FLT_MAX) as x64
 		*/
+		const double h = 0.693359375;
+		const double k = std::exp(h) * 0.5;
+		const ZRegS fh(getFloatIdx(float(h)));
+		const ZRegS fk(getFloatIdx(float(k)));
+		const ZRegS fk2(getFloatIdx(float(0.25 / (k * k))));
+		const ZRegS fltMax(getFloatIdx(FLT_MAX));
+		const ZRegSVec t0 = getInputRegVec(inout, n);
 		LP_(i, n) fabs(t0[i], p0, t0[i]);
+		LP_(i, n) fsub(t0[i], t0[i], fh);
 		gen_exp(inout, n);
 		IndexRangeManager ftr(funcTmpReg_);
 		const ZRegSVec t1 = getTmpRegVec(ftr, n);
-		LP_(i, n) mov(t1[i], p0, t0[i]);
+		LP_(i, n) {
+			movprfx(t1[i], p0, t0[i]);
+			fmin(t1[i], p0, fltMax);
+		}
 		gen_inv(t1[0].getIdx(), n);
-		LP_(i, n) fadd(t0[i], t0[i], t1[i]);
-		LP_(i, n) fmul(t0[i], p0, 0.5);
+		LP_(i, n) fmla(t0[i], p0, t1[i], fk2);
+		LP_(i, n) fmul(t0[i], t0[i], fk);
 	}
 	void gen_log(int inout, int n)
 	{
+		gen_logBase(inout, n, LogBaseE);
+	}
+	void gen_logBase(int inout, int n, int base)
+	{
+		if (isDouble()) {
+			gen_logD(inout, n, base);
+			return;
+		}
+		const double m = getLogScale(base);
 		const int logN = LogTbl::N;
 		ZRegSVec tbl;
 		int offset = 0;
@@ -384,15 +886,15 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			setFloat(c2, 1.0f);
 			// fnmsb(a, b, c) = a * b - c
 			LP_(i, n) fnmsb(t0[i], p0, c1, c2);
-			setFloat(c1, log(1.5f));
-			setFloat(c2, log(2.0f));
+			setFloat(c1, float(std::log(1.5) * m));
+			setFloat(c2, float(std::log(2.0) * m));
 			LP_(i, n) fmad(t1[i], p0, c2, c1);
 		} else {
 			const ZRegS i127shl23(getConstIdx(127 << 23));
 			const ZRegS x7fffff(getConstIdx(0x7fffff));
-			const ZRegS log2(getFloatIdx(g_logTbl.log2));
+			const ZRegS log2(getFloatIdx(float(std::log(2.0) * m)));
 			const ZRegS f2div3(getFloatIdx(g_logTbl.f2div3));
-			const ZRegS log1p5(getFloatIdx(g_logTbl.log1p5));
+			const ZRegS log1p5(getFloatIdx(float(std::log(1.5) * m)));
 			const ZRegS one(getFloatIdx(1.0));
 			LP_(i, n) sub(t1[i], t0[i], i127shl23);
 			LP_(i, n) asr(t1[i], t1[i], 23);
@@ -443,6 +945,11 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 				LP_(i, n) fmad(t2[i], p0, t0[i], tbl[j]);
 			}
 		}
+		if (base != LogBaseE) {
+			IndexRangeManager ftr2(funcTmpReg_);
+			const ZRegS c(getValTmpIdx(ftr2, m));
+			LP_(i, n) fmul(t2[i], t2[i], c);
+		}
 		// a * x + e
 		LP_(i, n) fmad(t0[i], p0, t2[i], t1[i]);
 	}
@@ -463,9 +970,152 @@ printf("idx=%d\n", getConstTblIdx(tbl, sizeof(tbl)));
 		LP_(i, n) mov(t0[i], p0, t);
 #endif
 	}
-	void gen_tanh(int inout, int n)
+	/*
+		functions for double (see ExpTblD and LogTblD)
+	*/
+	ZRegDVec getInputRegVecD(int pos, int n)
+	{
+		ZRegDVec t;
+		for (int i = 0; i < n; i++) {
+			t.push_back(ZRegD(pos + i));
+		}
+		return t;
+	}
+	ZRegDVec getTmpRegVecD(IndexRangeManager& irm, int n)
 	{
-		throw cybozu::Exception("not support gen_tanh") << inout << n;
+		ZRegDVec t;
+		for (int i = 0; i < n; i++) {
+			t.push_back(ZRegD(irm.allocIdx()));
+		}
+		return t;
+	}
+	void gen_invD(int inout, int n)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const ZRegDVec t0 = getInputRegVecD(inout, n);
+		const ZRegD one(ftr.allocIdx());
+		fmov(one, 1.0);
+		LP_(i, n) fdivr(t0[i], p0, one); // one / t0
+	}
+	void gen_expD(int inout, int n, bool isExp2)
+	{
+		const int expN = ExpTblD::N;
+		IndexRangeManager ftr(funcTmpReg_);
+		const ZRegDVec t0 = getInputRegVecD(inout, n);
+		const ZRegDVec t1 = getTmpRegVecD(ftr, n);
+		const ZRegDVec t2 = getTmpRegVecD(ftr, n);
+		const ZRegD c(ftr.allocIdx());
+
+		// clamp x before the reduction to avoid inf - inf ; fmax/fmin keep NaN
+		const double scale = isExp2 ? g_expTblD.log2_e : 1.0;
+		setDouble(c, g_expTblD.minX * scale);
+		LP_(i, n) fmax(t0[i], p0, c);
+		setDouble(c, g_expTblD.maxX * scale);
+		LP_(i, n) fmin(t0[i], p0, c);
+		if (isExp2) {
+			LP_(i, n) frintn(t1[i], p0, t0[i]); // n = round(x)
+			LP_(i, n) fsub(t0[i], t0[i], t1[i]);
+			setDouble(c, std::log(2.0));
+			LP_(i, n) fmul(t0[i], t0[i], c); // a = (x - n) log(2)
+		} else {
+			setDouble(c, g_expTblD.log2_e);
+			LP_(i, n) fmul(t1[i], t0[i], c);
+			LP_(i, n) frintn(t1[i], p0, t1[i]); // n = round(x/log(2))
+			setDouble(c, g_expTblD.ln2_hi);
+			LP_(i, n) fmls(t0[i], p0, t1[i], c);
+			setDouble(c, g_expTblD.ln2_lo);
+			LP_(i, n) fmls(t0[i], p0, t1[i], c); // a = x - n log(2)
+		}
+		setDouble(c, g_expTblD.coef[expN - 1]);
+		LP_(i, n) mov(t2[i], p0, c);
+		for (int j = expN - 2; j >= 0; j--) {
+			setDouble(c, g_expTblD.coef[j]);
+			LP_(i, n) fmad(t2[i], p0, t0[i], c);
+		}
+		LP_(i, n) fcvtzs(t1[i], p0, t1[i]);
+		LP_(i, n) fscale(t2[i], p0, t1[i]); // t2 * 2^n
+		LP_(i, n) mov(t0[i], p0, t2[i]);
+	}
+	// cosh(x) = k (X + (1/4k^2)/X) for X = exp(|x| - h) (see gen_cosh)
+	void gen_coshD(int inout, int n)
+	{
+		const double h = 0.693359375;
+		const double k = std::exp(h) * 0.5;
+		const ZRegDVec t0 = getInputRegVecD(inout, n);
+		IndexRangeManager ftr(funcTmpReg_);
+		const ZRegDVec t1 = getTmpRegVecD(ftr, n);
+		const ZRegD c(ftr.allocIdx());
+		setDouble(c, h);
+		LP_(i, n) fabs(t0[i], p0, t0[i]);
+		LP_(i, n) fsub(t0[i], t0[i], c);
+		gen_expD(inout, n, false);
+		setDouble(c, 0.25 / (k * k));
+		LP_(i, n) {
+			mov(t1[i], p0, t0[i]);
+			fdivr(t1[i], p0, c); // c / X
+		}
+		LP_(i, n) fadd(t0[i], t0[i], t1[i]);
+		setDouble(c, k);
+		LP_(i, n) fmul(t0[i], t0[i], c);
+	}
+	/*
+		log_b(x) = (f - (hfsq - s(hfsq + R))) m + k log_b(2) for base b != e
+		m = 1/log(b) (see getLogScale)
+	*/
+	void gen_logD(int inout, int n, int base)
+	{
+		const int logN = LogTblD::N;
+		IndexRangeManager ftr(funcTmpReg_);
+		const ZRegDVec t0 = getInputRegVecD(inout, n);
+		const ZRegDVec t1 = getTmpRegVecD(ftr, n);
+		const ZRegDVec t2 = getTmpRegVecD(ftr, n);
+		const ZRegDVec t3 = getTmpRegVecD(ftr, n);
+		const ZRegDVec t4 = getTmpRegVecD(ftr, n);
+		const ZRegD c(ftr.allocIdx());
+
+		setInt64(c, g_logTblD.sqrt1_2);
+		LP_(i, n) sub(t1[i], t0[i], c);
+		setInt64(c, g_logTblD.expMask);
+		LP_(i, n) and_(t1[i], t1[i], c); // k << 52
+		LP_(i, n) sub(t0[i], t0[i], t1[i]); // z
+		LP_(i, n) lsr(t1[i], t1[i], 52);
+		setInt64(c, g_logTblD.kMagic);
+		LP_(i, n) eor(t1[i], t1[i], c);
+		setDouble(c, g_logTblD.kMagicD);
+		LP_(i, n) fsub(t1[i], t1[i], c); // k
+		fmov(c, 1.0);
+		LP_(i, n) fsub(t0[i], t0[i], c); // f = z - 1
+		fmov(c, 2.0);
+		LP_(i, n) fadd(t2[i], t0[i], c);
+		LP_(i, n) fdivr(t2[i], p0, t0[i]); // s = f/(2 + f)
+		LP_(i, n) fmul(t3[i], t2[i], t2[i]); // s^2
+		setDouble(c, g_logTblD.coef[logN - 1]);
+		LP_(i, n) mov(t4[i], p0, c);
+		for (int j = logN - 2; j >= 0; j--) {
+			setDouble(c, g_logTblD.coef[j]);
+			LP_(i, n) fmad(t4[i], p0, t3[i], c);
+		}
+		LP_(i, n) fmul(t3[i], t3[i], t4[i]); // R
+		LP_(i, n) fmul(t4[i], t0[i], t0[i]);
+		LP_(i, n) fmul(t4[i], p0, 0.5); // hfsq = f^2/2
+		LP_(i, n) fadd(t3[i], t3[i], t4[i]);
+		LP_(i, n) fmul(t3[i], t3[i], t2[i]); // s(hfsq + R)
+		if (base != LogBaseE) {
+			const double m = getLogScale(base);
+			LP_(i, n) fsub(t4[i], t4[i], t3[i]);
+			LP_(i, n) fsub(t0[i], t0[i], t4[i]); // f - (hfsq - s(hfsq + R))
+			setDouble(c, m);
+			LP_(i, n) fmul(t0[i], t0[i], c);
+			setDouble(c, std::log(2.0) * m);
+			LP_(i, n) fmla(t0[i], p0, t1[i], c); // + k log_b(2)
+			return;
+		}
+		setDouble(c, g_logTblD.ln2_lo);
+		LP_(i, n) fmla(t3[i], p0, t1[i], c); // s(hfsq + R) + k ln2_lo
+		LP_(i, n) fsub(t4[i], t4[i], t3[i]);
+		LP_(i, n) fsub(t0[i], t0[i], t4[i]); // f - (hfsq - (s(hfsq + R) + k ln2_lo))
+		setDouble(c, g_logTblD.ln2_hi);
+		LP_(i, n) fmla(t0[i], p0, t1[i], c); // + k ln2_hi
 	}
 };
 
@@ -0,0 +1,591 @@
+#pragma once
+#include <xbyak_aarch64/xbyak_aarch64.h>
+#include <simdgen/simdgen.h>
+#include <cybozu/exception.hpp>
+#include <cmath>
+#include <list>
+#include "const.hpp"
+
+using namespace Xbyak_aarch64;
+
+typedef std::vector<VReg4S> VReg4SVec;
+
+namespace sg {
+
+/*
+	free : v0, ..., v7, v16, ..., v31
+	save : v8, ..., v15
+*/
+static const int saveRegBegin = 8;
+static const int saveRegEnd = 16;
+
+struct Generator : CodeGenerator, sg::GeneratorBase {
+	static const size_t dataSize = 4096;
+	static const size_t minCodeSize = 8192;
+	static const size_t maxCodeSize = 1 << 20;
+	size_t codeSize_; // SgGetFuncAddr doubles it if the code is too big
+	XReg dataReg_;
+	XReg tmp64_;
+	WReg tmp32_;
+	XReg loop_i_;
+	XReg paramReg_; // params given as the last argument
+	std::list<Label> skipL_; // labels for gen_beginSkip/gen_endSkip
+
+	explicit Generator(size_t codeSize = minCodeSize)
+		: CodeGenerator(dataSize + codeSize)
+		, codeSize_(codeSize)
+		, dataReg_(x3)
+		, tmp64_(x4)
+		, tmp32_(w4)
+		, loop_i_(x5)
+		, paramReg_(x15)
+	{
+		simdByte_ = 128 / 8;
+		maxSimdRegN_ = 32;
+		onlyFloat_ = true;
+	}
+	bool isCodeSizeError(const std::exception& e) const
+	{
+		const Xbyak_aarch64::Error *p = dynamic_cast<const Xbyak_aarch64::Error*>(&e);
+		return p != 0 && int(*p) == ERR_CODE_IS_TOO_BIG;
+	}
+	static VReg16B b16(const VReg4S& v) { return VReg16B(v.getIdx()); }
+	// x[0] = sum(s[0:...3])
+	void reduceOne_sum(int d, int s)
+	{
+		assert(d != s);
+		faddp(VReg4S(s), VReg4S(s), VReg4S(s));
+		faddp(SReg(d), VReg2S(s));
+	}
+	// output QReg(idx) for the i-th unroll
+	void outputOne(const XReg& dst, int i, int idx)
+	{
+		if (reduceFuncType_ >= 0) {
+			int red = getReduceVarIdx() + i;
+			gen_reduce(red, idx);
+		} else {
+			str(QReg(idx), ptr(dst, i * simdByte_));
+		}
+	}
+	/*
+		output the first n (< 4) elements of VReg4S(idx) via the buffer [sp, sp + 16)
+	*/
+	void outputTail(const XReg& dst, const XReg& n, int idx)
+	{
+		const VReg4S t(idx);
+		str(QReg(t.getIdx()), ptr(sp));
+		if (reduceFuncType_ >= 0) {
+			// clear unused elements
+			Label lp, cond;
+			mov(loop_i_, n);
+			b(cond);
+		L(lp);
+			str(wzr, ptr(sp, loop_i_, LSL, 2));
+			add(loop_i_, loop_i_, 1);
+		L(cond);
+			cmp(loop_i_, 4);
+			blt(lp);
+			ldr(QReg(t.getIdx()), ptr(sp));
+			gen_reduce(getReduceVarIdx(), t.getIdx());
+		} else {
+			Label lp;
+			mov(loop_i_, 0);
+		L(lp);
+			ldr(tmp32_, ptr(sp, loop_i_, LSL, 2));
+			str(tmp32_, ptr(dst, loop_i_, LSL, 2));
+			add(loop_i_, loop_i_, 1);
+			cmp(loop_i_, n);
+			blt(lp);
+		}
+	}
+	// caller-saved registers for srcs[] and dsts[]
+	XReg getPtrReg(int i) const
+	{
+		static const int tbl[] = { 7, 8, 9, 10, 11, 12, 13, 14, 16, 17 };
+		if (i >= (int)CYBOZU_NUM_OF_ARRAY(tbl)) throw cybozu::Exception("too many variables and outputs") << i;
+		return XReg(tbl[i]);
+	}
+	void exec(const sg::TokenList& tl)
+	{
+		if (isDouble()) throw cybozu::Exception("double is not supported on NEON");
+		if (isSrcConv() || isDstConv()) throw cybozu::Exception("only float is supported on NEON");
+		Label dataL = L();
+		detectUnrollN(tl);
+		setSize(0);
+		for (uint32_t i = 0; i < constTblMem_.size(); i++) {
+			const SimdArray& v = constTblMem_.getVal(i);
+			for (size_t j = 0; j < v.N; j++) {
+				dd(v.get32bit(j));
+			}
+		}
+		for (uint32_t i = 0; i < constMem_.size(); i++) {
+			const uint64_t v = constMem_.getVal(i);
+			dd(uint32_t(v));
+			dd(uint32_t(v >> 32));
+		}
+		if (getSize() > dataSize) {
+			throw cybozu::Exception("bad data size") << getSize();
+		}
+		setSize(dataSize);
+		addr_ = getCurr<void*>();
+		if (opt.break_point) brk(0);
+
+		// params is x2 or x3 (= dataReg_)
+		if (paramN_ > 0) mov(paramReg_, reduceFuncType_ >= 0 ? x2 : x3);
+		adr(dataReg_, dataL);
+		// store regs
+		if (debug) printf("saveRegBegin=%d saveRegEnd=%d totalN_=%d\n", saveRegBegin, saveRegEnd, totalN_);
+		const int saveN = std::min(saveRegEnd, totalN_);
+		for (int i = saveRegBegin; i < saveN; i++) {
+			sub(sp, sp, 16);
+			str(QReg(i), ptr(sp));
+		}
+		// buffer for the remaining elements
+		sub(sp, sp, 16);
+
+		XReg dst = x0, src = x1, n = x2;
+		if (reduceFuncType_ >= 0) {
+			// dst is not used
+			src = x0;
+			n = x1;
+		}
+		// src is srcs[] if srcN_ > 1 and getPtrReg() keeps srcs[1], srcs[2], ...
+		int ptrRegN = 0;
+		std::vector<XReg> srcTbl(srcN_, src);
+		for (int i = 1; i < srcN_; i++) {
+			srcTbl[i] = getPtrReg(ptrRegN++);
+			ldr(srcTbl[i], ptr(src, i * 8));
+		}
+		if (srcN_ > 1) ldr(src, ptr(src));
+		// dst is dsts[] if dstN_ > 1
+		std::vector<XReg> dstTbl(dstN_, dst);
+		for (int i = 1; i < dstN_; i++) {
+			dstTbl[i] = getPtrReg(ptrRegN++);
+			ldr(dstTbl[i], ptr(dst, i * 8));
+		}
+		if (dstN_ > 1) ldr(dst, ptr(dst));
+		gen_setConst();
+		if (reduceFuncType_ >= 0) {
+			LP_(i, unrollN_) {
+				const VReg16B red(getReduceVarIdx() + i);
+				eor(red, red, red);
+			}
+		}
+
+		const int elemN = simdByte_ / 4;
+		Label skipL, exitL;
+		b(skipL);
+	Label lp = L();
+		for (int j = 0; j < srcN_; j++) {
+			LP_(i, unrollN_) ldr(QReg(getVarIdx(j, i)), ptr(srcTbl[j], i * simdByte_));
+			add(srcTbl[j], srcTbl[j], simdByte_ * unrollN_);
+		}
+		execOneLoop(tl, unrollN_);
+		for (int k = 0; k < dstN_; k++) {
+			LP_(i, unrollN_) outputOne(dstTbl[k], i, getOutIdx(k, i, unrollN_));
+			if (reduceFuncType_ < 0) add(dstTbl[k], dstTbl[k], simdByte_ * unrollN_);
+		}
+		sub(n, n, elemN * unrollN_);
+	L(skipL);
+		cmp(n, elemN * unrollN_);
+		bge(lp);
+
+		if (unrollN_ > 1) {
+			Label skip2L;
+			b(skip2L);
+		Label lp2 = L();
+			for (int j = 0; j < srcN_; j++) {
+				ldr(QReg(getVarIdx(j, 0)), ptr(srcTbl[j]));
+				add(srcTbl[j], srcTbl[j], simdByte_);
+			}
+			execOneLoop(tl, 1);
+			for (int k = 0; k < dstN_; k++) {
+				outputOne(dstTbl[k], 0, getOutIdx(k, 0, 1));
+				if (reduceFuncType_ < 0) add(dstTbl[k], dstTbl[k], simdByte_);
+			}
+			sub(n, n, elemN);
+		L(skip2L);
+			cmp(n, elemN);
+			bge(lp2);
+		}
+
+		cbz(n, exitL);
+		{
+			// copy the remaining elements to the buffer
+			for (int j = 0; j < srcN_; j++) {
+				stp(xzr, xzr, ptr(sp));
+				Label lp3;
+				mov(loop_i_, 0);
+			L(lp3);
+				ldr(tmp32_, ptr(srcTbl[j], loop_i_, LSL, 2));
+				str(tmp32_, ptr(sp, loop_i_, LSL, 2));
+				add(loop_i_, loop_i_, 1);
+				cmp(loop_i_, n);
+				blt(lp3);
+				ldr(QReg(getVarIdx(j, 0)), ptr(sp));
+			}
+			execOneLoop(tl, 1);
+			for (int k = 0; k < dstN_; k++) outputTail(dstTbl[k], n, getOutIdx(k, 0, 1));
+		}
+	L(exitL);
+
+		if (reduceFuncType_ >= 0) {
+			reduceAll();
+		}
+
+		add(sp, sp, 16);
+		// restore regs
+		for (int i = saveRegBegin; i < saveN; i++) {
+			ldr(QReg(saveN + saveRegBegin - 1 - i), ptr(sp));
+			add(sp, sp, 16);
+		}
+		ret();
+		ready();
+	}
+	VReg4SVec getInputRegVec(int pos, int n)
+	{
+		VReg4SVec t;
+		for (int i = 0; i < n; i++) {
+			t.push_back(VReg4S(pos + i));
+		}
+		return t;
+	}
+	VReg4SVec getTmpRegVec(IndexRangeManager& irm, int n)
+	{
+		VReg4SVec t;
+		for (int i = 0; i < n; i++) {
+			t.push_back(VReg4S(irm.allocIdx()));
+		}
+		return t;
+	}
+	void gen_setInt(int dst, uint64_t u)
+	{
+		add(tmp64_, dataReg_, getConstOffsetToDataReg(u));
+		ld1r(VReg4S(dst), ptr(tmp64_));
+	}
+	void gen_loadParam(int dst, int i)
+	{
+		add(tmp64_, paramReg_, i * 4);
+		ld1r(VReg4S(dst), ptr(tmp64_));
+	}
+	void setInt(const VReg4S& z, uint32_t u)
+	{
+		mov(tmp32_, u);
+		dup(z, tmp32_);
+	}
+	void setFloat(const VReg4S& z, float f)
+	{
+		setInt(z, f2u(f));
+	}
+	void gen_fullLoad(int dst, uint32_t offset)
+	{
+		ldr(QReg(dst), ptr(dataReg_, offset));
+	}
+	void gen_copy(int dst, int src)
+	{
+		mov(VReg16B(dst), VReg16B(src));
+	}
+	void gen_add(int dst, int src1, int src2)
+	{
+		fadd(VReg4S(dst), VReg4S(src1), VReg4S(src2));
+	}
+	void gen_sub(int dst, int src1, int src2)
+	{
+		fsub(VReg4S(dst), VReg4S(src1), VReg4S(src2));
+	}
+	void gen_mul(int dst, int src1, int src2)
+	{
+		fmul(VReg4S(dst), VReg4S(src1), VReg4S(src2));
+	}
+	void gen_div(int dst, int src1, int src2)
+	{
+		fdiv(VReg4S(dst), VReg4S(src1), VReg4S(src2));
+	}
+	void gen_max(int dst, int src1, int src2)
+	{
+		fmax(VReg4S(dst), VReg4S(src1), VReg4S(src2));
+	}
+	void gen_min(int dst, int src1, int src2)
+	{
+		fmin(VReg4S(dst), VReg4S(src1), VReg4S(src2));
+	}
+	// dst = (neg ? -1 : 1) * src1 * src2 + src3
+	void fmaddT(bool neg, int dst, int src1, int src2, int src3)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		// use a tmp register if dst is a multiplicand and not the addend
+		const int idx = (dst != src3 && (dst == src1 || dst == src2)) ? ftr.allocIdx() : dst;
+		const VReg4S d(idx);
+		if (idx != src3) mov(b16(d), VReg16B(src3));
+		if (neg) {
+			fmls(d, VReg4S(src1), VReg4S(src2));
+		} else {
+			fmla(d, VReg4S(src1), VReg4S(src2));
+		}
+		if (idx != dst) mov(VReg16B(dst), b16(d));
+	}
+	void gen_fmadd(int dst, int src1, int src2, int src3)
+	{
+		fmaddT(false, dst, src1, src2, src3);
+	}
+	void gen_fnmadd(int dst, int src1, int src2, int src3)
+	{
+		fmaddT(true, dst, src1, src2, src3);
+	}
+	void gen_abs(int dst, int src)
+	{
+		fabs(VReg4S(dst), VReg4S(src));
+	}
+	void gen_copysign(int dst, int x, int y)
+	{
+		const VReg16B sign(getValIdx(-0.0));
+		if (dst == y) {
+			// insert the bits of x other than the sign
+			bif(VReg16B(dst), VReg16B(x), sign);
+		} else {
+			if (dst != x) mov(VReg16B(dst), VReg16B(x));
+			bit(VReg16B(dst), VReg16B(y), sign);
+		}
+	}
+	void gen_sqrt(int dst, int src)
+	{
+		fsqrt(VReg4S(dst), VReg4S(src));
+	}
+	// frsqrte has only 8 bits and one frsqrts step is applied
+	void gen_rsqrtEst(int dst, int src)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4S y(dst);
+		const VReg4S x(src);
+		const VReg4S t(ftr.allocIdx());
+		frsqrte(y, x);
+		fmul(t, y, y);
+		frsqrts(t, x, t);
+		fmul(y, y, t);
+	}
+	// m = (src1 cmp src2) ? ~0 : 0
+	void cmpMask(const VReg4S& m, int cmp, int src1, int src2)
+	{
+		const VReg4S a(src1);
+		const VReg4S b(src2);
+		switch (cmp) {
+		case CmpEq: fcmeq(m, a, b); break;
+		case CmpNeq: fcmeq(m, a, b); mvn(b16(m), b16(m)); break;
+		case CmpLt: fcmgt(m, b, a); break;
+		case CmpLe: fcmge(m, b, a); break;
+		case CmpGt: fcmgt(m, a, b); break;
+		case CmpGe: fcmge(m, a, b); break;
+		default:
+			throw cybozu::Exception("bad cmp") << cmp;
+		}
+	}
+	void gen_cmpSelect(int dst, int cmp, int src1, int src2, int x, int y)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4S m(ftr.allocIdx());
+		cmpMask(m, cmp, src1, src2);
+		bsl(b16(m), VReg16B(x), VReg16B(y)); // m = m ? x : y
+		mov(VReg16B(dst), b16(m));
+	}
+	void gen_round(int dst, int src, int mode)
+	{
+		const VReg4S d(dst);
+		const VReg4S s(src);
+		switch (mode) {
+		case RoundEven: frintn(d, s); break;
+		case RoundDown: frintm(d, s); break;
+		case RoundUp: frintp(d, s); break;
+		case RoundZero: frintz(d, s); break;
+		default:
+			throw cybozu::Exception("bad round mode") << mode;
+		}
+	}
+	void gen_beginSkip(int cmp, int src1, int src2)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4S m(ftr.allocIdx());
+		if (funcTmpReg_.seekMode_) return;
+		cmpMask(m, cmp, src1, src2);
+		umaxv(SReg(m.getIdx()), m);
+		fmov(tmp32_, SReg(m.getIdx()));
+		skipL_.push_back(Label());
+		cbz(tmp32_, skipL_.back());
+	}
+	void gen_endSkip()
+	{
+		if (funcTmpReg_.seekMode_) return;
+		L(skipL_.back());
+		skipL_.pop_back();
+	}
+	void resetCode()
+	{
+		setSize(0);
+	}
+	void gen_neg(int inout, int n)
+	{
+		const VReg4SVec t = getInputRegVec(inout, n);
+		LP_(i, n) fneg(t[i], t[i]);
+	}
+	void gen_inv(int inout, int n)
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4SVec t0 = getInputRegVec(inout, n);
+		const VReg4SVec t1 = getTmpRegVec(ftr, n);
+		const VReg4SVec t2 = getTmpRegVec(ftr, n);
+
+		LP_(i, n) frecpe(t1[i], t0[i]);
+		LP_(i, n) frecps(t2[i], t0[i], t1[i]);
+		LP_(i, n) fmul(t1[i], t1[i], t2[i]);
+
+		LP_(i, n) frecps(t2[i], t0[i], t1[i]);
+		LP_(i, n) fmul(t0[i], t1[i], t2[i]);
+	}
+	/*
+		t2 = c[N-1]
+		t2 = t2 * x + c[j] for j = N-2, ..., 0
+		t2 and t3 are swapped in each step because fmla accumulates into the destination
+	*/
+	void gen_horner(VReg4SVec& t2, VReg4SVec& t3, const VReg4SVec& x, const float *c, int N, int n)
+	{
+		LP_(i, n) mov(b16(t2[i]), b16(VReg4S(getFloatIdx(c[N - 1]))));
+		for (int j = N - 2; j >= 0; j--) {
+			const VReg4S cj(getFloatIdx(c[j]));
+			LP_(i, n) mov(b16(t3[i]), b16(cj));
+			LP_(i, n) fmla(t3[i], t2[i], x[i]);
+			t2.swap(t3);
+		}
+	}
+	void gen_exp(int inout, int n)
+	{
+		gen_expCore(inout, n, false);
+	}
+	void gen_exp2(int inout, int n)
+	{
+		gen_expCore(inout, n, true);
+	}
+	// inout = exp(inout) or 2^inout if isExp2
+	void gen_expCore(int inout, int n, bool isExp2)
+	{
+		const VReg4S log2(getFloatIdx(g_expTbl.log2));
+		const VReg4S minX(getFloatIdx(g_expTbl.minX));
+		const VReg4S maxX(getFloatIdx(g_expTbl.maxX));
+		const VReg4S i127(getConstIdx(127));
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4SVec t0 = getInputRegVec(inout, n);
+		const VReg4SVec t1 = getTmpRegVec(ftr, n);
+		VReg4SVec t2 = getTmpRegVec(ftr, n);
+		VReg4SVec t3 = getTmpRegVec(ftr, n);
+
+		if (!isExp2) {
+			const VReg4S log2_e(getFloatIdx(g_expTbl.log2_e));
+			LP_(i, n) fmul(t0[i], t0[i], log2_e);
+		}
+		// clamp x before round to avoid inf - inf ; fmax/fmin keep NaN
+		LP_(i, n) fmax(t0[i], t0[i], minX);
+		LP_(i, n) fmin(t0[i], t0[i], maxX);
+		LP_(i, n) frintn(t1[i], t0[i]); // n = round(x)
+		LP_(i, n) fsub(t0[i], t0[i], t1[i]); // a
+		LP_(i, n) fmul(t0[i], t0[i], log2);
+		gen_horner(t2, t3, t0, g_expTbl.coef, ExpTbl::N, n);
+		LP_(i, n) mov(b16(t3[i]), b16(VReg4S(getFloatIdx(g_expTbl.coef[0]))));
+		LP_(i, n) fmla(t3[i], t2[i], t0[i]);
+		// 2^n = 2^h 2^(n - h) for h = n >> 1 to get inf and subnormals
+		LP_(i, n) fcvtzs(t1[i], t1[i]);
+		LP_(i, n) sshr(t2[i], t1[i], 1);
+		LP_(i, n) sub(t1[i], t1[i], t2[i]);
+		LP_(i, n) add(t2[i], t2[i], i127);
+		LP_(i, n) shl(t2[i], t2[i], 23); // 2^h
+		LP_(i, n) add(t1[i], t1[i], i127);
+		LP_(i, n) shl(t1[i], t1[i], 23); // 2^(n - h)
+		LP_(i, n) fmul(t3[i], t3[i], t2[i]);
+		LP_(i, n) fmul(t0[i], t3[i], t1[i]);
+	}
+	void gen_cosh(int inout, int n)
+	{
+		/*
+			X = exp(|x| - h) for h = log(2) rounded to 9 bits to avoid the overflow of exp(|x|)
+			cosh(x) = k (X + (1/4k^2)/X) for k = exp(h)/2
+			1/X is computed for min(X, FLT_MAX) as x64
+		*/
+		const double h = 0.693359375;
+		const double k = std::exp(h) * 0.5;
+		const VReg4S fh(getFloatIdx(float(h)));
+		const VReg4S fk(getFloatIdx(float(k)));
+		const VReg4S fk2(getFloatIdx(float(0.25 / (k * k))));
+		const VReg4S fltMax(getFloatIdx(FLT_MAX));
+		const VReg4SVec t0 = getInputRegVec(inout, n);
+		LP_(i, n) fabs(t0[i], t0[i]);
+		LP_(i, n) fsub(t0[i], t0[i], fh);
+		gen_exp(inout, n);
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4SVec t1 = getTmpRegVec(ftr, n);
+		LP_(i, n) fmin(t1[i], t0[i], fltMax);
+		gen_inv(t1[0].getIdx(), n);
+		LP_(i, n) fmla(t0[i], t1[i], fk2);
+		LP_(i, n) fmul(t0[i], t0[i], fk);
+	}
+	void gen_log(int inout, int n)
+	{
+		gen_logBase(inout, n, LogBaseE);
+	}
+	void gen_logBase(int inout, int n, int base)
+	{
+		const double m = getLogScale(base);
+		const VReg4S i127shl23(getConstIdx(g_logTbl.i127shl23));
+		const VReg4S x7fffff(getConstIdx(g_logTbl.x7fffff));
+		const VReg4S log2(getFloatIdx(float(std::log(2.0) * m)));
+		const VReg4S f2div3(getFloatIdx(g_logTbl.f2div3));
+		const VReg4S log1p5(getFloatIdx(float(std::log(1.5) * m)));
+		const VReg4S one(getFloatIdx(1.0f));
+
+		IndexRangeManager ftr(funcTmpReg_);
+		const VReg4SVec t0 = getInputRegVec(inout, n);
+		const VReg4SVec t1 = getTmpRegVec(ftr, n);
+		VReg4SVec t2 = getTmpRegVec(ftr, n);
+		VReg4SVec t3 = getTmpRegVec(ftr, n);
+		VReg4SVec keep;
+		if (opt.logp1) {
+			keep = getTmpRegVec(ftr, n);
+			LP_(i, n) mov(b16(keep[i]), b16(t0[i]));
+		}
+
+		LP_(i, n) sub(t1[i], t0[i], i127shl23);
+		LP_(i, n) sshr(t1[i], t1[i], 23); // e
+		LP_(i, n) scvtf(t1[i], t1[i]); // float(e)
+		LP_(i, n) and_(b16(t0[i]), b16(t0[i]), b16(x7fffff));
+		LP_(i, n) orr(b16(t0[i]), b16(t0[i]), b16(i127shl23)); // y
+		LP_(i, n) fmul(t0[i], t0[i], f2div3);
+		LP_(i, n) fsub(t0[i], t0[i], one); // a
+		LP_(i, n) mov(b16(t2[i]), b16(log1p5));
+		LP_(i, n) fmla(t2[i], t1[i], log2);
+		LP_(i, n) mov(b16(t1[i]), b16(t2[i])); // e
+
+		if (opt.logp1) {
+			const VReg4S f1div8(getFloatIdx(g_logTbl.f1div8));
+			LP_(i, n) fsub(t2[i], keep[i], one); // x-1
+			LP_(i, n) facgt(keep[i], f1div8, t2[i]); // 1/8 > abs(x-1)
+			LP_(i, n) bit(b16(t0[i]), b16(t2[i]), b16(keep[i]));
+			LP_(i, n) bic(b16(t1[i]), b16(t1[i]), b16(keep[i]));
+		}
+		gen_horner(t2, t3, t0, g_logTbl.coef, LogTbl::N, n);
+		if (base != LogBaseE) {
+			const VReg4S c(getFloatIdx(float(m)));
+			LP_(i, n) fmul(t2[i], t2[i], c);
+		}
+		// a * x + e
+		LP_(i, n) fmla(t1[i], t2[i], t0[i]);
+		LP_(i, n) mov(b16(t0[i]), b16(t1[i]));
+	}
+	void gen_debugFunc(int inout, int n)
+	{
+		if (debug) printf("debugFunc z%d (%d)\n", inout, n);
+		static const float tbl[] = {
+			1, 3, 5, 7
+		};
+		const VReg4SVec t0 = getInputRegVec(inout, n);
+		const VReg4S t(getConstTblIdx(tbl, sizeof(tbl)));
+		LP_(i, n) mov(b16(t0[i]), b16(t));
+	}
+};
+
+} // namespace sg
@@ -8,7 +8,9 @@ namespace sg {
 
 struct ExpTbl {
 	float log2_e;
-#ifdef SG_X64
+	float minX; // range of x log2(e) for exp on AVX2/NEON/SVE
+	float maxX;
+#ifndef SG_SVE
 	static const int N = 5;
 	float coef[N];
 	float log2;
@@ -22,7 +24,9 @@ struct ExpTbl {
 	static const int tmpMaskN = 0;
 	ExpTbl()
 		: log2_e(1.0f / std::log(2.0f))
-#ifdef SG_X64
+		, minX(-150) // 2^-150 is rounded to 0
+		, maxX(129) // 2^129 is inf
+#ifndef SG_SVE
 		, log2(std::log(2.0f))
 #else
 		, not_mask17(~((1u << 17) - 1))
@@ -31,7 +35,7 @@ struct ExpTbl {
 		, coeff2(0.2413862043)
 #endif
 	{
-#ifdef SG_X64
+#ifndef SG_SVE
 		const uint32_t tbl[N] = {
 			0x3f800000,
 			0x3effff12,
@@ -50,7 +54,7 @@ struct LogTbl {
 	static const int N = 9;
 	uint32_t i127shl23;
 	uint32_t x7fffff;
-#ifdef SG_X64
+#ifndef SG_SVE
 	uint32_t x7fffffff;
 	float one;
 	float f1div8;
@@ -68,7 +72,7 @@ struct LogTbl {
 	LogTbl()
 		: i127shl23(127 << 23)
 		, x7fffff(0x7fffff)
-#ifdef SG_X64
+#ifndef SG_SVE
 		, x7fffffff(0x7fffffff)
 		, one(1.0)
 		, f1div8(1.0f / 8)
@@ -94,8 +98,544 @@ struct LogTbl {
 	}
 };
 
+/*
+	tables for double
+	exp(x) = 2^n exp(a) ; n = round(x/log(2)), a = x - n log(2), |a| <= log(2)/2
+	exp(a) = sum_{i=0}^{N-1} a^i/i!
+*/
+struct ExpTblD {
+	static const int N = 13;
+	double log2_e;
+	double ln2_hi; // ln2_hi + ln2_lo = log(2)
+	double ln2_lo;
+	double coef[N];
+	double minX; // range of x for exp ; exp(minX) is rounded to 0 and exp(maxX) is inf
+	double maxX;
+	ExpTblD()
+		: log2_e(1.0 / std::log(2.0))
+		, ln2_hi(6.93147180369123816490e-01)
+		, ln2_lo(1.90821492927058770002e-10)
+		, minX(-746)
+		, maxX(710)
+	{
+		double c = 1;
+		for (int i = 0; i < N; i++) {
+			coef[i] = c;
+			c /= i + 1;
+		}
+	}
+};
+
+/*
+	the algorithm of fdlibm
+	x = 2^k z ; sqrt(1/2) <= z < sqrt(2)
+	f = z - 1, s = f/(2 + f), R = sum_{i=1}^N coef[i-1] s^(2i)
+	log(x) = k log(2) + f - (f^2/2 - s(f^2/2 + R))
+*/
+struct LogTblD {
+	static const int N = 7;
+	uint64_t sqrt1_2; // bit pattern of sqrt(1/2)
+	uint64_t expMask;
+	uint64_t kMagic; // (k + 2048) | kMagic = double(2^52 + k + 2048)
+	double kMagicD;
+	double ln2_hi;
+	double ln2_lo;
+	double coef[N];
+	LogTblD()
+		: sqrt1_2(0x3fe6a09e667f3bcdull)
+		, expMask(0xfff0000000000000ull)
+		, kMagic(0x4330000000000800ull)
+		, kMagicD(4503599627372544.0) // 2^52 + 2048
+		, ln2_hi(6.93147180369123816490e-01)
+		, ln2_lo(1.90821492927058770002e-10)
+	{
+		const double tbl[N] = {
+			6.666666666666735130e-01,
+			3.999999999940941908e-01,
+			2.857142874366239149e-01,
+			2.222219843214978396e-01,
+			1.818357216161805012e-01,
+			1.531383769920937332e-01,
+			1.479819860511658591e-01,
+		};
+		for (int i = 0; i < N; i++) {
+			coef[i] = tbl[i];
+		}
+	}
+};
+
+/*
+	erf(x) = x P(x^2) for |x| < 1
+	erfc(z) = (1 + u) exp(-z^2 + Q(u)) for z >= 0 ; u = (2 - z)/(2 + z)
+	P and Q are Chebyshev fits on [0, 1] and [-1, 1] respectively
+*/
+struct ErfTbl {
+	static const int erfN = 7;
+	static const int erfcN = 12;
+	float erfCoef[erfN];
+	float erfcCoef[erfcN];
+	ErfTbl()
+	{
+		const float tbl1[erfN] = {
+			1.12837911,
+			-0.37612626,
+			0.112835944,
+			-0.0268542115,
+			0.00518908724,
+			-0.00080168643,
+			7.87587487e-05,
+		};
+		const float tbl2[erfcN] = {
+			-1.36494124,
+			0.672643185,
+			0.0473439395,
+			-0.0468947813,
+			-0.00988043193,
+			0.00881515723,
+			0.00179520145,
+			-0.0023031435,
+			-0.000229192257,
+			0.000588071707,
+			8.50831657e-06,
+			-9.24645792e-05,
+		};
+		for (int i = 0; i < erfN; i++) erfCoef[i] = tbl1[i];
+		for (int i = 0; i < erfcN; i++) erfcCoef[i] = tbl2[i];
+	}
+};
+
+// double version of ErfTbl
+struct ErfTblD {
+	static const int erfN = 12;
+	static const int erfcN = 26;
+	double erfCoef[erfN];
+	double erfcCoef[erfcN];
+	ErfTblD()
+	{
+		const double tbl1[erfN] = {
+			1.1283791670955126,
+			-0.37612638903183543,
+			0.11283791670945006,
+			-0.02686617064323777,
+			0.0052239776071164225,
+			-0.0008548325975389692,
+			0.00012055294904839707,
+			-1.492473690741966e-05,
+			1.6447424703317362e-06,
+			-1.6208483801871705e-07,
+			1.3720064546777686e-08,
+			-7.795898827002142e-10,
+		};
+		const double tbl2[erfcN] = {
+			-1.3649412646166375,
+			0.6726432239776567,
+			0.047343306841863754,
+			-0.046895610231160824,
+			-0.00987268936410846,
+			0.00882493855611383,
+			0.0017589335075480397,
+			-0.0023458124784660516,
+			-0.00014624628859718252,
+			0.0006736785371369921,
+			-9.373894209180262e-05,
+			-0.00017430116360991256,
+			7.141808767204543e-05,
+			3.1737328155349395e-05,
+			-3.023780825572967e-05,
+			1.6080205095439494e-07,
+			8.662494482986981e-06,
+			-2.994294118363313e-06,
+			-1.4094127307024207e-06,
+			1.3137199073509803e-06,
+			-4.1484920834124593e-08,
+			-3.086559820402206e-07,
+			7.746001345360312e-08,
+			3.675878538183882e-08,
+			-1.2776506237493277e-08,
+			-1.1141466421901909e-09,
+		};
+		for (int i = 0; i < erfN; i++) erfCoef[i] = tbl1[i];
+		for (int i = 0; i < erfcN; i++) erfcCoef[i] = tbl2[i];
+	}
+};
+
+/*
+	sin(r) = r P(r^2), cos(r) = Q(r^2) for |r| <= pi/4
+	P and Q are Chebyshev fits on [0, (pi/4)^2]
+	pi/2 = pi2[0] + pi2[1] + pi2[2] for the Cody-Waite reduction
+	1/(2pi) = inv2pi[0] + inv2pi[1] + ... for the Payne-Hanek reduction
+	inv2pi[i] for i >= scaleIdx is multiplied by 1/scale to avoid denormals
+*/
+struct TrigTbl {
+	static const int sinN = 4;
+	static const int cosN = 5;
+	static const int inv2piN = 8;
+	static const int scaleIdx = 4;
+	float sinCoef[sinN];
+	float cosCoef[cosN];
+	float pi2[3];
+	float inv2pi[inv2piN];
+	float scale;
+	float fastMax; // use the Cody-Waite reduction if |x| <= fastMax
+	TrigTbl()
+		: scale(std::ldexp(1.0f, -64))
+		, fastMax(std::ldexp(1.0f, 18))
+	{
+		const float tbl1[sinN] = {
+			1,
+			-0.166666508,
+			0.0083320355,
+			-0.000195038709,
+		};
+		const float tbl2[cosN] = {
+			1,
+			-0.5,
+			0.0416666158,
+			-0.0013886618,
+			2.43797895e-05,
+		};
+		const float tbl3[3] = {
+			1.57079637,
+			-4.37113883e-08,
+			-1.71512451e-15,
+		};
+		const float tbl4[inv2piN] = {
+			1.5915493667125701904e-1,
+			6.4206382432985265041e-9,
+			7.3427386990788874642e-17,
+			1.518506656844900428e-24,
+			-6.3516639864369395241e-13,
+			1.1614150559585827016e-20,
+			-3.242678858456310118e-28,
+			3.0577500165551861071e-36,
+		};
+		for (int i = 0; i < sinN; i++) sinCoef[i] = tbl1[i];
+		for (int i = 0; i < cosN; i++) cosCoef[i] = tbl2[i];
+		for (int i = 0; i < 3; i++) pi2[i] = tbl3[i];
+		for (int i = 0; i < inv2piN; i++) inv2pi[i] = tbl4[i];
+	}
+};
+
+// double version of TrigTbl
+struct TrigTblD {
+	static const int sinN = 7;
+	static const int cosN = 8;
+	static const int inv2piN = 21;
+	static const int scaleIdx = 17;
+	double sinCoef[sinN];
+	double cosCoef[cosN];
+	double pi2[3];
+	double inv2pi[inv2piN];
+	double scale;
+	double fastMax;
+	TrigTblD()
+		: scale(std::ldexp(1.0, -512))
+		, fastMax(std::ldexp(1.0, 30))
+	{
+		const double tbl1[sinN] = {
+			1.0,
+			-0.16666666666666616,
+			0.008333333333320356,
+			-0.0001984126982864526,
+			2.7557313374649857e-06,
+			-2.5050716696695676e-08,
+			1.5894720300223109e-10,
+		};
+		const double tbl2[cosN] = {
+			1.0,
+			-0.5,
+			0.04166666666666645,
+			-0.0013888888888861082,
+			2.4801587283874084e-05,
+			-2.755731309595641e-07,
+			2.0875582146477433e-09,
+			-1.1353367957830792e-11,
+		};
+		const double tbl3[3] = {
+			1.5707963267948966,
+			6.123233995736766e-17,
+			-1.4973849048591698e-33,
+		};
+		const double tbl4[inv2piN] = {
+			1.591549430918953456082221e-1,
+			-9.839338337591242940947595e-18,
+			-5.360718141446502001644983e-34,
+			4.026781963297055983448326e-50,
+			-7.801382953409856832174911e-67,
+			1.418506965595736125189224e-83,
+			-7.836906288373591711534528e-100,
+			-1.908123641189411057912133e-116,
+			6.380054387774732503884678e-133,
+			-5.782807470788813043755836e-150,
+			-1.971738508623360648125435e-166,
+			1.353532167292890704650074e-182,
+			3.120576227784803187845771e-199,
+			-3.356924834983258093649978e-217,
+			-1.057766114216514692676527e-233,
+			2.743349821669802001362227e-250,
+			1.177046855045657509456818e-267,
+			-7.232479751269195779709492e-130,
+			-6.288350312813818022722935e-147,
+			-3.672621529457355079205477e-164,
+			-1.946499040991422424738271e-180,
+		};
+		for (int i = 0; i < sinN; i++) sinCoef[i] = tbl1[i];
+		for (int i = 0; i < cosN; i++) cosCoef[i] = tbl2[i];
+		for (int i = 0; i < 3; i++) pi2[i] = tbl3[i];
+		for (int i = 0; i < inv2piN; i++) inv2pi[i] = tbl4[i];
+	}
+};
+
+/*
+	atan(t) = t + t z P(z) for |t| <= tan(pi/8) ; z = t^2
+	asin(s) = s + s z R(z) for |s| <= 1/2 ; z = s^2
+	P and R are Chebyshev fits on [0, tan(pi/8)^2] and [0, 1/4] respectively
+*/
+struct AtanTbl {
+	static const int atanN = 5;
+	static const int asinN = 5;
+	float atanCoef[atanN];
+	float asinCoef[asinN];
+	AtanTbl()
+	{
+		const float tbl1[atanN] = {
+			-0.333333318,
+			0.199995405,
+			-0.142639556,
+			0.107437315,
+			-0.0645192821,
+		};
+		const float tbl2[asinN] = {
+			0.166666724,
+			0.0749885507,
+			0.0450013801,
+			0.0265545422,
+			0.0380850236,
+		};
+		for (int i = 0; i < atanN; i++) atanCoef[i] = tbl1[i];
+		for (int i = 0; i < asinN; i++) asinCoef[i] = tbl2[i];
+	}
+};
+
+// double version of AtanTbl
+struct AtanTblD {
+	static const int atanN = 11;
+	static const int asinN = 13;
+	double atanCoef[atanN];
+	double asinCoef[asinN];
+	AtanTblD()
+	{
+		const double tbl1[atanN] = {
+			-0.3333333333333333,
+			0.19999999999995521,
+			-0.14285714284666543,
+			0.11111111015256362,
+			-0.090909045781239019,
+			0.076921831908260866,
+			-0.06664511447381948,
+			0.058581489128022099,
+			-0.050854497379402599,
+			0.039231658295587191,
+			-0.019176887119062259,
+		};
+		const double tbl2[asinN] = {
+			0.16666666666666668,
+			0.074999999999984329,
+			0.04464285714635543,
+			0.030381944138531247,
+			0.022372172942149888,
+			0.017352392720869973,
+			0.013971212973552933,
+			0.011479177415184906,
+			0.010322814350185779,
+			0.0054575067186403583,
+			0.017400879442694022,
+			-0.014851887071247203,
+			0.028757851367421565,
+		};
+		for (int i = 0; i < atanN; i++) atanCoef[i] = tbl1[i];
+		for (int i = 0; i < asinN; i++) asinCoef[i] = tbl2[i];
+	}
+};
+
+/*
+	lgamma(z) = (z - 1/2) log(z) - z + log(2 pi)/2 + P(w)/z
+	digamma(z) = log(z) - 1/(2z) - w Q(w)
+	for z >= shiftN and w = 1/z^2
+	P and Q are the asymptotic series by the Bernoulli numbers B_2k
+	P(w) = sum B_2k/(2k(2k-1)) w^(k-1), Q(w) = sum B_2k/(2k) w^(k-1)
+*/
+struct GammaTbl {
+	static const int shiftN = 8;
+	static const int lgammaN = 4;
+	static const int digammaN = 4;
+	float lgammaCoef[lgammaN];
+	float digammaCoef[digammaN];
+	GammaTbl()
+	{
+		const float tbl1[lgammaN] = {
+			1.0 / 12, -1.0 / 360, 1.0 / 1260, -1.0 / 1680,
+		};
+		const float tbl2[digammaN] = {
+			1.0 / 12, -1.0 / 120, 1.0 / 252, -1.0 / 240,
+		};
+		for (int i = 0; i < lgammaN; i++) lgammaCoef[i] = tbl1[i];
+		for (int i = 0; i < digammaN; i++) digammaCoef[i] = tbl2[i];
+	}
+};
+
+// double version of GammaTbl
+struct GammaTblD {
+	static const int shiftN = 10;
+	static const int lgammaN = 8;
+	static const int digammaN = 8;
+	double lgammaCoef[lgammaN];
+	double digammaCoef[digammaN];
+	GammaTblD()
+	{
+		const double tbl1[lgammaN] = {
+			1.0 / 12, -1.0 / 360, 1.0 / 1260, -1.0 / 1680,
+			1.0 / 1188, -691.0 / 360360, 1.0 / 156, -3617.0 / 122400,
+		};
+		const double tbl2[digammaN] = {
+			1.0 / 12, -1.0 / 120, 1.0 / 252, -1.0 / 240,
+			1.0 / 132, -691.0 / 32760, 1.0 / 12, -3617.0 / 8160,
+		};
+		for (int i = 0; i < lgammaN; i++) lgammaCoef[i] = tbl1[i];
+		for (int i = 0; i < digammaN; i++) digammaCoef[i] = tbl2[i];
+	}
+};
+
+/*
+	norminv(p) by PPND7 of Wichura's AS241 (relative error about 1e-7)
+	a/b for |p - 1/2| <= 0.425, c/d for r <= 5 and e/f for r > 5
+	where r = sqrt(-log(min(p, 1 - p))) (see gen_normInv)
+	the coefficients are in ascending order and b[0] = d[0] = f[0] = 1
+*/
+struct NormInvTbl {
+	static const int aN = 4;
+	static const int bN = 4;
+	static const int cN = 4;
+	static const int dN = 3;
+	static const int eN = 4;
+	static const int fN = 3;
+	float a[aN];
+	float b[bN];
+	float c[cN];
+	float d[dN];
+	float e[eN];
+	float f[fN];
+	NormInvTbl()
+	{
+		const float tblA[aN] = { 3.3871327179e+00, 5.0434271938e+01, 1.5929113202e+02, 5.9109374720e+01 };
+		const float tblB[bN] = { 1, 1.7895169469e+01, 7.8757757664e+01, 6.7187563600e+01 };
+		const float tblC[cN] = { 1.4234372777e+00, 2.7568153900e+00, 1.3067284816e+00, 1.7023821103e-01 };
+		const float tblD[dN] = { 1, 7.3700164250e-01, 1.2021132975e-01 };
+		const float tblE[eN] = { 6.6579051150e+00, 3.0812263860e+00, 4.2868294337e-01, 1.7337203997e-02 };
+		const float tblF[fN] = { 1, 2.4197894225e-01, 1.2258202635e-02 };
+		for (int i = 0; i < aN; i++) a[i] = tblA[i];
+		for (int i = 0; i < bN; i++) b[i] = tblB[i];
+		for (int i = 0; i < cN; i++) c[i] = tblC[i];
+		for (int i = 0; i < dN; i++) d[i] = tblD[i];
+		for (int i = 0; i < eN; i++) e[i] = tblE[i];
+		for (int i = 0; i < fN; i++) f[i] = tblF[i];
+	}
+};
+
+// double version of NormInvTbl by PPND16 (relative error about 1e-16)
+struct NormInvTblD {
+	static const int aN = 8;
+	static const int bN = 8;
+	static const int cN = 8;
+	static const int dN = 8;
+	static const int eN = 8;
+	static const int fN = 8;
+	double a[aN];
+	double b[bN];
+	double c[cN];
+	double d[dN];
+	double e[eN];
+	double f[fN];
+	NormInvTblD()
+	{
+		const double tblA[aN] = {
+			3.3871328727963666080e+00, 1.3314166789178437745e+02, 1.9715909503065514427e+03, 1.3731693765509461125e+04,
+			4.5921953931549871457e+04, 6.7265770927008700853e+04, 3.3430575583588128105e+04, 2.5090809287301226727e+03,
+		};
+		const double tblB[bN] = {
+			1, 4.2313330701600911252e+01, 6.8718700749205790830e+02, 5.3941960214247511077e+03,
+			2.1213794301586595867e+04, 3.9307895800092710610e+04, 2.8729085735721942674e+04, 5.2264952788528545610e+03,
+		};
+		const double tblC[cN] = {
+			1.42343711074968357734e+00, 4.63033784615654529590e+00, 5.76949722146069140550e+00, 3.64784832476320460504e+00,
+			1.27045825245236838258e+00, 2.41780725177450611770e-01, 2.27238449892691845833e-02, 7.74545014278341407640e-04,
+		};
+		const double tblD[dN] = {
+			1, 2.05319162663775882187e+00, 1.67638483018380384940e+00, 6.89767334985100004550e-01,
+			1.48103976427480074590e-01, 1.51986665636164571966e-02, 5.47593808499534494600e-04, 1.05075007164441684324e-09,
+		};
+		const double tblE[eN] = {
+			6.65790464350110377720e+00, 5.46378491116411436990e+00, 1.78482653991729133580e+00, 2.96560571828504891230e-01,
+			2.65321895265761230930e-02, 1.24266094738807843860e-03, 2.71155556874348757815e-05, 2.01033439929228813265e-07,
+		};
+		const double tblF[fN] = {
+			1, 5.99832206555887937690e-01, 1.36929880922735805310e-01, 1.48753612908506148525e-02,
+			7.86869131145613259100e-04, 1.84631831751005468180e-05, 1.42151175831644588870e-07, 2.04426310338993978564e-15,
+		};
+		for (int i = 0; i < aN; i++) a[i] = tblA[i];
+		for (int i = 0; i < bN; i++) b[i] = tblB[i];
+		for (int i = 0; i < cN; i++) c[i] = tblC[i];
+		for (int i = 0; i < dN; i++) d[i] = tblD[i];
+		for (int i = 0; i < eN; i++) e[i] = tblE[i];
+		for (int i = 0; i < fN; i++) f[i] = tblF[i];
+	}
+};
+
+// constants to convert float to bfloat16
+struct Bf16Tbl {
+	uint32_t one[16];
+	uint32_t x7fff[16];
+	Bf16Tbl()
+	{
+		for (int i = 0; i < 16; i++) {
+			one[i] = 1;
+			x7fff[i] = 0x7fff;
+		}
+	}
+};
+
+// the range of an integer type in float to saturate it
+struct IntRangeTbl {
+	float lo[16];
+	float hi[16];
+	IntRangeTbl(float lo_, float hi_)
+	{
+		for (int i = 0; i < 16; i++) {
+			lo[i] = lo_;
+			hi[i] = hi_;
+		}
+	}
+};
+
 extern const ExpTbl g_expTbl;
 extern const LogTbl g_logTbl;
+extern const ExpTblD g_expTblD;
+extern const LogTblD g_logTblD;
+extern const ErfTbl g_erfTbl;
+extern const ErfTblD g_erfTblD;
+extern const TrigTbl g_trigTbl;
+extern const TrigTblD g_trigTblD;
+extern const AtanTbl g_atanTbl;
+extern const AtanTblD g_atanTblD;
+extern const GammaTbl g_gammaTbl;
+extern const GammaTblD g_gammaTblD;
+extern const NormInvTbl g_normInvTbl;
+extern const NormInvTblD g_normInvTblD;
+extern const Bf16Tbl g_bf16Tbl;
+extern const IntRangeTbl g_uint8RangeTbl;
+extern const IntRangeTbl g_int8RangeTbl;
+extern const IntRangeTbl g_int16RangeTbl;
+extern const IntRangeTbl g_int32RangeTbl;
 } // sg
 
 #ifdef _MSC_VER
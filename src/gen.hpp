@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <cmath>
+#include <float.h>
+#include <limits>
 #include "tokenlist.hpp"
 #include "const.hpp"
 #include "opt.hpp"
@@ -11,6 +13,45 @@
 
 namespace sg {
 
+// comparison for gen_cmpSelect
+enum CmpType {
+	CmpEq,
+	CmpNeq,
+	CmpLt,
+	CmpLe,
+	CmpGt,
+	CmpGe,
+	CmpTypeN
+};
+
+// rounding mode for gen_round (the same as opt.roundMode)
+enum RoundMode {
+	RoundEven,
+	RoundDown,
+	RoundUp,
+	RoundZero
+};
+
+// precision of sqrt and rsqrt (opt.sqrtMode)
+enum SqrtMode {
+	SqrtExact, // vsqrtps and a division
+	SqrtNewton, // the estimate and Newton steps (one for float and two for double)
+	SqrtApprox // the estimate only
+};
+
+// evaluation of poly (opt.polyMode)
+enum PolyMode {
+	PolyHorner, // the shortest code and the fewest registers
+	PolyEstrin // the shorter dependency chain for a high degree
+};
+
+// base of gen_logBase
+enum LogBase {
+	LogBaseE,
+	LogBase2,
+	LogBase10
+};
+
 struct IndexRange {
 	int offset_;
 	int max_;
@@ -78,6 +119,8 @@ struct IndexRangeManager {
 struct SimdArray {
 #ifdef SG_NEON
 	static const int N = 4;
+#elif defined(SG_SVE)
+	static const int N = 64; // 2048-bit, the maximum SVE vector length
 #else
 	static const int N = 16;
 #endif
@@ -121,44 +164,62 @@ public:
 };
 
 struct GeneratorBase {
+	static const int maxSrcN = 8; // max # of input arrays
+	static const int maxDstN = 8; // max # of output arrays
+	static const int maxParamN = 32; // max # of runtime parameters
 	// simd memory data and preload registers
 	Index<SimdArray> constTblMem_; // simd memory
 	Index<uint32_t> constTblIdx_; // preload regs
 
-	// float/uint32_t data and preload registers
-	Index<uint32_t> constMem_; // 4 byte float memory
+	// float/double/integer data and preload registers
+	Index<uint64_t> constMem_; // 8 byte memory (float uses the lower 4 bytes)
 	Index<uint32_t> constIdx_; // preload regs
 	int simdByte_;
 	int maxSimdRegN_;
+	bool onlyFloat_; // the backend supports only float arrays
 	int unrollN_;
 	void* addr_;
 	/*
-		[0, varN_] ; var
-		varN_ + [0, constN_] ; const
-		varN_ + constN_ + [0, funcTmpReg_.max()] ; tmp reg in func
-		varN_ + constN_ + funcTmpReg_.max() + [0, maxTmpN_] ; stack tmp reg
+		[0, varN_] ; var (srcN_ * unrollN_ and unrollN_ for reduce)
+		varN_ + [0, constN_] ; param and const
+		varN_ + constN_ + [0, letN_] ; let-binding
+		varN_ + constN_ + letN_ + [0, funcTmpReg_.max()] ; tmp reg in func
+		varN_ + constN_ + letN_ + funcTmpReg_.max() + [0, maxTmpN_] ; stack tmp reg
 	*/
 	uint32_t varN_; // # variables
-	uint32_t constN_; // # constants
+	int srcN_; // # input arrays
+	int dstN_; // # output arrays
+	uint32_t paramN_; // # runtime parameters
+	uint32_t constN_; // # params and constants
+	uint32_t letN_; // # registers of let-bindings
 	IndexRange funcTmpReg_;
 	IndexRange funcTmpMask_;
 	uint32_t maxTmpN_; // max # of regs in evaluation
 	int totalN_;
 	uint32_t curMaskTmpIdx_;
 	int reduceFuncType_;
+	int dstType_; // SG_FLOAT, SG_DOUBLE, ...
+	int srcType_;
 	bool debug;
 	SgOpt opt;
 	GeneratorBase()
 		: simdByte_(32 / 8) // one float
 		, maxSimdRegN_(1)
+		, onlyFloat_(false)
 		, unrollN_(0)
 		, addr_(0)
 		, varN_(0)
+		, srcN_(0)
+		, dstN_(0)
+		, paramN_(0)
 		, constN_(0)
+		, letN_(0)
 		, maxTmpN_(0)
 		, totalN_(0)
 		, curMaskTmpIdx_(0)
 		, reduceFuncType_(-1)
+		, dstType_(SG_FLOAT)
+		, srcType_(SG_FLOAT)
 		, debug(false)
 	{
 		opt.getEnv();
@@ -168,20 +229,106 @@ struct GeneratorBase {
 	virtual ~GeneratorBase()
 	{
 	}
+	void setOpt(const char *str)
+	{
+		opt.set(str);
+		debug = opt.debug;
+		unrollN_ = opt.unrollN;
+	}
+	// copy the settings given by setOpt and setType
+	void copySetting(const GeneratorBase& rhs)
+	{
+		opt = rhs.opt;
+		debug = opt.debug;
+		unrollN_ = opt.unrollN;
+		dstType_ = rhs.dstType_;
+		srcType_ = rhs.srcType_;
+	}
+	// return true if e is thrown because the code buffer is too small
+	virtual bool isCodeSizeError(const std::exception&) const { return false; }
+	static int getTypeByte(int type)
+	{
+		switch (type) {
+		case SG_FLOAT: return 4;
+		case SG_DOUBLE: return 8;
+		case SG_FLOAT16: return 2;
+		case SG_BFLOAT16: return 2;
+		case SG_UINT8: return 1;
+		case SG_INT8: return 1;
+		case SG_INT16: return 2;
+		case SG_INT32: return 4;
+		default:
+			throw cybozu::Exception("bad type") << type;
+		}
+	}
+	static bool isIntType(int type)
+	{
+		return SG_UINT8 <= type && type <= SG_INT32;
+	}
+	// the range to saturate an integer dst
+	const IntRangeTbl& getIntRangeTbl() const
+	{
+		switch (dstType_) {
+		case SG_UINT8: return g_uint8RangeTbl;
+		case SG_INT8: return g_int8RangeTbl;
+		case SG_INT16: return g_int16RangeTbl;
+		case SG_INT32: return g_int32RangeTbl;
+		default:
+			throw cybozu::Exception("getIntRangeTbl:bad type") << dstType_;
+		}
+	}
+	/*
+		double is computed in double and can't be mixed with other types
+		the others are computed in float
+	*/
+	void setType(int dstType, int srcType)
+	{
+		getTypeByte(dstType);
+		getTypeByte(srcType);
+		if ((dstType == SG_DOUBLE) != (srcType == SG_DOUBLE)) {
+			throw cybozu::Exception("double can't be mixed") << dstType << srcType;
+		}
+		if (onlyFloat_ && (dstType != SG_FLOAT || srcType != SG_FLOAT)) {
+			throw cybozu::Exception("only float is supported") << dstType << srcType;
+		}
+		dstType_ = dstType;
+		srcType_ = srcType;
+	}
+	// compute in double if true else float
+	bool isDouble() const { return srcType_ == SG_DOUBLE; }
+	int getComputeType() const { return isDouble() ? SG_DOUBLE : SG_FLOAT; }
+	int getSrcByte() const { return getTypeByte(srcType_); }
+	int getDstByte() const { return getTypeByte(dstType_); }
+	// src/dst needs conversion from/to the type of computation
+	bool isSrcConv() const { return srcType_ != getComputeType(); }
+	bool isDstConv() const { return reduceFuncType_ < 0 && dstType_ != getComputeType(); }
+	// byte size of an element in a register
+	int getElemByte() const { return isDouble() ? 8 : 4; }
+	// bit pattern of a constant in the type of computation
+	uint64_t getConstVal(const Value& v) const { return isDouble() ? d2u(v.d) : v.v; }
 	const void* getAddrFloat1() const { return addr_; }
 	int getVarIdxOffset() const { return 0; }
-	int getVarIdx(int i) const { return getVarIdxOffset() + i; }
+	// the register of the v-th variable for the i-th unroll
+	int getVarIdx(int v, int i) const { return getVarIdxOffset() + v * unrollN_ + i; }
+	int getVarIdx(int i) const { return getVarIdx(0, i); }
 	int getReduceVarIdx() const { return getVarIdxOffset() + varN_ - unrollN_; }
-	uint32_t getConstTblIdx0() const { return varN_; }
-	uint32_t getConstIdx0() const { return varN_ + constTblIdx_.size(); }
-	uint32_t getTmpOffset() const { return varN_ + constN_ + funcTmpReg_.getSize(); }
+	uint32_t getParamIdx(int i) const { return varN_ + i; }
+	uint32_t getConstTblIdx0() const { return varN_ + paramN_; }
+	uint32_t getConstIdx0() const { return getConstTblIdx0() + constTblIdx_.size(); }
+	// the register of the k-th let-binding for the i-th unroll
+	int getLetIdx(int k, int i) const { return varN_ + constN_ + k * unrollN_ + i; }
+	uint32_t getTmpOffset() const { return varN_ + constN_ + letN_ + funcTmpReg_.getSize(); }
 	int getTmpIdx(int i) const { return getTmpOffset() + i; }
+	// the register of the k-th output for the i-th unroll
+	int getOutIdx(int k, int i, int unrollN) const { return getTmpIdx(k * unrollN + i); }
 	uint32_t getTotalNum() const { return getTmpOffset() + maxTmpN_; }
 	void putLayout() const
 	{
 		puts("--- Layout ---");
 		printf("var       %d, ..., %d\n", 0, varN_);
+		printf("param     %d, ..., %d\n", varN_, varN_ + paramN_);
 		printf("const     %d, ..., %d\n", varN_, varN_ + constN_);
+		printf("let       %d, ..., %d\n", varN_ + constN_, varN_ + constN_ + letN_);
 		printf("funcTmp   %d, ..., %d\n", funcTmpReg_.getOffset(), funcTmpReg_.getOffset() + funcTmpReg_.getSize());
 		printf("stack reg %d, ..., %d\n", getTmpOffset(), getTotalNum());
 		printf("funcTmpReg_.getMax()=%d\n", funcTmpReg_.getMax());
@@ -194,9 +341,9 @@ struct GeneratorBase {
 		SimdArray u(p, byteSize);
 		return constTblMem_.getIdx(u) * SimdArray::byteSize;
 	}
-	uint32_t getConstOffsetToDataReg(uint32_t u) const
+	uint32_t getConstOffsetToDataReg(uint64_t u) const
 	{
-		return constTblMem_.size() * SimdArray::byteSize + constMem_.getIdx(u) * 4;
+		return constTblMem_.size() * SimdArray::byteSize + constMem_.getIdx(u) * 8;
 	}
 	uint32_t getConstTblIdx(const void *p, size_t byteSize) const
 	{
@@ -204,7 +351,7 @@ struct GeneratorBase {
 		uint32_t idx = constTblMem_.getIdx(u);
 		return getConstTblIdx0() + constTblIdx_.getIdx(idx);
 	}
-	uint32_t getConstIdx(uint32_t u) const
+	uint32_t getConstIdx(uint64_t u) const
 	{
 		uint32_t idx = constMem_.getIdx(u);
 		return getConstIdx0() + constIdx_.getIdx(idx);
@@ -213,17 +360,39 @@ struct GeneratorBase {
 	{
 		return getConstIdx(f2u(f));
 	}
+	int getDoubleIdx(double d) const
+	{
+		return getConstIdx(d2u(d));
+	}
+	// return the index of d in the type to compute
+	int getValIdx(double d) const
+	{
+		return isDouble() ? getDoubleIdx(d) : getFloatIdx(float(d));
+	}
 	/*
 		setup registers and const variables
 	*/
 	bool setupLayout(const sg::TokenList& tl, int unrollN)
 	{
 		unrollN_ = unrollN;
+		reduceFuncType_ = tl.getReduceFuncType();
+		srcN_ = tl.getVarNum();
+		if (srcN_ > maxSrcN) throw cybozu::Exception("too many variables") << srcN_;
+		dstN_ = tl.getOutNum();
+		if (dstN_ > maxDstN) throw cybozu::Exception("too many outputs") << dstN_;
+		varN_ = srcN_ * unrollN_;
+		if (reduceFuncType_ >= 0) {
+			varN_ += unrollN_;
+		}
+		paramN_ = tl.getParamNum();
+		if (paramN_ > maxParamN) throw cybozu::Exception("too many params") << paramN_;
+		// let-bindings are kept in registers during the loop
+		letN_ = tl.getLetNum() * unrollN_;
 		// set constMem_ by consts used in tl
 		const sg::ValueVec& vv = tl.getValueVec();
 		for (size_t i = 0; i < vv.size(); i++) {
 			if (vv[i].type == Const) {
-				constMem_.append(vv[i].v);
+				constMem_.append(getConstVal(vv[i]));
 			}
 		}
 		/*
@@ -232,6 +401,10 @@ struct GeneratorBase {
 			funcTmpReg_ ; # of registers temporarily used in functions
 			funcTmpMask ; # of mask registers
 		*/
+		resetCode();
+		// clear the layout of the previous try to keep the register indices small in the seek mode
+		constN_ = 0;
+		funcTmpReg_.setOffset(0);
 		funcTmpReg_.setSeekMode(true);
 		funcTmpMask_.setSeekMode(true);
 		constMem_.setSeekMode(true);
@@ -249,40 +422,62 @@ struct GeneratorBase {
 		constTblMem_.setSeekMode(false);
 		constTblIdx_.setSeekMode(false);
 
-		reduceFuncType_ = tl.getReduceFuncType();
-
-		varN_ = tl.getVarNum() * unrollN_;
-		if (reduceFuncType_ >= 0) {
-			varN_ += unrollN_;
-		}
-		constN_ = constIdx_.size() + constTblIdx_.size();
-		funcTmpReg_.setOffset(varN_ + constN_);
+		constN_ = paramN_ + constTblIdx_.size() + constIdx_.size();
+		funcTmpReg_.setOffset(varN_ + constN_ + letN_);
 		funcTmpMask_.setOffset(1 + 1); // mask0 and mask1 are reserved
 		maxTmpN_ = tl.getMaxTmpNum() * unrollN_;
-		totalN_ = varN_ + constN_ + funcTmpReg_.getSize() + maxTmpN_;
-		if (debug) printf("varN=%d constN=%d funcTmpReg.max=%d maxTmpN=%d\n", varN_, constN_, funcTmpReg_.getSize(), maxTmpN_);
+		totalN_ = varN_ + constN_ + letN_ + funcTmpReg_.getSize() + maxTmpN_;
+		if (debug) printf("varN=%d constN=%d letN=%d funcTmpReg.max=%d maxTmpN=%d\n", varN_, constN_, letN_, funcTmpReg_.getSize(), maxTmpN_);
 		return totalN_ <= maxSimdRegN_;
 	}
+	/*
+		search the max unrollN <= maxTryUnrollN for which all registers fit
+		unroll=<num> of opt gives maxTryUnrollN and it is lowered if necessary
+		(e.g. double log on AVX2 can't be unrolled 3 times)
+		use_mem=0 and log_use_mem=0 fall back to the constant table in memory if the constants do not fit even for unrollN = 1
+	*/
 	void detectUnrollN(const sg::TokenList& tl)
 	{
-		const int maxTryUnrollN = 5;
-		if (unrollN_ > 0) {
-			if (!setupLayout(tl, unrollN_)) {
-				throw cybozu::Exception("can't unrollN") << unrollN_;
-			}
-		} else {
-			int unrollN = maxTryUnrollN;
-			while (unrollN > 0) {
-				if (setupLayout(tl, unrollN)) {
-					break;
+		const int requestedUnrollN = unrollN_;
+		const int maxTryUnrollN = requestedUnrollN > 0 ? requestedUnrollN : 5;
+		int unrollN = maxTryUnrollN;
+		while (unrollN > 0) {
+			bool ok = false;
+			if (unrollN == 1 && opt.use_mem && opt.log_use_mem) {
+				ok = setupLayout(tl, unrollN);
+			} else {
+				// too many registers may cause an error in generating code
+				try {
+					ok = setupLayout(tl, unrollN);
+				} catch (std::exception& e) {
+					// a larger buffer is necessary instead of a smaller unrollN
+					if (isCodeSizeError(e)) throw;
+					if (debug) printf("unrollN=%d err %s\n", unrollN, e.what());
 				}
-				unrollN--;
 			}
-			if (unrollN == 0) {
+			if (ok) {
+				break;
+			}
+			unrollN--;
+		}
+		if (unrollN == 0) {
+			if (opt.use_mem && opt.log_use_mem) {
 				throw cybozu::Exception("too complex expression");
 			}
+			if (debug) printf("use_mem=1 and log_use_mem=1 because the constants do not fit in registers\n");
+			opt.use_mem = true;
+			opt.log_use_mem = true;
+			// drop the preload registers counted by the previous tries
+			constIdx_.clear();
+			constTblIdx_.clear();
+			unrollN_ = requestedUnrollN;
+			detectUnrollN(tl);
+			return;
+		}
+		if (debug) {
+			if (requestedUnrollN > 0 && unrollN_ < requestedUnrollN) printf("unroll=%d is lowered\n", requestedUnrollN);
+			printf("unrollN_=%d\n", unrollN_);
 		}
-		if (debug) printf("unrollN_=%d\n", unrollN_);
 	}
 	void gen_setConst()
 	{
@@ -292,6 +487,9 @@ struct GeneratorBase {
 		for (uint32_t i = 0; i < constIdx_.size(); i++) {
 			gen_setInt(getConstIdx0() + i, constMem_.getVal(constIdx_.getVal(i)));
 		}
+		for (uint32_t i = 0; i < paramN_; i++) {
+			gen_loadParam(getParamIdx(i), i);
+		}
 	}
 	virtual void exec(const sg::TokenList& tl)
 	{
@@ -301,9 +499,14 @@ struct GeneratorBase {
 		puts("execOneLoop");
 		execOneLoop(tl, 1);
 	}
-	virtual void gen_setInt(int dst, uint32_t u)
+	virtual void gen_setInt(int dst, uint64_t u)
 	{
-		if (debug) printf("setImm z%d, %08x\n", dst, u);
+		if (debug) printf("setImm z%d, %016llx\n", dst, (unsigned long long)u);
+	}
+	// broadcast the i-th element of params
+	virtual void gen_loadParam(int dst, int i)
+	{
+		if (debug) printf("loadParam z%d, params[%d]\n", dst, i);
 	}
 	virtual void gen_fullLoad(int dst, uint32_t offset)
 	{
@@ -345,13 +548,81 @@ struct GeneratorBase {
 	{
 		if (debug) printf("log z%d (%d)\n", inout, n);
 	}
+	// inout = 2^inout without the multiplication by log2(e) of exp
+	virtual void gen_exp2(int inout, int n)
+	{
+		if (debug) printf("exp2 z%d (%d)\n", inout, n);
+	}
+	// inout = log(inout)/log(base) (LogBase) with the range reduction of log
+	virtual void gen_logBase(int inout, int n, int base)
+	{
+		if (debug) printf("logBase z%d (%d) %d\n", inout, n, base);
+	}
 	virtual void gen_cosh(int inout, int n)
 	{
 		if (debug) printf("cosh z%d (%d)\n", inout, n);
 	}
-	virtual void gen_tanh(int inout, int n)
+	virtual void gen_max(int dst, int src1, int src2)
+	{
+		if (debug) printf("max z%d, z%d, z%d\n", dst, src1, src2);
+	}
+	virtual void gen_min(int dst, int src1, int src2)
+	{
+		if (debug) printf("min z%d, z%d, z%d\n", dst, src1, src2);
+	}
+	// dst = src1 * src2 + src3 ; dst may be equal to any src
+	virtual void gen_fmadd(int dst, int src1, int src2, int src3)
+	{
+		if (debug) printf("fmadd z%d, z%d, z%d, z%d\n", dst, src1, src2, src3);
+	}
+	// dst = -src1 * src2 + src3 ; dst may be equal to any src
+	virtual void gen_fnmadd(int dst, int src1, int src2, int src3)
+	{
+		if (debug) printf("fnmadd z%d, z%d, z%d, z%d\n", dst, src1, src2, src3);
+	}
+	virtual void gen_abs(int dst, int src)
+	{
+		if (debug) printf("abs z%d, z%d\n", dst, src);
+	}
+	// dst = |x| with the sign bit of y ; dst may be equal to x or y
+	virtual void gen_copysign(int dst, int x, int y)
+	{
+		if (debug) printf("copysign z%d, z%d, z%d\n", dst, x, y);
+	}
+	virtual void gen_sqrt(int dst, int src)
+	{
+		if (debug) printf("sqrt z%d, z%d\n", dst, src);
+	}
+	// dst = an approximation of 1/sqrt(src) with 11 bits or more ; dst must not be src
+	virtual void gen_rsqrtEst(int dst, int src)
+	{
+		if (debug) printf("rsqrtEst z%d, z%d\n", dst, src);
+	}
+	// dst = (src1 cmp src2) ? x : y
+	virtual void gen_cmpSelect(int dst, int cmp, int src1, int src2, int x, int y)
+	{
+		if (debug) printf("cmpSelect z%d, %d, z%d, z%d, z%d, z%d\n", dst, cmp, src1, src2, x, y);
+	}
+	// dst = src rounded to an integer by mode (RoundMode)
+	virtual void gen_round(int dst, int src, int mode)
+	{
+		if (debug) printf("round z%d, z%d, %d\n", dst, src, mode);
+	}
+	/*
+		skip the code until gen_endSkip() if (src1 cmp src2) is false for all elements
+		the branch is not generated in the seek mode
+	*/
+	virtual void gen_beginSkip(int cmp, int src1, int src2)
+	{
+		if (debug) printf("beginSkip %d, z%d, z%d\n", cmp, src1, src2);
+	}
+	virtual void gen_endSkip()
+	{
+		if (debug) printf("endSkip\n");
+	}
+	// discard the code generated by the previous execOneLoop
+	virtual void resetCode()
 	{
-		if (debug) printf("tanh z%d (%d)\n", inout, n);
 	}
 	virtual void gen_debugFunc(int inout, int n)
 	{
@@ -361,83 +632,2019 @@ struct GeneratorBase {
 	{
 		if (debug) printf("reduceOne_sum z%d (%d)\n", d, s);
 	}
-	void gen_reduce(int red, int src) // not virtual
+	/*
+		the following functions are composed of the above ones
+		and common to all architectures
+	*/
+	// allocate n contiguous registers and return the first index
+	int allocTmpIdx(IndexRangeManager& ftr, int n)
 	{
-		switch (reduceFuncType_) {
-		case RedSum: gen_add(red, red, src); break;
-		default:
-			throw cybozu::Exception("gen_reduce:bad reduceFuncType_") << reduceFuncType_;
+		int ret = ftr.allocIdx();
+		for (int i = 1; i < n; i++) ftr.allocIdx();
+		return ret;
+	}
+	/*
+		return a register having d
+		it is a tmp register set in each loop if opt.use_mem to save const registers
+	*/
+	int getValTmpIdx(IndexRangeManager& ftr, double d)
+	{
+		if (!opt.use_mem) return getValIdx(d);
+		return setValTmpIdx(ftr, d);
+	}
+	// set d in the type to compute to dst from the data area
+	void gen_setVal(int dst, double d)
+	{
+		gen_setInt(dst, isDouble() ? d2u(d) : f2u(float(d)));
+	}
+	// return a tmp register set d from the data area
+	int setValTmpIdx(IndexRangeManager& ftr, double d)
+	{
+		const int idx = ftr.allocIdx();
+		gen_setVal(idx, d);
+		return idx;
+	}
+	// log_b(x) = log(x) m for m = 1/log(b)
+	static double getLogScale(int base)
+	{
+		switch (base) {
+		case LogBase2: return 1.4426950408889634; // 1/log(2)
+		case LogBase10: return 0.43429448190325183; // 1/log(10)
+		default: return 1;
 		}
 	}
-	void reduceAll() // not virtual
+	/*
+		expm1(x) = exp(x) - 1 without the cancellation around 0
+		u = exp(x)
+		expm1(x) = (u == 1) ? x : (u - 1) * x / log(u)
+		the caller must clamp x to [-40, 40] (exp(-40) < 2^-53)
+	*/
+	void gen_expm1(int inout, int n) // not virtual
 	{
-		int red = getReduceVarIdx();
-		for (int i = 1; i < unrollN_; i++) {
-			gen_reduce(red, red + i);
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int u = allocTmpIdx(ftr, n);
+		const int w = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(u + i, inout + i);
+		gen_exp(u, n);
+		LP_(i, n) gen_copy(w + i, u + i);
+		gen_log(w, n);
+		LP_(i, n) gen_div(w + i, inout + i, w + i);
+		LP_(i, n) gen_sub(u + i, u + i, one);
+		LP_(i, n) gen_mul(w + i, w + i, u + i);
+		LP_(i, n) gen_cmpSelect(inout + i, CmpEq, u + i, zero, inout + i, w + i);
+	}
+	/*
+		expm1(x) for all x
+		x is clamped to [-40, c] for gen_expm1 where exp(c) is inf
+		cmpSelect is used instead of max and min to keep NaN
+	*/
+	void gen_expm1Clamp(int inout, int n) // not virtual
+	{
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const int lo = getValTmpIdx(ftr, -40);
+			const int hi = getValTmpIdx(ftr, isDouble() ? 710 : 89);
+			LP_(i, n) {
+				gen_cmpSelect(inout + i, CmpLt, inout + i, lo, lo, inout + i);
+				gen_cmpSelect(inout + i, CmpGt, inout + i, hi, hi, inout + i);
+			}
 		}
-		switch (reduceFuncType_) {
-		case RedSum: reduceOne_sum(0, red); break;
-		default:
-			throw cybozu::Exception("reduce:bad reduceFuncType_") << reduceFuncType_;
+		gen_expm1(inout, n);
+	}
+	/*
+		log1p(x) = log(1 + x) without the cancellation around 0
+		u = 1 + x
+		log1p(x) = (u == 1) ? x : (log(u) / (u - 1)) * x
+		log(u) / (u - 1) is computed first to avoid the overflow of log(u) * x
+		the caller must restrict x to -1 < x < inf (see gen_log1pSpecial)
+	*/
+	void gen_log1p(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int u = allocTmpIdx(ftr, n);
+		const int w = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_add(u + i, inout + i, one);
+		LP_(i, n) gen_copy(w + i, u + i);
+		gen_log(w, n);
+		LP_(i, n) gen_sub(u + i, u + i, one);
+		LP_(i, n) gen_div(w + i, w + i, u + i);
+		LP_(i, n) gen_mul(w + i, w + i, inout + i);
+		LP_(i, n) gen_cmpSelect(inout + i, CmpEq, u + i, zero, inout + i, w + i);
+	}
+	/*
+		set the special values of y = log(x - x0) for x0 = 0 (log) or -1 (log1p)
+		y = -inf for x = x0, NaN for x < x0 or x = NaN and inf for x = inf
+		the other elements of y are kept
+	*/
+	void gen_logSpecial(int y, int x, int n, double x0) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int c = getValTmpIdx(ftr, x0);
+		const int minusInf = getValTmpIdx(ftr, -HUGE_VAL);
+		const int inf = getValTmpIdx(ftr, HUGE_VAL);
+		const int nan = ftr.allocIdx();
+		gen_setVal(nan, std::numeric_limits<double>::quiet_NaN());
+		LP_(i, n) {
+			gen_cmpSelect(y + i, CmpGt, x + i, c, y + i, nan);
+			gen_cmpSelect(y + i, CmpEq, x + i, c, minusInf, y + i);
+			gen_cmpSelect(y + i, CmpEq, x + i, inf, inf, y + i);
 		}
 	}
-	template<class TL>
-	void execOneLoop(const TL& tl, int unrollN)
+	/*
+		inout = log(inout) for inout >= min denormal
+		inout < min normal is multiplied by 2^k and k log(2) is subtracted because log does not support denormals (see gen_cbrt)
+	*/
+	void gen_logDenormal(int inout, int n) // not virtual
 	{
-		const sg::ValueVec& vv = tl.getValueVec();
-		const size_t n = vv.size();
-		const int maxStackPos = 32;
-		int stack[maxStackPos];
-		int stackPos = 0;
-		const int tmpMin = getTmpOffset();
-		int tmpPos = tmpMin;
-		for (size_t j = 0; j < n; j++) {
-			if (stackPos < 0 || maxStackPos <= stackPos) throw cybozu::Exception("bad stackPos") << stackPos;
-			const Value& v = vv[j];
-			switch (v.type) {
-			case Var:
-				LP_(i, unrollN) stack[stackPos++] = getVarIdxOffset() + v.v + i;
-				break;
-			case Const:
-				LP_(i, unrollN) stack[stackPos++] = getConstIdx(v.v);
-				break;
-			case Op:
-				LP_(i, unrollN) {
-					int dst = 0;
-					int src1 = stack[stackPos - unrollN * 2 + i];
-					int src2 = stack[stackPos - unrollN + i];
-					if (src1 < tmpMin) {
-						if (src2 < tmpMin) {
-							dst = tmpPos++;
-						} else {
-							dst = src2;
-						}
-					} else {
-						if (src2 < tmpMin) {
-							dst = src1;
-							tmpPos--;
-						} else {
-							dst = src1;
-						}
-					}
-					stack[stackPos - unrollN * 2 + i] = dst;
-					switch (v.v) {
-					case Add: gen_add(dst, src1, src2); break;
-					case Sub: gen_sub(dst, src1, src2); break;
-					case Mul: gen_mul(dst, src1, src2); break;
-					case Div: gen_div(dst, src1, src2); break;
-					default:
-						throw cybozu::Exception("bad op") << j << v.v;
-					}
+		const int zero = getValIdx(0);
+		const int k = isDouble() ? 54 : 24;
+		const double minNormal = isDouble() ? DBL_MIN : FLT_MIN;
+		IndexRangeManager ftr(funcTmpReg_);
+		const int s = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int c = ftr2.allocIdx();
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_setVal(c, minNormal);
+				gen_setVal(t, -k * 0.6931471805599453);
+				gen_cmpSelect(s + i, CmpLt, inout + i, c, t, zero);
+				gen_setVal(t, std::ldexp(1.0, k));
+				gen_mul(t, inout + i, t);
+				gen_cmpSelect(inout + i, CmpLt, inout + i, c, t, inout + i);
+			}
+		}
+		gen_log(inout, n);
+		LP_(i, n) gen_add(inout + i, inout + i, s + i);
+	}
+	// log1p(x) for all x
+	void gen_log1pSpecial(int inout, int n) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int x = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(x + i, inout + i);
+		gen_log1p(inout, n);
+		gen_logSpecial(inout, x, n, -1);
+	}
+	// log_b(x) for all x ; log(x) itself does not care about the special values for speed
+	void gen_logBaseSpecial(int inout, int n, int base) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int x = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(x + i, inout + i);
+		gen_logBase(inout, n, base);
+		gen_logSpecial(inout, x, n, 0);
+	}
+	/*
+		tanh(x) = expm1(2x) / (expm1(2x) + 2)
+		x is clamped to [-20, 20] because tanh(20) = 1 - 8e-18
+		cmpSelect is used instead of max and min to keep NaN
+	*/
+	void gen_tanh(int inout, int n) // not virtual
+	{
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const int lo = getValTmpIdx(ftr, -20);
+			const int hi = getValTmpIdx(ftr, 20);
+			LP_(i, n) {
+				gen_cmpSelect(inout + i, CmpLt, inout + i, lo, lo, inout + i);
+				gen_cmpSelect(inout + i, CmpGt, inout + i, hi, hi, inout + i);
+			}
+		}
+		LP_(i, n) gen_add(inout + i, inout + i, inout + i);
+		gen_expm1(inout, n);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int two = getValTmpIdx(ftr, 2);
+		const int t = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_add(t + i, inout + i, two);
+		LP_(i, n) gen_div(inout + i, inout + i, t + i);
+	}
+	/*
+		X = exp(|x| - h) for h = 0.693359375 (log 2 rounded to 9 bits) not to overflow before sinh(x) does
+		sinh(x) = copysign(k (X - c/X), x) for |x| >= 1, k = exp(h)/2 and c = 1/(4k^2)
+		sinh(x) = x (1 + x^2/3! + x^4/5! + ...) for |x| < 1 to avoid the cancellation
+		cosh(x) = k (X + c/X) is also set to co if co >= 0
+		c/X is a division because the inverse of inf by gen_inv is NaN
+	*/
+	void gen_sinhCosh(int inout, int co, int n) // not virtual
+	{
+		static const double tbl[] = {
+			1.0, 1.0 / 6, 1.0 / 120, 1.0 / 5040, 1.0 / 362880, 1.0 / 39916800,
+			1.0 / 6227020800.0, 1.0 / 1307674368000.0, 1.0 / 355687428096000.0,
+		};
+		const double h = 0.693359375;
+		const double k = std::exp(h) * 0.5;
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int e = allocTmpIdx(ftr, n);
+		const int w = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int hh = getValTmpIdx(ftr2, h);
+			LP_(i, n) {
+				gen_abs(e + i, inout + i);
+				gen_sub(e + i, e + i, hh);
+			}
+		}
+		gen_exp(e, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int c = getValTmpIdx(ftr2, 0.25 / (k * k));
+			const int kk = getValTmpIdx(ftr2, k);
+			LP_(i, n) {
+				gen_div(w + i, c, e + i);
+				if (co >= 0) {
+					gen_add(co + i, e + i, w + i);
+					gen_mul(co + i, co + i, kk);
 				}
-				stackPos -= unrollN;
-				break;
-			case Func:
-				{
+				gen_sub(e + i, e + i, w + i);
+				gen_mul(e + i, e + i, kk);
+			}
+		}
+		const int p = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_mul(w + i, inout + i, inout + i);
+		// the error of the series is less than 2^-26 (2^-55 for double) for |x| < 1
+		gen_horner(p, w, n, tbl, isDouble() ? 9 : 6);
+		LP_(i, n) {
+			gen_mul(p + i, p + i, inout + i);
+			gen_abs(w + i, inout + i);
+			gen_copysign(e + i, e + i, inout + i);
+			gen_cmpSelect(inout + i, CmpLt, w + i, one, p + i, e + i);
+		}
+	}
+	void gen_sinh(int inout, int n) // not virtual
+	{
+		gen_sinhCosh(inout, -1, n);
+	}
+	/*
+		t = log1p(t) * scale for t such that 1 + t != 1 or t = 0
+		log1p(t) = log(u) t/(u - 1) for u = 1 + t as gen_log1p
+		but only t and t/(u - 1) are kept during log to save registers
+		t/(u - 1) is 1 if u - 1 = t to avoid inf/inf
+	*/
+	void gen_log1pScale(int t, int n, double scale) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int c = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int s = getValTmpIdx(ftr2, scale);
+			const int q = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_add(c + i, t + i, one);
+				gen_sub(c + i, c + i, one);
+				gen_div(q, t + i, c + i);
+				gen_cmpSelect(c + i, CmpEq, c + i, t + i, one, q);
+				gen_mul(c + i, c + i, s);
+				gen_add(t + i, t + i, one);
+			}
+		}
+		gen_log(t, n);
+		LP_(i, n) gen_mul(t + i, t + i, c + i);
+	}
+	// the threshold s such that f(x) = x for |x| < s and f(x) = x + O(x^3) such as asinh and atanh
+	double getOddLinearMax() const
+	{
+		return isDouble() ? 1.0 / (1 << 27) : 1.0 / (1 << 13);
+	}
+	/*
+		asinh(x) = copysign(log1p(t), x) for a = |x|
+		t = a + a^2/(1 + sqrt(1 + a^2)) for a <= 2^28
+		asinh(x) = copysign(log(a) + log(2), x) for a > 2^28 to avoid the overflow of a^2 and 2a
+		because asinh(a) = log(2a) + O(1/a^2) and log(a) = log1p(a - 1)
+		asinh(x) = x for a small a (see getOddLinearMax) and x = +-inf because gen_log(inf) is finite
+	*/
+	void gen_asinh(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int big = setValTmpIdx(ftr2, 268435456.0); // 2^28
+			const int small = setValTmpIdx(ftr2, getOddLinearMax());
+			const int a = ftr2.allocIdx();
+			const int u = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_abs(a, inout + i);
+				gen_mul(u, a, a);
+				gen_add(t + i, u, one);
+				gen_sqrt(t + i, t + i);
+				gen_add(t + i, t + i, one);
+				gen_div(u, u, t + i);
+				gen_add(u, u, a);
+				gen_sub(t + i, a, one);
+				gen_cmpSelect(t + i, CmpGt, a, big, t + i, u);
+				// avoid 1 + t = 1 in gen_log1pScale
+				gen_cmpSelect(t + i, CmpLt, a, small, one, t + i);
+			}
+		}
+		gen_log1pScale(t, n, 1);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int small = setValTmpIdx(ftr2, getOddLinearMax());
+		const int big = setValTmpIdx(ftr2, 268435456.0); // 2^28
+		const int ln2 = setValTmpIdx(ftr2, 0.6931471805599453); // log(2)
+		const int inf = setValTmpIdx(ftr2, HUGE_VAL);
+		const int a = ftr2.allocIdx();
+		const int u = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_abs(a, inout + i);
+			gen_add(u, t + i, ln2);
+			gen_cmpSelect(t + i, CmpGt, a, big, u, t + i);
+			gen_cmpSelect(t + i, CmpEq, a, inf, a, t + i);
+			gen_copysign(t + i, t + i, inout + i);
+			gen_cmpSelect(inout + i, CmpLt, a, small, inout + i, t + i);
+		}
+	}
+	/*
+		acosh(x) = log1p(t + sqrt(t (t + 2))) for t = x - 1 and x <= 2^28
+		acosh(x) = log1p(t) + log(2) for x > 2^28 (see gen_asinh)
+		acosh(x) = NaN for x < 1 and inf for x = inf
+	*/
+	void gen_acosh(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int big = getValTmpIdx(ftr2, 268435456.0); // 2^28
+			const int two = getValTmpIdx(ftr2, 2);
+			const int u = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_sub(t + i, inout + i, one);
+				gen_add(u, t + i, two);
+				gen_mul(u, u, t + i);
+				gen_sqrt(u, u);
+				gen_add(u, u, t + i);
+				gen_cmpSelect(t + i, CmpGt, inout + i, big, t + i, u);
+			}
+		}
+		gen_log1pScale(t, n, 1);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int big = getValTmpIdx(ftr2, 268435456.0); // 2^28
+		const int ln2 = getValTmpIdx(ftr2, 0.6931471805599453); // log(2)
+		const int inf = getValTmpIdx(ftr2, HUGE_VAL);
+		const int nan = ftr2.allocIdx();
+		const int u = ftr2.allocIdx();
+		gen_setVal(nan, std::numeric_limits<double>::quiet_NaN());
+		LP_(i, n) {
+			gen_add(u, t + i, ln2);
+			gen_cmpSelect(t + i, CmpGt, inout + i, big, u, t + i);
+			gen_cmpSelect(t + i, CmpEq, inout + i, inf, inout + i, t + i);
+			gen_cmpSelect(inout + i, CmpLt, inout + i, one, nan, t + i);
+		}
+	}
+	/*
+		atanh(x) = copysign(log1p(2a/(1 - a))/2, x) for a = |x| < 1
+		atanh(x) = copysign(inf, x) for a = 1 and NaN for a > 1
+		atanh(x) = x for a small a (see getOddLinearMax)
+	*/
+	void gen_atanh(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int small = setValTmpIdx(ftr2, getOddLinearMax());
+			const int a = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_abs(a, inout + i);
+				gen_sub(t + i, one, a);
+				gen_div(t + i, a, t + i);
+				gen_add(t + i, t + i, t + i);
+				gen_cmpSelect(t + i, CmpLt, a, small, one, t + i);
+			}
+		}
+		gen_log1pScale(t, n, 0.5);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int inf = setValTmpIdx(ftr2, HUGE_VAL);
+		const int nan = setValTmpIdx(ftr2, std::numeric_limits<double>::quiet_NaN());
+		const int small = setValTmpIdx(ftr2, getOddLinearMax());
+		const int a = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_abs(a, inout + i);
+			gen_cmpSelect(t + i, CmpEq, a, one, inf, t + i);
+			gen_cmpSelect(t + i, CmpGt, a, one, nan, t + i);
+			gen_copysign(t + i, t + i, inout + i);
+			gen_cmpSelect(inout + i, CmpLt, a, small, inout + i, t + i);
+		}
+	}
+	/*
+		sigmoid(x) = 1 / (1 + exp(-x))
+		use div instead of inv because exp(-x) may be inf
+	*/
+	void gen_sigmoid(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		gen_neg(inout, n);
+		gen_exp(inout, n);
+		LP_(i, n) gen_add(inout + i, inout + i, one);
+		LP_(i, n) gen_div(inout + i, one, inout + i);
+	}
+	// softplus(x) = log(1 + exp(x)) = (x < 0 ? 0 : x) + log1p(exp(-|x|))
+	void gen_softplus(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_abs(t + i, inout + i);
+		gen_neg(t, n);
+		gen_exp(t, n);
+		gen_log1p(t, n);
+		LP_(i, n) gen_cmpSelect(inout + i, CmpLt, inout + i, zero, zero, inout + i);
+		LP_(i, n) gen_add(inout + i, inout + i, t + i);
+	}
+	/*
+		relu(x) = x <= 0 ? 0 : x
+		the activations keep NaN, so relu(NaN) is NaN
+	*/
+	void gen_relu(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		LP_(i, n) gen_cmpSelect(inout + i, CmpLe, inout + i, zero, zero, inout + i);
+	}
+	// dst = x < 0 ? a * x : x ; dst may be equal to x or a
+	void gen_leaky_relu(int dst, int x, int a) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = ftr.allocIdx();
+		gen_mul(t, x, a);
+		gen_cmpSelect(dst, CmpLt, x, zero, t, x);
+	}
+	/*
+		elu(x) = x > 0 ? x : exp(x) - 1 = x <= 0 ? expm1(t) : x
+		where t = x clamped to [-40, 0]
+		cmpSelect is used instead of max and min to keep NaN
+	*/
+	void gen_elu(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int lo = getValTmpIdx(ftr2, -40);
+			LP_(i, n) {
+				gen_cmpSelect(t + i, CmpLt, inout + i, lo, lo, inout + i);
+				gen_cmpSelect(t + i, CmpGt, t + i, zero, zero, t + i);
+			}
+		}
+		gen_expm1(t, n);
+		LP_(i, n) gen_cmpSelect(inout + i, CmpLe, inout + i, zero, t + i, inout + i);
+	}
+	// silu(x) = x * sigmoid(x) = x / (1 + exp(-x))
+	void gen_silu(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(t + i, inout + i);
+		gen_neg(t, n);
+		gen_exp(t, n);
+		LP_(i, n) gen_add(t + i, t + i, one);
+		LP_(i, n) gen_div(inout + i, inout + i, t + i);
+	}
+	/*
+		mish(x) = x * tanh(softplus(x)) = x * u / (u + 2)
+		where e = exp(x), u = e * (e + 2)
+		x is clamped to (..., 20] in exp because tanh(softplus(20)) = 1 - 8e-18
+		cmpSelect is used instead of min to keep NaN
+	*/
+	void gen_mish(int inout, int n) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		const int u = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int hi = getValTmpIdx(ftr2, 20);
+			LP_(i, n) gen_cmpSelect(t + i, CmpGt, inout + i, hi, hi, inout + i);
+		}
+		gen_exp(t, n);
+		const int two = getValTmpIdx(ftr, 2);
+		LP_(i, n) gen_add(u + i, t + i, two);
+		LP_(i, n) gen_mul(t + i, t + i, u + i);
+		LP_(i, n) gen_add(u + i, t + i, two);
+		LP_(i, n) gen_div(t + i, t + i, u + i);
+		LP_(i, n) gen_mul(inout + i, inout + i, t + i);
+	}
+	/*
+		y = c[N-1] x^(N-1) + ... + c[1] x + c[0] by Horner's method
+		y must not be x
+		the coefficients are always loaded from the data area to save registers
+	*/
+	template<class T>
+	void gen_horner(int y, int x, int n, const T *c, int N) // not virtual
+	{
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const int t = setValTmpIdx(ftr, c[N - 1]);
+			LP_(i, n) gen_copy(y + i, t);
+		}
+		for (int j = N - 2; j >= 0; j--) {
+			IndexRangeManager ftr(funcTmpReg_);
+			const int t = setValTmpIdx(ftr, c[j]);
+			LP_(i, n) gen_fmadd(y + i, y + i, x + i, t);
+		}
+	}
+	/*
+		y = c[N-1] x^(N-1) + ... + c[0] by Estrin's scheme
+		y = P_lo(x) + x^m P_hi(x) for the max m = 2^k < N recursively
+		pw[k - 1] = x^(2^k) and y must not be x
+	*/
+	template<class T>
+	void gen_estrin(int y, int x, int n, const int *pw, const T *c, int N) // not virtual
+	{
+		if (N <= 2) {
+			LP_(i, n) gen_setVal(y + i, c[0]);
+			if (N == 2) {
+				IndexRangeManager ftr(funcTmpReg_);
+				const int t = setValTmpIdx(ftr, c[1]);
+				LP_(i, n) gen_fmadd(y + i, x + i, t, y + i);
+			}
+			return;
+		}
+		int k = 0;
+		int m = 2;
+		while (m * 2 < N) {
+			m *= 2;
+			k++;
+		}
+		IndexRangeManager ftr(funcTmpReg_);
+		const int hi = allocTmpIdx(ftr, n);
+		gen_estrin(y, x, n, pw, c, m);
+		gen_estrin(hi, x, n, pw, c + m, N - m);
+		LP_(i, n) gen_fmadd(y + i, pw[k] + i, hi + i, y + i);
+	}
+	/*
+		inout = poly(inout, c[0], ..., c[N-1]) = c[N-1] x^(N-1) + ... + c[0]
+		the coefficients are loaded from the data area as gen_horner
+	*/
+	void gen_poly(int inout, int n, const std::vector<double>& c) // not virtual
+	{
+		const int N = int(c.size());
+		IndexRangeManager ftr(funcTmpReg_);
+		const int y = allocTmpIdx(ftr, n);
+		if (opt.polyMode == PolyEstrin && N > 2) {
+			// x^2, x^4, ...
+			int pw[32];
+			int powN = 0;
+			for (int m = 2; m < N; m *= 2) {
+				pw[powN] = allocTmpIdx(ftr, n);
+				const int a = powN == 0 ? inout : pw[powN - 1];
+				LP_(i, n) gen_mul(pw[powN] + i, a + i, a + i);
+				powN++;
+			}
+			gen_estrin(y, inout, n, pw, &c[0], N);
+		} else {
+			gen_horner(y, inout, n, &c[0], N);
+		}
+		LP_(i, n) gen_copy(inout + i, y + i);
+	}
+	/*
+		erfc(z) for z = inout >= 0 (see ErfTbl)
+		z is clamped to [0, 30] because erfc(27.3) < the min denormal of double
+		cmpSelect is used instead of min to keep NaN
+	*/
+	void gen_erfcAbs(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int u = allocTmpIdx(ftr, n);
+		const int w = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int hi = getValTmpIdx(ftr2, 30);
+			LP_(i, n) gen_cmpSelect(inout + i, CmpGt, inout + i, hi, hi, inout + i);
+			const int two = getValTmpIdx(ftr2, 2);
+			LP_(i, n) gen_sub(u + i, two, inout + i);
+			LP_(i, n) gen_add(w + i, two, inout + i);
+		}
+		LP_(i, n) gen_div(u + i, u + i, w + i);
+		if (isDouble()) {
+			gen_horner(w, u, n, g_erfTblD.erfcCoef, g_erfTblD.erfcN);
+		} else {
+			gen_horner(w, u, n, g_erfTbl.erfcCoef, g_erfTbl.erfcN);
+		}
+		LP_(i, n) gen_fnmadd(inout + i, inout + i, inout + i, w + i);
+		gen_exp(inout, n);
+		LP_(i, n) gen_add(u + i, u + i, one);
+		LP_(i, n) gen_mul(inout + i, inout + i, u + i);
+	}
+	// erfc(x) = x >= 0 ? erfc(|x|) : 2 - erfc(|x|)
+	void gen_erfc(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int s = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(s + i, inout + i);
+		LP_(i, n) gen_abs(inout + i, inout + i);
+		gen_erfcAbs(inout, n);
+		const int two = getValTmpIdx(ftr, 2);
+		const int t = ftr.allocIdx();
+		LP_(i, n) {
+			gen_sub(t, two, inout + i);
+			gen_cmpSelect(inout + i, CmpLt, s + i, zero, t, inout + i);
+		}
+	}
+	/*
+		erf(x) = x P(x^2) if |x| < 1
+		erf(x) = x >= 0 ? 1 - erfc(|x|) : erfc(|x|) - 1 otherwise
+	*/
+	void gen_erf(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int s = allocTmpIdx(ftr, n);
+		const int q = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(s + i, inout + i);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int x2 = allocTmpIdx(ftr2, n);
+			LP_(i, n) gen_mul(x2 + i, s + i, s + i);
+			if (isDouble()) {
+				gen_horner(q, x2, n, g_erfTblD.erfCoef, g_erfTblD.erfN);
+			} else {
+				gen_horner(q, x2, n, g_erfTbl.erfCoef, g_erfTbl.erfN);
+			}
+			LP_(i, n) gen_mul(q + i, q + i, s + i);
+		}
+		LP_(i, n) gen_abs(inout + i, inout + i);
+		gen_erfcAbs(inout, n);
+		const int t1 = ftr.allocIdx();
+		const int t2 = ftr.allocIdx();
+		LP_(i, n) {
+			gen_sub(t1, one, inout + i);
+			gen_sub(t2, inout + i, one);
+			gen_cmpSelect(inout + i, CmpLt, s + i, zero, t2, t1);
+			gen_abs(t1, s + i);
+			gen_cmpSelect(inout + i, CmpLt, t1, one, q + i, inout + i);
+		}
+	}
+	// normcdf(x) = erfc(-x/sqrt(2)) / 2
+	void gen_normcdf(int inout, int n) // not virtual
+	{
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const int c = getValTmpIdx(ftr, -1 / std::sqrt(2.0));
+			LP_(i, n) gen_mul(inout + i, inout + i, c);
+		}
+		gen_erfc(inout, n);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int half = getValTmpIdx(ftr, 0.5);
+		LP_(i, n) gen_mul(inout + i, inout + i, half);
+	}
+	// gelu(x) = x normcdf(x)
+	void gen_gelu(int inout, int n) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(t + i, inout + i);
+		gen_normcdf(t, n);
+		LP_(i, n) gen_mul(inout + i, inout + i, t + i);
+	}
+	/*
+		gelu_tanh(x) = x (1 + tanh(sqrt(2/pi) (x + 0.044715 x^3))) / 2
+		= x / (1 + exp(a x + b x^3)) ; a = -2 sqrt(2/pi), b = 0.044715 a
+	*/
+	void gen_gelu_tanh(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		const double a = -2 * 0.79788456080286536; // -2 sqrt(2/pi)
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_mul(t + i, inout + i, inout + i);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int ca = getValTmpIdx(ftr2, a);
+			const int cb = getValTmpIdx(ftr2, a * 0.044715);
+			LP_(i, n) gen_fmadd(t + i, t + i, cb, ca);
+		}
+		LP_(i, n) gen_mul(t + i, t + i, inout + i);
+		gen_exp(t, n);
+		LP_(i, n) gen_add(t + i, t + i, one);
+		LP_(i, n) gen_div(inout + i, inout + i, t + i);
+	}
+	/*
+		x = num(r)/den(r) by the coefficients in ascending order
+		x and r must be different
+	*/
+	template<class T>
+	void gen_rational(int x, int r, int n, const T *num, int numN, const T *den, int denN) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = allocTmpIdx(ftr, n);
+		gen_horner(x, r, n, num, numN);
+		gen_horner(t, r, n, den, denN);
+		LP_(i, n) gen_div(x + i, x + i, t + i);
+	}
+	/*
+		norminv(p) = the inverse of normcdf by AS241 (see NormInvTbl)
+		q = p - 1/2
+		norminv(p) = q a(r)/b(r) for |q| <= 0.425 where r = 0.180625 - q^2
+		otherwise r = sqrt(-log(min(p, 1 - p))) and log supports denormal p
+		norminv(p) = copysign(c(r - 1.6)/d(r - 1.6), q) for r <= 5 and copysign(e(r - 5)/f(r - 5), q) for r > 5
+		norminv(0) = -inf, norminv(1) = inf and NaN for p outside [0, 1]
+	*/
+	template<class Tbl>
+	void gen_normInvT(const Tbl& tbl, int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int r = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int half = getValTmpIdx(ftr2, 0.5);
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_sub(t, one, inout + i);
+				gen_cmpSelect(r + i, CmpLt, inout + i, half, inout + i, t);
+			}
+		}
+		gen_logDenormal(r, n);
+		LP_(i, n) {
+			gen_sub(r + i, zero, r + i);
+			gen_sqrt(r + i, r + i);
+		}
+		const int x = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int u = allocTmpIdx(ftr2, n);
+			{
+				IndexRangeManager ftr3(funcTmpReg_);
+				const int c = getValTmpIdx(ftr3, 1.6);
+				LP_(i, n) gen_sub(u + i, r + i, c);
+			}
+			gen_rational(x, u, n, tbl.c, tbl.cN, tbl.d, tbl.dN);
+			// the tail for r > 5 (p < 1.4e-11) is rare
+			const int five = setValTmpIdx(ftr2, 5);
+			{
+				IndexRangeManager ftr3(funcTmpReg_);
+				const int a = ftr3.allocIdx();
+				gen_copy(a, zero);
+				LP_(i, n) gen_cmpSelect(a, CmpGt, r + i, a, r + i, a);
+				gen_beginSkip(CmpGt, a, five);
+			}
+			{
+				const int e = allocTmpIdx(ftr2, n);
+				LP_(i, n) gen_sub(u + i, r + i, five);
+				gen_rational(e, u, n, tbl.e, tbl.eN, tbl.f, tbl.fN);
+				LP_(i, n) gen_cmpSelect(x + i, CmpGt, r + i, five, e + i, x + i);
+			}
+			gen_endSkip();
+		}
+		// r is reused for the central region
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int q = allocTmpIdx(ftr2, n);
+			{
+				IndexRangeManager ftr3(funcTmpReg_);
+				const int half = getValTmpIdx(ftr3, 0.5);
+				const int c = getValTmpIdx(ftr3, 0.180625);
+				LP_(i, n) {
+					gen_sub(q + i, inout + i, half);
+					gen_copysign(x + i, x + i, q + i);
+					gen_fnmadd(r + i, q + i, q + i, c);
+				}
+			}
+			const int y = allocTmpIdx(ftr2, n);
+			gen_rational(y, r, n, tbl.a, tbl.aN, tbl.b, tbl.bN);
+			IndexRangeManager ftr3(funcTmpReg_);
+			const int c = getValTmpIdx(ftr3, 0.425);
+			const int t = ftr3.allocIdx();
+			LP_(i, n) {
+				gen_mul(y + i, y + i, q + i);
+				gen_abs(t, q + i);
+				gen_cmpSelect(x + i, CmpLe, t, c, y + i, x + i);
+			}
+		}
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int inf = setValTmpIdx(ftr2, HUGE_VAL);
+		const int t = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_cmpSelect(x + i, CmpEq, inout + i, one, inf, x + i);
+			gen_sub(t, zero, inf);
+			gen_cmpSelect(x + i, CmpEq, inout + i, zero, t, x + i);
+			gen_setVal(t, std::numeric_limits<double>::quiet_NaN());
+			gen_cmpSelect(x + i, CmpLt, inout + i, zero, t, x + i);
+			gen_cmpSelect(x + i, CmpGt, inout + i, one, t, x + i);
+			gen_cmpSelect(inout + i, CmpEq, inout + i, inout + i, x + i, inout + i);
+		}
+	}
+	void gen_normInv(int inout, int n) // not virtual
+	{
+		if (isDouble()) {
+			gen_normInvT(g_normInvTblD, inout, n);
+		} else {
+			gen_normInvT(g_normInvTbl, inout, n);
+		}
+	}
+	/*
+		z = z + k and d = d z (z + 1) ... (z + k - 1) for the min k >= 0 such that z + k >= tbl.shiftN
+		num/d is also updated to num/d + 1/z + ... + 1/(z + k - 1) if num >= 0
+	*/
+	template<class Tbl>
+	void gen_gammaShift(const Tbl& tbl, int z, int d, int num, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int c = setValTmpIdx(ftr, tbl.shiftN);
+		{
+			// skip it if z >= shiftN for all elements ; cmpSelect ignores NaN
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int a = ftr2.allocIdx();
+			gen_copy(a, c);
+			LP_(i, n) gen_cmpSelect(a, CmpLt, z + i, a, z + i, a);
+			gen_beginSkip(CmpLt, a, c);
+		}
+		const int t = ftr.allocIdx();
+		for (int j = 0; j < tbl.shiftN; j++) {
+			LP_(i, n) {
+				if (num >= 0) {
+					gen_fmadd(t, num + i, z + i, d + i);
+					gen_cmpSelect(num + i, CmpLt, z + i, c, t, num + i);
+				}
+				gen_mul(t, d + i, z + i);
+				gen_cmpSelect(d + i, CmpLt, z + i, c, t, d + i);
+				gen_add(t, z + i, one);
+				gen_cmpSelect(z + i, CmpLt, z + i, c, t, z + i);
+			}
+		}
+		gen_endSkip();
+	}
+	// z = (x < 0) ? 1 - x : x for the reflection formulas
+	void gen_gammaReflectArg(int z, int x, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = ftr.allocIdx();
+		LP_(i, n) {
+			gen_sub(t, one, x + i);
+			gen_cmpSelect(z + i, CmpLt, x + i, zero, t, x + i);
+		}
+	}
+	/*
+		skip the code until gen_endSkip() if x >= 0 for all elements
+		s = pi (x - round(x)) is set for sin(pi x) or tan(pi x)
+	*/
+	void gen_gammaBeginNeg(int s, int x, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const int a = ftr.allocIdx();
+			gen_copy(a, zero);
+			LP_(i, n) gen_cmpSelect(a, CmpLt, x + i, a, x + i, a);
+			gen_beginSkip(CmpLt, a, zero);
+		}
+		IndexRangeManager ftr(funcTmpReg_);
+		const int pi = getValTmpIdx(ftr, 3.1415926535897932);
+		LP_(i, n) {
+			gen_round(s + i, x + i, RoundEven);
+			gen_sub(s + i, x + i, s + i);
+			gen_mul(s + i, s + i, pi);
+		}
+	}
+	/*
+		lgamma(x) = S(z) - log(d) for x >= 0 where S(z) = lgamma(z) by the asymptotic series (see GammaTbl)
+		z = x + k and d = x (x + 1) ... (x + k - 1) by gen_gammaShift
+		lgamma(x) = log(pi) - S(z) + log(d/|sin(pi x)|) for x < 0 by lgamma(x) + lgamma(1 - x) = log(pi/|sin(pi x)|)
+		where z and d are given for 1 - x and d starts from 1/|sin(pi x)|
+		lgamma(x) = -log|x| for |x| < 2^-32 (2^-64 for double) because gamma x is below the precision
+		where 1/|sin(pi x)| and d may overflow or be denormal
+		lgamma(x) = inf for x = 0, -1, -2, ... and +-inf
+		the absolute error is small but the relative one is large around the zeros x = 1 and 2
+	*/
+	template<class Tbl>
+	void gen_lgammaT(const Tbl& tbl, int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int d = allocTmpIdx(ftr, n);
+		// compute sin before z is allocated to save registers
+		LP_(i, n) gen_copy(d + i, one);
+		gen_gammaBeginNeg(d, inout, n);
+		gen_sin(d, n);
+		LP_(i, n) {
+			gen_abs(d + i, d + i);
+			gen_div(d + i, one, d + i);
+			gen_cmpSelect(d + i, CmpLt, inout + i, zero, d + i, one);
+		}
+		gen_endSkip();
+		const int z = allocTmpIdx(ftr, n);
+		gen_gammaReflectArg(z, inout, n);
+		gen_gammaShift(tbl, z, d, -1, n);
+		gen_log(d, n);
+		{
+			// d = P(w)/z - z + log(2 pi)/2 - log(d)
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int iz = allocTmpIdx(ftr2, n);
+			const int w = allocTmpIdx(ftr2, n);
+			const int p = allocTmpIdx(ftr2, n);
+			LP_(i, n) {
+				gen_div(iz + i, one, z + i);
+				gen_mul(w + i, iz + i, iz + i);
+			}
+			gen_horner(p, w, n, tbl.lgammaCoef, tbl.lgammaN);
+			IndexRangeManager ftr3(funcTmpReg_);
+			const int c = getValTmpIdx(ftr3, 0.91893853320467274); // log(2 pi)/2
+			LP_(i, n) {
+				gen_sub(d + i, c, d + i);
+				gen_sub(d + i, d + i, z + i);
+				gen_fmadd(d + i, p + i, iz + i, d + i);
+			}
+		}
+		{
+			// d += (z - 1/2) log(z)
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int u = allocTmpIdx(ftr2, n);
+			{
+				IndexRangeManager ftr3(funcTmpReg_);
+				const int half = getValTmpIdx(ftr3, 0.5);
+				LP_(i, n) {
+					gen_copy(u + i, z + i);
+					gen_sub(z + i, z + i, half);
+				}
+			}
+			gen_log(u, n);
+			LP_(i, n) gen_fmadd(d + i, z + i, u + i, d + i);
+		}
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int logPi = getValTmpIdx(ftr2, 1.1447298858494002);
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_sub(t, logPi, d + i);
+				gen_cmpSelect(d + i, CmpLt, inout + i, zero, t, d + i);
+			}
+		}
+		{
+			// z is reused for the tail for a tiny |x|, which is rare
+			const double tiny = isDouble() ? 1.0 / 18446744073709551616.0 : 1.0 / 4294967296.0;
+			{
+				IndexRangeManager ftr2(funcTmpReg_);
+				const int c = setValTmpIdx(ftr2, tiny);
+				const int a = ftr2.allocIdx();
+				gen_copy(a, c);
+				LP_(i, n) {
+					gen_abs(z + i, inout + i);
+					gen_cmpSelect(a, CmpLt, z + i, a, z + i, a);
+				}
+				gen_beginSkip(CmpLt, a, c);
+			}
+			gen_logDenormal(z, n);
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int c = setValTmpIdx(ftr2, tiny);
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_sub(z + i, zero, z + i);
+				gen_abs(t, inout + i);
+				gen_cmpSelect(d + i, CmpLt, t, c, z + i, d + i);
+			}
+			gen_endSkip();
+		}
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int inf = setValTmpIdx(ftr2, HUGE_VAL);
+		const int t = ftr2.allocIdx();
+		LP_(i, n) {
+			// poles
+			gen_round(t, inout + i, RoundEven);
+			gen_cmpSelect(t, CmpEq, t, inout + i, inf, d + i);
+			gen_cmpSelect(d + i, CmpLe, inout + i, zero, t, d + i);
+			gen_abs(t, inout + i);
+			gen_cmpSelect(inout + i, CmpEq, t, inf, inf, d + i);
+		}
+	}
+	void gen_lgamma(int inout, int n) // not virtual
+	{
+		if (isDouble()) {
+			gen_lgammaT(g_gammaTblD, inout, n);
+		} else {
+			gen_lgammaT(g_gammaTbl, inout, n);
+		}
+	}
+	/*
+		digamma(x) = log(z) - 1/(2z) - w Q(w) - num/d for x >= 0 where w = 1/z^2 (see GammaTbl)
+		z = x + k and num/d = 1/x + ... + 1/(x + k - 1) by gen_gammaShift
+		digamma(x) = digamma(1 - x) - pi/tan(pi x) for x < 0 where num/d starts from pi/tan(pi x)
+		digamma(x) = NaN for x = 0, -1, -2, ... and -inf
+		the absolute error is small but the relative one is large around the zero x = 1.4616...
+	*/
+	template<class Tbl>
+	void gen_digammaT(const Tbl& tbl, int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int d = allocTmpIdx(ftr, n);
+		// compute tan before num and z are allocated to save registers
+		LP_(i, n) gen_copy(d + i, one);
+		gen_gammaBeginNeg(d, inout, n);
+		gen_tan(d, n);
+		LP_(i, n) gen_cmpSelect(d + i, CmpLt, inout + i, zero, d + i, one);
+		gen_endSkip();
+		const int num = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int pi = getValTmpIdx(ftr2, 3.1415926535897932);
+			LP_(i, n) gen_cmpSelect(num + i, CmpLt, inout + i, zero, pi, zero);
+		}
+		const int z = allocTmpIdx(ftr, n);
+		gen_gammaReflectArg(z, inout, n);
+		gen_gammaShift(tbl, z, d, num, n);
+		{
+			// num = num/d + 1/(2z) + w Q(w)
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int w = allocTmpIdx(ftr2, n);
+			const int q = allocTmpIdx(ftr2, n);
+			{
+				IndexRangeManager ftr3(funcTmpReg_);
+				const int half = getValTmpIdx(ftr3, 0.5);
+				LP_(i, n) {
+					gen_div(num + i, num + i, d + i);
+					gen_div(w + i, one, z + i);
+					gen_fmadd(num + i, w + i, half, num + i);
+					gen_mul(w + i, w + i, w + i);
+				}
+			}
+			gen_horner(q, w, n, tbl.digammaCoef, tbl.digammaN);
+			LP_(i, n) gen_fmadd(num + i, q + i, w + i, num + i);
+		}
+		gen_log(z, n);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int inf = setValTmpIdx(ftr2, HUGE_VAL);
+		const int t = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_sub(z + i, z + i, num + i);
+			gen_cmpSelect(z + i, CmpEq, inout + i, inf, inf, z + i);
+			// poles
+			gen_setVal(t, std::numeric_limits<double>::quiet_NaN());
+			gen_round(num + i, inout + i, RoundEven);
+			gen_cmpSelect(t, CmpEq, num + i, inout + i, t, z + i);
+			gen_cmpSelect(inout + i, CmpLe, inout + i, zero, t, z + i);
+		}
+	}
+	void gen_digamma(int inout, int n) // not virtual
+	{
+		if (isDouble()) {
+			gen_digammaT(g_gammaTblD, inout, n);
+		} else {
+			gen_digammaT(g_gammaTbl, inout, n);
+		}
+	}
+	// v = v - round(v) using t
+	void gen_mod1(int v, int t) // not virtual
+	{
+		gen_round(t, v, RoundEven);
+		gen_sub(v, v, t);
+	}
+	/*
+		TwoSum ; s + lo = s + b (or s - b if sub) without rounding errors
+		s and t1 are swapped and b and t2 are destroyed
+	*/
+	void gen_twoSum(int& s, int& t1, int t2, int lo, int b, bool sub) // not virtual
+	{
+		if (sub) {
+			gen_sub(t1, s, b);
+			gen_sub(t2, t1, s);
+			gen_add(b, b, t2);
+		} else {
+			gen_add(t1, s, b);
+			gen_sub(t2, t1, s);
+			gen_sub(b, b, t2);
+		}
+		gen_sub(t2, t1, t2);
+		gen_sub(s, s, t2);
+		if (sub) {
+			gen_sub(s, s, b);
+		} else {
+			gen_add(s, s, b);
+		}
+		gen_add(lo, lo, s);
+		std::swap(s, t1);
+	}
+	/*
+		the Payne-Hanek reduction of one register for |x| > fastMax
+		x/(2pi) = sum_i x inv2pi[i] modulo 1 is kept in s + lo by TwoSum,
+		where x inv2pi[i] = h + l exactly by fma
+		and each h and l is reduced modulo 1 before the addition
+		q and r are overwritten only if |x| > fastMax, x is destroyed
+		and c is a tmp register
+	*/
+	template<class Tbl>
+	void gen_trigReduceLarge(const Tbl& tbl, int q, int r, int x, int c) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		int s = ftr.allocIdx();
+		int t1 = ftr.allocIdx();
+		const int lo = ftr.allocIdx();
+		const int h = ftr.allocIdx();
+		gen_copy(s, zero);
+		gen_copy(lo, zero);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int l = ftr2.allocIdx();
+			for (int i = 0; i < Tbl::inv2piN; i++) {
+				if (i == Tbl::scaleIdx) {
+					gen_setVal(c, tbl.scale);
+					gen_mul(x, x, c);
+				}
+				gen_setVal(c, tbl.inv2pi[i]);
+				gen_mul(h, x, c);
+				gen_fnmadd(l, x, c, h); // l = h - x c
+				gen_mod1(h, t1);
+				gen_mod1(l, t1);
+				// c is used as a tmp register of TwoSum
+				gen_twoSum(s, t1, c, lo, h, false);
+				gen_twoSum(s, t1, c, lo, l, true);
+			}
+		}
+		// x/(pi/2) = 4(s + lo) = q + f + 4lo ; r = (f + 4lo) pi/2
+		gen_mod1(s, t1);
+		gen_add(s, s, s);
+		gen_add(s, s, s);
+		gen_round(h, s, RoundEven);
+		gen_sub(s, s, h);
+		gen_setVal(c, tbl.pi2[0] * 4);
+		gen_mul(lo, lo, c);
+		gen_setVal(c, tbl.pi2[1]);
+		gen_fmadd(lo, s, c, lo);
+		gen_setVal(c, tbl.pi2[0]);
+		gen_fmadd(lo, s, c, lo);
+		// x is scaled by tbl.scale
+		gen_abs(t1, x);
+		gen_setVal(c, tbl.fastMax * tbl.scale);
+		gen_cmpSelect(q, CmpGt, t1, c, h, q);
+		gen_cmpSelect(r, CmpGt, t1, c, lo, r);
+	}
+	/*
+		x = q pi/2 + r where q is an integer and |r| <= pi/4 (approximately)
+		use the Cody-Waite reduction for |x| <= fastMax
+		and the Payne-Hanek reduction only if some |x| exceeds it
+		x is destroyed and tmp is n tmp registers
+	*/
+	template<class Tbl>
+	void gen_trigReduce(const Tbl& tbl, int q, int r, int x, int tmp, int n) // not virtual
+	{
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const int c = getValTmpIdx(ftr, tbl.inv2pi[0] * 4); // 2/pi
+			LP_(i, n) gen_mul(q + i, x + i, c);
+		}
+		LP_(i, n) gen_round(q + i, q + i, RoundEven);
+		for (int j = 0; j < 3; j++) {
+			IndexRangeManager ftr(funcTmpReg_);
+			const int c = setValTmpIdx(ftr, tbl.pi2[j]);
+			LP_(i, n) gen_fnmadd(r + i, q + i, c, j == 0 ? x + i : r + i);
+		}
+		{
+			// a = max |x| ; cmpSelect ignores NaN
+			const int zero = getValIdx(0);
+			IndexRangeManager ftr(funcTmpReg_);
+			const int a = ftr.allocIdx();
+			const int t = ftr.allocIdx();
+			gen_copy(a, zero);
+			LP_(i, n) {
+				gen_abs(t, x + i);
+				gen_cmpSelect(a, CmpGt, t, a, t, a);
+			}
+			gen_setVal(t, tbl.fastMax);
+			gen_beginSkip(CmpGt, a, t);
+		}
+		LP_(i, n) gen_trigReduceLarge(tbl, q + i, r + i, x + i, tmp + i);
+		gen_endSkip();
+	}
+	/*
+		s = sin(r), c = cos(r) for x = q pi/2 + r ; x is destroyed
+		r is kept in s and c is used as tmp registers in the reduction to save registers
+	*/
+	template<class Tbl>
+	void gen_sinCosCoreT(const Tbl& tbl, int q, int s, int c, int x, int n) // not virtual
+	{
+		gen_trigReduce(tbl, q, s, x, c, n);
+		LP_(i, n) gen_mul(x + i, s + i, s + i);
+		gen_horner(c, x, n, tbl.sinCoef, Tbl::sinN);
+		LP_(i, n) gen_mul(s + i, s + i, c + i);
+		gen_horner(c, x, n, tbl.cosCoef, Tbl::cosN);
+	}
+	void gen_sinCosCore(int q, int s, int c, int x, int n) // not virtual
+	{
+		if (isDouble()) {
+			gen_sinCosCoreT(g_trigTblD, q, s, c, x, n);
+		} else {
+			gen_sinCosCoreT(g_trigTbl, q, s, c, x, n);
+		}
+	}
+	/*
+		dst = sin(q pi/2 + r) for s = sin(r) and c = cos(r)
+		m = q mod 4 ; dst = (m is odd ? c : s) * (m >= 2 ? -1 : 1)
+	*/
+	void gen_sinQuadrant(int dst, int q, int s, int c) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int m = ftr.allocIdx();
+		const int t = ftr.allocIdx();
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int quarter = getValTmpIdx(ftr2, 0.25);
+			gen_mul(t, q, quarter);
+		}
+		gen_round(t, t, RoundDown);
+		gen_add(t, t, t);
+		gen_add(t, t, t);
+		gen_sub(m, q, t);
+		const int two = getValTmpIdx(ftr, 2);
+		gen_sub(t, m, two);
+		gen_abs(t, t);
+		gen_cmpSelect(dst, CmpEq, t, one, c, s);
+		gen_sub(t, zero, dst);
+		gen_cmpSelect(dst, CmpGe, m, two, t, dst);
+	}
+	void gen_sin(int inout, int n) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int q = allocTmpIdx(ftr, n);
+		const int s = allocTmpIdx(ftr, n);
+		const int c = allocTmpIdx(ftr, n);
+		gen_sinCosCore(q, s, c, inout, n);
+		LP_(i, n) gen_sinQuadrant(inout + i, q + i, s + i, c + i);
+	}
+	// cos(x) = sin(x + pi/2)
+	void gen_cos(int inout, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int q = allocTmpIdx(ftr, n);
+		const int s = allocTmpIdx(ftr, n);
+		const int c = allocTmpIdx(ftr, n);
+		gen_sinCosCore(q, s, c, inout, n);
+		LP_(i, n) gen_add(q + i, q + i, one);
+		LP_(i, n) gen_sinQuadrant(inout + i, q + i, s + i, c + i);
+	}
+	// inout = sin(inout), co = cos(inout) by one range reduction
+	void gen_sincos(int inout, int co, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int q = allocTmpIdx(ftr, n);
+		const int s = allocTmpIdx(ftr, n);
+		const int c = allocTmpIdx(ftr, n);
+		gen_sinCosCore(q, s, c, inout, n);
+		LP_(i, n) gen_sinQuadrant(inout + i, q + i, s + i, c + i);
+		LP_(i, n) gen_add(q + i, q + i, one);
+		LP_(i, n) gen_sinQuadrant(co + i, q + i, s + i, c + i);
+	}
+	// tan(q pi/2 + r) = q is odd ? -c/s : s/c
+	void gen_tan(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int q = allocTmpIdx(ftr, n);
+		const int s = allocTmpIdx(ftr, n);
+		const int c = allocTmpIdx(ftr, n);
+		gen_sinCosCore(q, s, c, inout, n);
+		const int half = getValTmpIdx(ftr, 0.5);
+		const int t = ftr.allocIdx();
+		LP_(i, n) {
+			gen_mul(t, q + i, half);
+			gen_round(t, t, RoundDown);
+			gen_add(t, t, t);
+			gen_sub(q + i, q + i, t); // q mod 2
+			gen_sub(t, zero, c + i);
+			gen_cmpSelect(t, CmpEq, q + i, one, t, s + i);
+			gen_cmpSelect(s + i, CmpEq, q + i, one, s + i, c + i);
+			gen_div(inout + i, t, s + i);
+		}
+	}
+	/*
+		y = y (3 - x y^2)/2 ; one Newton step for y = 1/sqrt(x)
+		y is kept for x = 0 or inf because x y^2 is NaN
+	*/
+	void gen_rsqrtNewton(int y, int x) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = ftr.allocIdx();
+		const int r = ftr.allocIdx();
+		gen_mul(t, x, y);
+		gen_fnmadd(r, t, y, one);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int half = getValTmpIdx(ftr2, 0.5);
+			gen_mul(r, r, half);
+		}
+		gen_fmadd(t, y, r, y);
+		gen_cmpSelect(y, CmpEq, r, r, t, y);
+	}
+	// y = 1/sqrt(x) by the estimate (and Newton steps if newton is true)
+	void gen_rsqrtApprox(int y, int x, int n, bool newton) // not virtual
+	{
+		LP_(i, n) gen_rsqrtEst(y + i, x + i);
+		if (newton) {
+			const int stepN = isDouble() ? 2 : 1;
+			for (int j = 0; j < stepN; j++) {
+				LP_(i, n) gen_rsqrtNewton(y + i, x + i);
+			}
+		}
+	}
+	// inout = 1/sqrt(inout) by opt.sqrtMode
+	void gen_rsqrt(int inout, int n) // not virtual
+	{
+		if (opt.sqrtMode == SqrtExact) {
+			const int one = getValIdx(1);
+			LP_(i, n) gen_sqrt(inout + i, inout + i);
+			LP_(i, n) gen_div(inout + i, one, inout + i);
+			return;
+		}
+		IndexRangeManager ftr(funcTmpReg_);
+		const int y = allocTmpIdx(ftr, n);
+		gen_rsqrtApprox(y, inout, n, opt.sqrtMode == SqrtNewton);
+		LP_(i, n) gen_copy(inout + i, y + i);
+	}
+	/*
+		inout = sqrt(inout) by opt.sqrtMode
+		sqrt(x) = x rsqrt(x) except for x = 0 or inf (rsqrt(inf) = 0)
+	*/
+	void gen_sqrtN(int inout, int n) // not virtual
+	{
+		if (opt.sqrtMode == SqrtExact) {
+			LP_(i, n) gen_sqrt(inout + i, inout + i);
+			return;
+		}
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int y = allocTmpIdx(ftr, n);
+		gen_rsqrtApprox(y, inout, n, opt.sqrtMode == SqrtNewton);
+		const int t = ftr.allocIdx();
+		LP_(i, n) {
+			gen_mul(t, inout + i, y + i);
+			gen_cmpSelect(t, CmpEq, inout + i, zero, inout + i, t);
+			gen_cmpSelect(inout + i, CmpEq, y + i, zero, inout + i, t);
+		}
+	}
+	/*
+		cbrt(x) = sign(x) y for y = exp(log(a)/3) and a = |x|
+		followed by one Newton step y = (2y + a/y^2)/3
+		a < min normal is multiplied by 2^(3k) and y by 2^-k because log does not support denormals
+		x is returned for 0, inf and NaN
+	*/
+	void gen_cbrt(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		const int k = isDouble() ? 54 : 24;
+		const double minNormal = isDouble() ? DBL_MIN : FLT_MIN;
+		IndexRangeManager ftr(funcTmpReg_);
+		const int a = allocTmpIdx(ftr, n);
+		const int s = allocTmpIdx(ftr, n);
+		const int y = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int c = ftr2.allocIdx();
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_abs(a + i, inout + i);
+				gen_setVal(c, minNormal);
+				gen_setVal(t, std::ldexp(1.0, -k));
+				gen_cmpSelect(s + i, CmpLt, a + i, c, t, one);
+				gen_setVal(t, std::ldexp(1.0, 3 * k));
+				gen_mul(t, a + i, t);
+				gen_cmpSelect(a + i, CmpLt, a + i, c, t, a + i);
+				gen_copy(y + i, a + i);
+			}
+		}
+		gen_log(y, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int third = getValTmpIdx(ftr2, 1.0 / 3);
+			LP_(i, n) gen_mul(y + i, y + i, third);
+		}
+		gen_exp(y, n);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int third = getValTmpIdx(ftr2, 1.0 / 3);
+		const int t = ftr2.allocIdx();
+		const int u = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_mul(t, y + i, y + i);
+			gen_div(u, a + i, t);
+			gen_add(t, y + i, y + i);
+			gen_add(t, t, u);
+			gen_mul(t, t, third);
+			gen_mul(t, t, s + i);
+			gen_sub(u, zero, t);
+			gen_cmpSelect(t, CmpLt, inout + i, zero, u, t);
+			gen_cmpSelect(t, CmpEq, inout + i, zero, inout + i, t);
+			gen_cmpSelect(inout + i, CmpEq, t, t, t, inout + i);
+		}
+	}
+	/*
+		inout = inout^e for an integer e by the binary method (an addition chain)
+		x^e = 1/x^(-e) for e < 0
+	*/
+	void gen_powInt(int inout, int n, int e) // not virtual
+	{
+		const int one = getValIdx(1);
+		if (e == 0) {
+			LP_(i, n) gen_copy(inout + i, one);
+			return;
+		}
+		const int m = e < 0 ? -e : e;
+		int top = 0;
+		while ((m >> (top + 1)) != 0) top++;
+		IndexRangeManager ftr(funcTmpReg_);
+		const int r = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_copy(r + i, inout + i);
+		for (int j = top - 1; j >= 0; j--) {
+			LP_(i, n) gen_mul(r + i, r + i, r + i);
+			if ((m >> j) & 1) {
+				LP_(i, n) gen_mul(r + i, r + i, inout + i);
+			}
+		}
+		if (e < 0) {
+			LP_(i, n) gen_div(inout + i, one, r + i);
+		} else {
+			LP_(i, n) gen_copy(inout + i, r + i);
+		}
+	}
+	/*
+		dst = pow(x, y) = exp(y log(a)) for a = |x| ; dst may be equal to x or y
+		log(a) = log(a 2^k) - k log(2) for a denormal a because log does not support denormals
+		x < 0 : negate it for an odd integer y and NaN for a non-integer y
+		a = 0 or inf : (y < 0) ? 1/b : b where b = (y is an odd integer) ? x : a
+		1 for y = 0 or x = 1 and NaN for the other NaN args
+	*/
+	void gen_pow(int dst, int x, int y) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		const int k = isDouble() ? 54 : 24;
+		// keep the number of registers small during log and exp for AVX2
+		IndexRangeManager ftr(funcTmpReg_);
+		const int r = ftr.allocIdx();
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int a = ftr2.allocIdx();
+			const int c = ftr2.allocIdx();
+			const int t = ftr2.allocIdx();
+			gen_abs(a, x);
+			gen_setVal(c, isDouble() ? DBL_MIN : FLT_MIN);
+			gen_setVal(t, std::ldexp(1.0, k));
+			gen_mul(t, a, t);
+			gen_cmpSelect(r, CmpLt, a, c, t, a);
+		}
+		gen_log(r, 1);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int a = ftr2.allocIdx();
+			const int c = ftr2.allocIdx();
+			const int t = ftr2.allocIdx();
+			gen_abs(a, x);
+			gen_setVal(c, isDouble() ? DBL_MIN : FLT_MIN);
+			gen_setVal(t, -k * 0.69314718055994531);
+			gen_cmpSelect(t, CmpLt, a, c, t, zero);
+			gen_add(r, r, t);
+			gen_mul(r, r, y);
+			// clamp y log(a) because exp(inf) is not supported on AVX2
+			gen_setVal(t, 1000);
+			gen_min(r, r, t);
+			gen_setVal(t, -1000);
+			gen_max(r, r, t);
+		}
+		gen_exp(r, 1);
+		const int a = ftr.allocIdx();
+		const int b = ftr.allocIdx();
+		gen_abs(a, x);
+		// y log(a) is NaN for a = 1 and y = inf
+		gen_cmpSelect(r, CmpEq, a, one, one, r);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int h = ftr2.allocIdx();
+			const int t = ftr2.allocIdx();
+			const int half = getValTmpIdx(ftr2, 0.5);
+			// |y/2 - round(y/2)| = 1/2 iff y is an odd integer
+			gen_mul(h, y, half);
+			gen_round(t, h, RoundEven);
+			gen_sub(h, h, t);
+			gen_abs(h, h);
+			gen_cmpSelect(b, CmpEq, h, half, x, a);
+			gen_sub(t, zero, r);
+			gen_cmpSelect(r, CmpLt, b, zero, t, r);
+			gen_round(t, y, RoundEven);
+			gen_setVal(h, std::numeric_limits<double>::quiet_NaN());
+			gen_cmpSelect(h, CmpEq, t, y, r, h);
+			gen_cmpSelect(r, CmpLt, x, zero, h, r);
+		}
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int t = ftr2.allocIdx();
+			gen_div(t, one, b);
+			gen_cmpSelect(b, CmpLt, y, zero, t, b);
+			gen_cmpSelect(r, CmpEq, a, zero, b, r);
+			gen_setVal(t, HUGE_VAL);
+			gen_cmpSelect(r, CmpEq, a, t, b, r);
+		}
+		gen_cmpSelect(r, CmpEq, y, y, r, y);
+		gen_cmpSelect(r, CmpEq, x, x, r, x);
+		gen_cmpSelect(r, CmpEq, x, one, one, r);
+		gen_cmpSelect(dst, CmpEq, y, zero, one, r);
+	}
+	/*
+		inout = inout^e for a constant e
+		sqrt for e = 1/2, rsqrt for e = -1/2 and the binary method for a small integer e
+	*/
+	void gen_powConst(int inout, int n, double e) // not virtual
+	{
+		const int powIntMax = 16; // the error of the binary method increases with e
+		if (d2u(e) == d2u(0.5)) {
+			gen_sqrtN(inout, n);
+			return;
+		}
+		if (d2u(e) == d2u(-0.5)) {
+			gen_rsqrt(inout, n);
+			return;
+		}
+		if (std::fabs(e) <= powIntMax && d2u(double(int(e))) == d2u(e)) {
+			gen_powInt(inout, n, int(e));
+			return;
+		}
+		IndexRangeManager ftr(funcTmpReg_);
+		const int y = getValTmpIdx(ftr, e);
+		LP_(i, n) gen_pow(inout + i, inout + i, y);
+	}
+	/*
+		inout = atan(inout/den) for 0 <= inout <= den (see AtanTbl)
+		atan(t) = pi/4 + atan((t - 1)/(t + 1)) for t > tan(pi/8)
+		den is destroyed
+	*/
+	template<class Tbl>
+	void gen_atanCoreT(const Tbl& tbl, int inout, int den, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int base = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int m = ftr2.allocIdx();
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				const int x = inout + i;
+				const int y = den + i;
+				{
+					IndexRangeManager ftr3(funcTmpReg_);
+					const int c = getValTmpIdx(ftr3, 0.41421356237309505); // tan(pi/8)
+					gen_mul(m, y, c);
+				}
+				{
+					IndexRangeManager ftr3(funcTmpReg_);
+					const int pi4 = getValTmpIdx(ftr3, 0.78539816339744831);
+					gen_cmpSelect(base + i, CmpGt, x, m, pi4, zero);
+				}
+				// base > 0 means x > tan(pi/8) y
+				gen_add(t, x, y);
+				gen_sub(m, x, y);
+				gen_cmpSelect(y, CmpGt, base + i, zero, t, y);
+				gen_cmpSelect(x, CmpGt, base + i, zero, m, x);
+			}
+		}
+		LP_(i, n) gen_div(inout + i, inout + i, den + i);
+		LP_(i, n) gen_mul(den + i, inout + i, inout + i);
+		const int p = allocTmpIdx(ftr, n);
+		gen_horner(p, den, n, tbl.atanCoef, Tbl::atanN);
+		LP_(i, n) {
+			gen_mul(p + i, p + i, den + i);
+			gen_fmadd(inout + i, inout + i, p + i, inout + i);
+			gen_add(inout + i, inout + i, base + i);
+		}
+	}
+	void gen_atanCore(int inout, int den, int n) // not virtual
+	{
+		if (isDouble()) {
+			gen_atanCoreT(g_atanTblD, inout, den, n);
+		} else {
+			gen_atanCoreT(g_atanTbl, inout, den, n);
+		}
+	}
+	// atan(x) = sign(x) (|x| > 1 ? pi/2 - atan(1/|x|) : atan(|x|))
+	void gen_atan(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int a = allocTmpIdx(ftr, n);
+		const int d = allocTmpIdx(ftr, n);
+		LP_(i, n) {
+			gen_abs(d + i, inout + i);
+			gen_cmpSelect(a + i, CmpGt, d + i, one, one, d + i);
+			gen_cmpSelect(d + i, CmpGt, d + i, one, d + i, one);
+		}
+		gen_atanCore(a, d, n);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int pi2 = getValTmpIdx(ftr2, 1.5707963267948966);
+		const int t = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_abs(d + i, inout + i);
+			gen_sub(t, pi2, a + i);
+			gen_cmpSelect(a + i, CmpGt, d + i, one, t, a + i);
+			gen_sub(t, zero, a + i);
+			gen_cmpSelect(inout + i, CmpLt, inout + i, zero, t, a + i);
+		}
+	}
+	/*
+		atan2(y, x) for a = |y| and b = |x|
+		r = atan(min(a, b)/max(a, b)) ; r = a > b ? pi/2 - r : r ; r = x < 0 ? pi - r : r
+		dst = y < 0 ? -r : r ; dst may be equal to y or x
+		atan2(0, 0) = 0
+	*/
+	void gen_atan2(int dst, int y, int x) // not virtual
+	{
+		const int zero = getValIdx(0);
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int r = ftr.allocIdx();
+		const int d = ftr.allocIdx();
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int t = ftr2.allocIdx();
+			gen_abs(r, y);
+			gen_abs(d, x);
+			gen_cmpSelect(t, CmpGt, r, d, d, r);
+			gen_cmpSelect(d, CmpGt, r, d, r, d);
+			gen_copy(r, t);
+		}
+		gen_cmpSelect(d, CmpEq, d, zero, one, d);
+		gen_atanCore(r, d, 1);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int t = ftr2.allocIdx();
+		const int u = ftr2.allocIdx();
+		{
+			IndexRangeManager ftr3(funcTmpReg_);
+			const int c = getValTmpIdx(ftr3, 1.5707963267948966);
+			gen_sub(u, c, r);
+		}
+		gen_abs(d, y);
+		gen_abs(t, x);
+		gen_cmpSelect(r, CmpGt, d, t, u, r);
+		{
+			IndexRangeManager ftr3(funcTmpReg_);
+			const int c = getValTmpIdx(ftr3, 3.1415926535897932);
+			gen_sub(u, c, r);
+		}
+		gen_cmpSelect(r, CmpLt, x, zero, u, r);
+		gen_sub(u, zero, r);
+		gen_cmpSelect(dst, CmpLt, y, zero, u, r);
+	}
+	/*
+		p = asin(s) for a = |x| (see AtanTbl)
+		s = a, z = a^2 if a <= 1/2
+		s = sqrt(z), z = (1 - a)/2 otherwise, where asin(a) = pi/2 - 2 asin(s)
+	*/
+	template<class Tbl>
+	void gen_asinCoreT(const Tbl& tbl, int p, int a, int n) // not virtual
+	{
+		const int one = getValIdx(1);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int z = allocTmpIdx(ftr, n);
+		{
+			IndexRangeManager ftr2(funcTmpReg_);
+			const int half = getValTmpIdx(ftr2, 0.5);
+			const int t = ftr2.allocIdx();
+			LP_(i, n) {
+				gen_sub(t, one, a + i);
+				gen_mul(t, t, half);
+				gen_mul(z + i, a + i, a + i);
+				gen_cmpSelect(z + i, CmpGt, a + i, half, t, z + i);
+				gen_sqrt(t, z + i);
+				gen_cmpSelect(p + i, CmpGt, a + i, half, t, a + i);
+			}
+		}
+		const int q = allocTmpIdx(ftr, n);
+		gen_horner(q, z, n, tbl.asinCoef, Tbl::asinN);
+		LP_(i, n) {
+			gen_mul(q + i, q + i, z + i);
+			gen_fmadd(p + i, p + i, q + i, p + i);
+		}
+	}
+	void gen_asinCore(int p, int a, int n) // not virtual
+	{
+		if (isDouble()) {
+			gen_asinCoreT(g_atanTblD, p, a, n);
+		} else {
+			gen_asinCoreT(g_atanTbl, p, a, n);
+		}
+	}
+	// asin(x) = sign(x) (|x| > 1/2 ? pi/2 - 2p : p) for p = asinCore(|x|)
+	void gen_asin(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int a = allocTmpIdx(ftr, n);
+		const int p = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_abs(a + i, inout + i);
+		gen_asinCore(p, a, n);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int half = getValTmpIdx(ftr2, 0.5);
+		const int pi2 = getValTmpIdx(ftr2, 1.5707963267948966);
+		const int t = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_add(t, p + i, p + i);
+			gen_sub(t, pi2, t);
+			gen_cmpSelect(p + i, CmpGt, a + i, half, t, p + i);
+			gen_sub(t, zero, p + i);
+			gen_cmpSelect(inout + i, CmpLt, inout + i, zero, t, p + i);
+		}
+	}
+	/*
+		acos(x) = pi/2 - sign(x) p for |x| <= 1/2
+		acos(x) = x > 0 ? 2p : pi - 2p for |x| > 1/2
+		where p = asinCore(|x|)
+	*/
+	void gen_acos(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int a = allocTmpIdx(ftr, n);
+		const int p = allocTmpIdx(ftr, n);
+		LP_(i, n) gen_abs(a + i, inout + i);
+		gen_asinCore(p, a, n);
+		IndexRangeManager ftr2(funcTmpReg_);
+		const int half = getValTmpIdx(ftr2, 0.5);
+		const int pi2 = getValTmpIdx(ftr2, 1.5707963267948966);
+		const int pi = getValTmpIdx(ftr2, 3.1415926535897932);
+		const int t = ftr2.allocIdx();
+		const int u = ftr2.allocIdx();
+		LP_(i, n) {
+			gen_sub(t, zero, p + i);
+			gen_cmpSelect(p + i, CmpLt, inout + i, zero, t, p + i);
+			gen_sub(t, pi2, p + i);
+			gen_add(p + i, p + i, p + i);
+			gen_add(u, pi, p + i);
+			gen_cmpSelect(p + i, CmpLt, inout + i, zero, u, p + i);
+			gen_cmpSelect(inout + i, CmpGt, a + i, half, p + i, t);
+		}
+	}
+	// inout = inout rounded to an integer by mode (RoundMode)
+	void gen_roundN(int inout, int n, int mode) // not virtual
+	{
+		LP_(i, n) gen_round(inout + i, inout + i, mode);
+	}
+	/*
+		round half away from zero as round() of C
+		t = trunc(x)
+		round(x) = |x - t| >= 1/2 ? t + copysign(1, x) : t
+	*/
+	void gen_roundHalfAway(int inout, int n) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int half = getValTmpIdx(ftr, 0.5);
+		const int one = getValTmpIdx(ftr, 1);
+		const int t = ftr.allocIdx();
+		const int d = ftr.allocIdx();
+		const int s = ftr.allocIdx();
+		LP_(i, n) {
+			gen_round(t, inout + i, RoundZero);
+			gen_sub(d, inout + i, t);
+			gen_abs(d, d);
+			gen_copysign(s, one, inout + i);
+			gen_add(s, t, s);
+			gen_cmpSelect(inout + i, CmpGe, d, half, s, t);
+		}
+	}
+	// frac(x) = x - floor(x)
+	void gen_frac(int inout, int n) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = ftr.allocIdx();
+		LP_(i, n) {
+			gen_round(t, inout + i, RoundDown);
+			gen_sub(inout + i, inout + i, t);
+		}
+	}
+	void gen_absN(int inout, int n) // not virtual
+	{
+		LP_(i, n) gen_abs(inout + i, inout + i);
+	}
+	// sign(x) = copysign(1, x) for x != 0 and x for +-0 and NaN
+	void gen_sign(int inout, int n) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int one = getValTmpIdx(ftr, 1);
+		const int a = ftr.allocIdx();
+		const int s = ftr.allocIdx();
+		LP_(i, n) {
+			gen_abs(a, inout + i);
+			gen_copysign(s, one, inout + i);
+			gen_cmpSelect(inout + i, CmpGt, a, zero, s, inout + i);
+		}
+	}
+	/*
+		fmod(x, y) = copysign(r, x) where a = |x|, b = |y|, r = a - trunc(a/b) b
+		trunc(a/b) may be larger than the exact one by 1 and then r + b is used
+		r is exact if a/b < 2^24 (2^53 for double)
+	*/
+	void gen_fmod(int dst, int x, int y) // not virtual
+	{
+		const int zero = getValIdx(0);
+		IndexRangeManager ftr(funcTmpReg_);
+		const int a = ftr.allocIdx();
+		const int b = ftr.allocIdx();
+		const int r = ftr.allocIdx();
+		const int t = ftr.allocIdx();
+		gen_abs(a, x);
+		gen_abs(b, y);
+		gen_div(r, a, b);
+		gen_round(r, r, RoundZero);
+		gen_fnmadd(r, r, b, a);
+		gen_add(t, r, b);
+		gen_cmpSelect(r, CmpLt, r, zero, t, r);
+		// fmod(x, inf) = x
+		gen_cmpSelect(r, CmpLt, a, b, a, r);
+		gen_copysign(dst, r, x);
+	}
+	/*
+		clamp(x, lo, hi) = min(max(x, lo), hi)
+		cmpSelect is used instead of max and min to keep NaN
+	*/
+	void gen_clamp(int dst, int x, int lo, int hi) // not virtual
+	{
+		IndexRangeManager ftr(funcTmpReg_);
+		const int t = ftr.allocIdx();
+		gen_cmpSelect(t, CmpLt, x, lo, lo, x);
+		gen_cmpSelect(dst, CmpGt, t, hi, hi, t);
+	}
+	// dst = (a cmp b) ? 1 : 0 as C
+	void gen_cmp(int dst, int cmp, int a, int b) // not virtual
+	{
+		gen_cmpSelect(dst, cmp, a, b, getValIdx(1), getValIdx(0));
+	}
+	/*
+		where(c, x, y) = c ? x : y as C
+		c is usually a comparison and NaN is true
+	*/
+	void gen_where(int dst, int c, int x, int y) // not virtual
+	{
+		gen_cmpSelect(dst, CmpEq, c, getValIdx(0), y, x);
+	}
+	void gen_reduce(int red, int src) // not virtual
+	{
+		switch (reduceFuncType_) {
+		case RedSum: gen_add(red, red, src); break;
+		default:
+			throw cybozu::Exception("gen_reduce:bad reduceFuncType_") << reduceFuncType_;
+		}
+	}
+	void reduceAll() // not virtual
+	{
+		int red = getReduceVarIdx();
+		for (int i = 1; i < unrollN_; i++) {
+			gen_reduce(red, red + i);
+		}
+		switch (reduceFuncType_) {
+		case RedSum: reduceOne_sum(0, red); break;
+		default:
+			throw cybozu::Exception("reduce:bad reduceFuncType_") << reduceFuncType_;
+		}
+	}
+	/*
+		return the register for the result of an operation with argN operands
+		a tmp register is allocated only if all operands are var or const
+		otherwise the first tmp operand (the lowest one) is reused and the other tmp operands are released
+	*/
+	static int getResultDst(const int *src, int argN, int tmpMin, int& tmpPos)
+	{
+		int dst = -1;
+		for (int k = 0; k < argN; k++) {
+			if (src[k] < tmpMin) continue;
+			if (dst < 0) {
+				dst = src[k];
+			} else {
+				tmpPos--;
+			}
+		}
+		if (dst < 0) dst = tmpPos++;
+		return dst;
+	}
+	template<class TL>
+	void execOneLoop(const TL& tl, int unrollN)
+	{
+		const sg::ValueVec& vv = tl.getValueVec();
+		const size_t n = vv.size();
+		const int maxStackPos = 32;
+		int stack[maxStackPos];
+		int stackPos = 0;
+		const int tmpMin = getTmpOffset();
+		int tmpPos = tmpMin;
+		for (size_t j = 0; j < n; j++) {
+			if (stackPos < 0 || maxStackPos <= stackPos) throw cybozu::Exception("bad stackPos") << stackPos;
+			const Value& v = vv[j];
+			switch (v.type) {
+			case Var:
+				LP_(i, unrollN) stack[stackPos++] = getVarIdx(v.v, i);
+				break;
+			case Const:
+				LP_(i, unrollN) stack[stackPos++] = getConstIdx(getConstVal(v));
+				break;
+			case Param:
+				LP_(i, unrollN) stack[stackPos++] = getParamIdx(v.v);
+				break;
+			case LetVar:
+				LP_(i, unrollN) stack[stackPos++] = getLetIdx(v.v, i);
+				break;
+			case Let:
+				// keep the top of the stack in the register of the v.v-th let-binding and pop it
+				LP_(i, unrollN) {
+					const int pos = stack[stackPos - unrollN + i];
+					gen_copy(getLetIdx(v.v, i), pos);
+					if (pos >= tmpMin) tmpPos--;
+				}
+				stackPos -= unrollN;
+				break;
+			case Out:
+				/*
+					the result of the v.v-th output is kept in getOutIdx(v.v, i, unrollN)
+					because it is always the lowest tmp of the output
+					and it is the v.v-th element of the stack (sincos leaves two)
+				*/
+				LP_(i, unrollN) {
+					int& pos = stack[int(v.v) * unrollN + i];
+					if (pos < tmpMin) {
+						gen_copy(tmpPos, pos);
+						pos = tmpPos++;
+					}
+					// tmpMin is not fixed yet in the seek mode
+					if (!funcTmpReg_.seekMode_ && pos != tmpMin + int(v.v) * unrollN + i) throw cybozu::Exception("bad out pos") << v.v << i << pos;
+				}
+				break;
+			case Op:
+				LP_(i, unrollN) {
+					const int src[] = { stack[stackPos - unrollN * 2 + i], stack[stackPos - unrollN + i] };
+					int dst = getResultDst(src, 2, tmpMin, tmpPos);
+					stack[stackPos - unrollN * 2 + i] = dst;
+					switch (v.v) {
+					case Add: gen_add(dst, src[0], src[1]); break;
+					case Sub: gen_sub(dst, src[0], src[1]); break;
+					case Mul: gen_mul(dst, src[0], src[1]); break;
+					case Div: gen_div(dst, src[0], src[1]); break;
+					case Lt: gen_cmp(dst, CmpLt, src[0], src[1]); break;
+					case Le: gen_cmp(dst, CmpLe, src[0], src[1]); break;
+					case Gt: gen_cmp(dst, CmpGt, src[0], src[1]); break;
+					case Ge: gen_cmp(dst, CmpGe, src[0], src[1]); break;
+					case Eq: gen_cmp(dst, CmpEq, src[0], src[1]); break;
+					case Ne: gen_cmp(dst, CmpNeq, src[0], src[1]); break;
+					default:
+						throw cybozu::Exception("bad op") << j << v.v;
+					}
+				}
+				stackPos -= unrollN;
+				break;
+			case Func:
+				if (getFuncArgNum(v.v) >= 2) {
+					const int maxArgN = 3;
+					const int argN = getFuncArgNum(v.v);
+					if (argN > maxArgN) throw cybozu::Exception("too many args") << j << v.v << argN;
+					LP_(i, unrollN) {
+						int src[maxArgN];
+						for (int k = 0; k < argN; k++) {
+							src[k] = stack[stackPos - unrollN * (argN - k) + i];
+						}
+						int dst = getResultDst(src, argN, tmpMin, tmpPos);
+						stack[stackPos - unrollN * argN + i] = dst;
+						switch (v.v) {
+						case LeakyRelu: gen_leaky_relu(dst, src[0], src[1]); break;
+						case Atan2: gen_atan2(dst, src[0], src[1]); break;
+						case Pow: gen_pow(dst, src[0], src[1]); break;
+						case Fmod: gen_fmod(dst, src[0], src[1]); break;
+						case CopySign: gen_copysign(dst, src[0], src[1]); break;
+						case Min: gen_min(dst, src[0], src[1]); break;
+						case Max: gen_max(dst, src[0], src[1]); break;
+						case Clamp: gen_clamp(dst, src[0], src[1], src[2]); break;
+						case Where: gen_where(dst, src[0], src[1], src[2]); break;
+						default:
+							throw cybozu::Exception("bad func2") << j << v.v;
+						}
+					}
+					stackPos -= unrollN * (argN - 1);
+				} else {
 					int pos = stack[stackPos - unrollN];
 					if (pos < tmpMin) {
 						LP_(i, unrollN) {
-							gen_copy(tmpPos, pos + i);
+							gen_copy(tmpPos, stack[stackPos - unrollN + i]);
 							stack[stackPos - unrollN + i] = tmpPos;
 							tmpPos++;
 						}
@@ -448,8 +2655,59 @@ struct GeneratorBase {
 					case Inv: gen_inv(pos, unrollN); break;
 					case Exp: gen_exp(pos, unrollN); break;
 					case Log: gen_log(pos, unrollN); break;
+					case Exp2: gen_exp2(pos, unrollN); break;
+					case Log2: gen_logBaseSpecial(pos, unrollN, LogBase2); break;
+					case Log10: gen_logBaseSpecial(pos, unrollN, LogBase10); break;
+					case Expm1: gen_expm1Clamp(pos, unrollN); break;
+					case Log1p: gen_log1pSpecial(pos, unrollN); break;
 					case Cosh: gen_cosh(pos, unrollN); break;
+					case Sinh: gen_sinh(pos, unrollN); break;
+					case SinhCosh:
+						// push cosh(x) onto sinh(x) as SinCos
+						gen_sinhCosh(pos, tmpPos, unrollN);
+						LP_(i, unrollN) stack[stackPos++] = tmpPos++;
+						break;
+					case Asinh: gen_asinh(pos, unrollN); break;
+					case Acosh: gen_acosh(pos, unrollN); break;
+					case Atanh: gen_atanh(pos, unrollN); break;
 					case Tanh: gen_tanh(pos, unrollN); break;
+					case Sigmoid: gen_sigmoid(pos, unrollN); break;
+					case Softplus: gen_softplus(pos, unrollN); break;
+					case Relu: gen_relu(pos, unrollN); break;
+					case Elu: gen_elu(pos, unrollN); break;
+					case Silu: gen_silu(pos, unrollN); break;
+					case Mish: gen_mish(pos, unrollN); break;
+					case Erf: gen_erf(pos, unrollN); break;
+					case Erfc: gen_erfc(pos, unrollN); break;
+					case NormCdf: gen_normcdf(pos, unrollN); break;
+					case NormInv: gen_normInv(pos, unrollN); break;
+					case Lgamma: gen_lgamma(pos, unrollN); break;
+					case Digamma: gen_digamma(pos, unrollN); break;
+					case Gelu: gen_gelu(pos, unrollN); break;
+					case GeluTanh: gen_gelu_tanh(pos, unrollN); break;
+					case Sin: gen_sin(pos, unrollN); break;
+					case Cos: gen_cos(pos, unrollN); break;
+					case Tan: gen_tan(pos, unrollN); break;
+					case Sqrt: gen_sqrtN(pos, unrollN); break;
+					case Rsqrt: gen_rsqrt(pos, unrollN); break;
+					case Cbrt: gen_cbrt(pos, unrollN); break;
+					case PowConst: gen_powConst(pos, unrollN, v.d); break;
+					case Floor: gen_roundN(pos, unrollN, RoundDown); break;
+					case Ceil: gen_roundN(pos, unrollN, RoundUp); break;
+					case Round: gen_roundHalfAway(pos, unrollN); break;
+					case Trunc: gen_roundN(pos, unrollN, RoundZero); break;
+					case Frac: gen_frac(pos, unrollN); break;
+					case Abs: gen_absN(pos, unrollN); break;
+					case Sign: gen_sign(pos, unrollN); break;
+					case Poly: gen_poly(pos, unrollN, tl.getPolyCoef(v)); break;
+					case Atan: gen_atan(pos, unrollN); break;
+					case Asin: gen_asin(pos, unrollN); break;
+					case Acos: gen_acos(pos, unrollN); break;
+					case SinCos:
+						// push cos(x) onto sin(x)
+						gen_sincos(pos, tmpPos, unrollN);
+						LP_(i, unrollN) stack[stackPos++] = tmpPos++;
+						break;
 					case DebugFunc: gen_debugFunc(pos, unrollN); break;
 					case RedSum: /* nothing */ break;
 					default:
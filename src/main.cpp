@@ -4,15 +4,48 @@
 #include "x64/main.hpp"
 #endif
 #ifdef SG_AARCH64
+#ifdef SG_NEON
+#include "aarch64/neon.hpp"
+#else
 #include "aarch64/main.hpp"
 #endif
+#endif
 #include <stdio.h>
 
 const sg::ExpTbl sg::g_expTbl;
 const sg::LogTbl sg::g_logTbl;
+const sg::ExpTblD sg::g_expTblD;
+const sg::LogTblD sg::g_logTblD;
+const sg::ErfTbl sg::g_erfTbl;
+const sg::ErfTblD sg::g_erfTblD;
+const sg::TrigTbl sg::g_trigTbl;
+const sg::TrigTblD sg::g_trigTblD;
+const sg::AtanTbl sg::g_atanTbl;
+const sg::AtanTblD sg::g_atanTblD;
+const sg::GammaTbl sg::g_gammaTbl;
+const sg::GammaTblD sg::g_gammaTblD;
+const sg::NormInvTbl sg::g_normInvTbl;
+const sg::NormInvTblD sg::g_normInvTblD;
+const sg::Bf16Tbl sg::g_bf16Tbl;
+const sg::IntRangeTbl sg::g_uint8RangeTbl(0, 255);
+const sg::IntRangeTbl sg::g_int8RangeTbl(-128, 127);
+const sg::IntRangeTbl sg::g_int16RangeTbl(-32768, 32767);
+const sg::IntRangeTbl sg::g_int32RangeTbl(-2147483648.0f, 2147483520.0f); // the max float < 2^31
 
 struct SgCode {
-	sg::Generator gen;
+	sg::Generator *gen;
+	sg::MacroVec macroVec;
+	SgCode()
+		: gen(new sg::Generator())
+	{
+	}
+	~SgCode()
+	{
+		delete gen;
+	}
+private:
+	SgCode(const SgCode&);
+	void operator=(const SgCode&);
 };
 
 SgCode* SgCreate()
@@ -28,19 +61,86 @@ void SgDestroy(SgCode *sg)
 	delete sg;
 }
 
+int SgSetOpt(SgCode *sg, const char *opt)
+	try
+{
+	if (sg == 0 || opt == 0) return -1;
+	sg->gen->setOpt(opt);
+	return 0;
+} catch (std::exception& e) {
+	if (sg->gen->opt.debug) {
+		fprintf(stderr, "SgSetOpt %s\n", e.what());
+	}
+	return -1;
+}
+
+int SgSetType(SgCode *sg, int dstType, int srcType)
+	try
+{
+	if (sg == 0) return -1;
+	sg->gen->setType(dstType, srcType);
+	return 0;
+} catch (std::exception& e) {
+	if (sg->gen->opt.debug) {
+		fprintf(stderr, "SgSetType %s\n", e.what());
+	}
+	return -1;
+}
+
+int SgDefine(SgCode *sg, const char *proto, const char *body)
+	try
+{
+	if (sg == 0 || proto == 0 || body == 0) return -1;
+	sg::Parser parser;
+	parser.define(sg->macroVec, proto, body);
+	return 0;
+} catch (std::exception& e) {
+	if (sg->gen->opt.debug) {
+		fprintf(stderr, "SgDefine %s\n", e.what());
+	}
+	return -1;
+}
+
 const void* SgGetFuncAddr(SgCode *sg, const char *src)
 	try
 {
 	if (sg == 0) return 0;
 	sg::TokenList tl;
-	tl.setVar(sg->gen.opt.varName);
+	const std::vector<std::string> vs = sg->gen->opt.getVarNameVec();
+	for (size_t i = 0; i < vs.size(); i++) {
+		tl.setVar(vs[i]);
+	}
 	sg::Parser parser;
+	parser.setMacroVec(&sg->macroVec);
 	parser.parse(tl, src);
-	sg->gen.exec(tl);
-	sg->gen.opt.dump(sg->gen.addr_, sg->gen.getSize() - ((const uint8_t*)sg->gen.addr_ - (const uint8_t*)sg->gen.getCode()));
-	return sg->gen.getAddrFloat1();
+	/*
+		the code buffer starts with minCodeSize
+		and it is doubled while the code of tl does not fit
+		opt is restored because detectUnrollN may set use_mem and log_use_mem
+	*/
+	const SgOpt opt = sg->gen->opt;
+	for (;;) {
+		try {
+			sg->gen->exec(tl);
+			break;
+		} catch (std::exception& e) {
+			const size_t codeSize = sg->gen->codeSize_ * 2;
+			if (!sg->gen->isCodeSizeError(e) || codeSize > sg::Generator::maxCodeSize) {
+				sg->gen->opt = opt;
+				throw;
+			}
+			sg::Generator *gen = new sg::Generator(codeSize);
+			gen->copySetting(*sg->gen);
+			delete sg->gen;
+			sg->gen = gen;
+			if (gen->debug) printf("codeSize=%zd\n", codeSize);
+		}
+	}
+	sg->gen->opt = opt;
+	sg->gen->opt.dump(sg->gen->addr_, sg->gen->getSize() - ((const uint8_t*)sg->gen->addr_ - (const uint8_t*)sg->gen->getCode()));
+	return sg->gen->getAddrFloat1();
 } catch (std::exception& e) {
-	if (sg->gen.opt.debug) {
+	if (sg->gen->opt.debug) {
 		fprintf(stderr, "SgGetFuncAddr %s\n", e.what());
 	}
 	return 0;
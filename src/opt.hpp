@@ -2,6 +2,8 @@
 #include <cybozu/atoi.hpp>
 #include <sstream>
 #include <fstream>
+#include <string>
+#include <vector>
 
 struct SgOpt {
 	int unrollN;
@@ -10,8 +12,12 @@ struct SgOpt {
 	bool logp1;
 	bool log_use_mem;
 	bool use_mem;
+	int roundMode; // rounding to integer dst ; 0:even, 1:down, 2:up, 3:zero (the same as vroundps)
+	int sqrtMode; // precision of sqrt and rsqrt ; 0:exact, 1:newton, 2:approx (SqrtMode)
+	int polyMode; // evaluation of poly ; 0:horner, 1:estrin (PolyMode)
 	std::string varName;
 	std::string dumpName;
+	std::string isa;
 	SgOpt()
 		: unrollN(0)
 		, debug(false)
@@ -19,15 +25,38 @@ struct SgOpt {
 		, logp1(true)
 		, log_use_mem(true)
 		, use_mem(true)
+		, roundMode(0)
+		, sqrtMode(0)
+		, polyMode(0)
 		, varName("x")
 		, dumpName("")
+		, isa("")
 	{
 	}
+	// split varName by ','
+	std::vector<std::string> getVarNameVec() const
+	{
+		std::vector<std::string> vs;
+		std::istringstream iss(varName);
+		std::string v;
+		while (std::getline(iss, v, ',')) {
+			if (v.empty()) throw cybozu::Exception("bad var") << varName;
+			vs.push_back(v);
+		}
+		return vs;
+	}
 	void getEnv()
 	{
 		const char *env = getenv("SG_OPT");
 		if (env == 0) return;
-		std::istringstream iss(env);
+		set(env);
+	}
+	/*
+		set options by a string such as "unroll=2 isa=avx2"
+	*/
+	void set(const char *str)
+	{
+		std::istringstream iss(str);
 		std::string kv;
 		while (iss >> kv) {
 			size_t pos = kv.find('=');
@@ -55,6 +84,37 @@ struct SgOpt {
 				dumpName = v;
 				if (debug) printf("dumpName=%s\n", dumpName.c_str());
 			} else
+			if (k == "isa") {
+				isa = v;
+				if (debug) printf("isa=%s\n", isa.c_str());
+			} else
+			if (k == "round") {
+				static const char *tbl[] = { "even", "down", "up", "zero" };
+				roundMode = -1;
+				for (int i = 0; i < 4; i++) {
+					if (v == tbl[i]) roundMode = i;
+				}
+				if (roundMode < 0) throw cybozu::Exception("bad round") << v;
+				if (debug) printf("round=%s\n", v.c_str());
+			} else
+			if (k == "sqrt") {
+				static const char *tbl[] = { "exact", "newton", "approx" };
+				sqrtMode = -1;
+				for (int i = 0; i < 3; i++) {
+					if (v == tbl[i]) sqrtMode = i;
+				}
+				if (sqrtMode < 0) throw cybozu::Exception("bad sqrt") << v;
+				if (debug) printf("sqrt=%s\n", v.c_str());
+			} else
+			if (k == "poly") {
+				static const char *tbl[] = { "horner", "estrin" };
+				polyMode = -1;
+				for (int i = 0; i < 2; i++) {
+					if (v == tbl[i]) polyMode = i;
+				}
+				if (polyMode < 0) throw cybozu::Exception("bad poly") << v;
+				if (debug) printf("poly=%s\n", v.c_str());
+			} else
 			if (k == "logp1") {
 				logp1 = v == "1";
 				if (debug) printf("logp1=%d\n", logp1);
@@ -18,8 +18,86 @@ inline bool isSpace(char c) {
 	return c == ' ' || c == '\t';
 }
 
+inline bool isDigit(char c)
+{
+	return '0' <= c && c <= '9';
+}
+
+// [a-zA-Z_]
+inline bool isVarTop(char c)
+{
+	return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+}
+
+/*
+	a user-defined function such as softclip(x,a) = a*tanh(x/a) by SgDefine
+	it is expanded inline by the parser
+*/
+struct Macro {
+	std::string name;
+	StrVec params;
+	std::string body;
+	/*
+		replace each param in body with (the corresponding arg)
+		a name followed by '(' is a function and a name after '$' is a runtime parameter
+	*/
+	std::string expand(const StrVec& args) const
+	{
+		std::string s = "(";
+		const size_t n = body.size();
+		size_t i = 0;
+		while (i < n) {
+			const char c = body[i];
+			if (isDigit(c) || c == '.') {
+				// skip a number such as 1.5e-3 not to replace e
+				while (i < n && (isDigit(body[i]) || body[i] == '.')) s += body[i++];
+				if (i < n && (body[i] == 'e' || body[i] == 'E')) {
+					s += body[i++];
+					if (i < n && (body[i] == '+' || body[i] == '-')) s += body[i++];
+					while (i < n && isDigit(body[i])) s += body[i++];
+				}
+				continue;
+			}
+			if (!isVarTop(c)) {
+				s += c;
+				i++;
+				continue;
+			}
+			const size_t top = i;
+			while (i < n && (isVarTop(body[i]) || isDigit(body[i]))) i++;
+			const std::string name = body.substr(top, i - top);
+			size_t next = i;
+			while (next < n && isSpace(body[next])) next++;
+			const bool isFunc = next < n && body[next] == '(';
+			const bool isParam = top > 0 && body[top - 1] == '$';
+			size_t k = 0;
+			while (k < params.size() && params[k] != name) k++;
+			if (!isFunc && !isParam && k < params.size()) {
+				s += "(" + args[k] + ")";
+			} else {
+				s += name;
+			}
+		}
+		s += ")";
+		return s;
+	}
+};
+
+typedef std::vector<Macro> MacroVec;
+
+inline void strToFloat(float *f, const char *p, char **endp)
+{
+	*f = strtof(p, endp);
+}
+
+inline void strToFloat(double *f, const char *p, char **endp)
+{
+	*f = strtod(p, endp);
+}
+
 // return next pointer if success else 0
-inline const char* parseFloat(float *f, const char *begin, const char *end)
+template<class T>
+inline const char* parseFloat(T *f, const char *begin, const char *end)
 {
 //	printf("parseFloat1=[%s]\n", std::string(begin, end).c_str());
 	/*
@@ -88,7 +166,7 @@ EXIT:;
 	if (p) {
 //		printf("parseFloat2=[%s]\n", std::string(p, begin).c_str());
 		char *endp;
-		*f = strtof(p, &endp);
+		strToFloat(f, p, &endp);
 		if (endp == begin) return begin;
 	}
 	*f = 0;
@@ -121,18 +199,120 @@ inline const char* parseVar(std::string& v , const char *begin, const char *end)
 
 /*
 	var = [a-zA-Z_]([a-zA-Z_0-9]*)
+	param = '$'var
 	num = float
-	term = var|num|(addSub)
+	func = name '(' cmp (',' cmp)* ')'
+	term = var|param|num|func|(cmp)|'-'pow
+	pow = term ('^' pow) ; right associative
+	cmp = addSub (('<'|'<='|'>'|'>='|'=='|'!=') addSub) ; not associative
 	addSub = mulDiv ('+'|'-' mulDiv)*
-	mulDiv = expr ('*'|'/' expr)
+	mulDiv = pow ('*'|'/' pow)
+	stmt = (var (',' var)* '=')cmp
+	stmts = stmt (';' stmt)* (';')
+	the name of a statement used by the following ones is a let-binding (t=exp(x); t/(1+t))
+	and it is kept in a register instead of an output
 */
 struct Parser {
 	const char *end_;
 	int nest_;
+	const MacroVec *macroVec_;
 	Parser()
 		: end_(0)
 		, nest_(0)
+		, macroVec_(0)
+	{
+	}
+	void setMacroVec(const MacroVec *macroVec) { macroVec_ = macroVec; }
+	const Macro *findMacro(const std::string& name) const
+	{
+		if (macroVec_ == 0) return 0;
+		for (size_t i = 0; i < macroVec_->size(); i++) {
+			if ((*macroVec_)[i].name == name) return &(*macroVec_)[i];
+		}
+		return 0;
+	}
+	// return the pointer to ',' or ')' which ends the argument from begin
+	const char *findArgEnd(const char *begin) const
 	{
+		int level = 0;
+		while (!isEnd(begin)) {
+			const char c = *begin;
+			if (level == 0 && (c == ',' || c == ')')) break;
+			if (c == '(') level++;
+			if (c == ')') level--;
+			begin++;
+		}
+		return begin;
+	}
+	/*
+		parse the args of m from begin (after '(') and the expanded body of m
+		return the pointer after ')'
+	*/
+	const char *parseMacro(const Macro& m, const char *begin, TokenList& tl)
+	{
+		StrVec args;
+		for (;;) {
+			const char *next = findArgEnd(begin);
+			if (isEnd(next)) throw cybozu::Exception("bad macro args") << m.name;
+			args.push_back(std::string(begin, next));
+			if (skipSpace(begin) == next) throw cybozu::Exception("empty macro arg") << m.name;
+			begin = next + 1;
+			if (*next == ')') break;
+		}
+		if (args.size() != m.params.size()) throw cybozu::Exception("bad number of macro args") << m.name << args.size();
+		const std::string s = m.expand(args);
+		const char *end = end_;
+		end_ = s.c_str() + s.size();
+		const char *next = skipSpace(parseCmp(s.c_str(), tl));
+		if (!isEnd(next)) throw cybozu::Exception("bad macro") << m.name << s;
+		end_ = end;
+		return begin;
+	}
+	/*
+		define a macro such as proto = "softclip(x,a)" and body = "a*tanh(x/a)"
+		body is an expression of the params and it may use the macros defined before
+	*/
+	void define(MacroVec& macroVec, const std::string& proto, const std::string& body)
+	{
+		Macro m;
+		const char *begin = proto.c_str();
+		end_ = begin + proto.size();
+		begin = parseVar(m.name, skipSpace(begin), end_);
+		if (begin == 0) throw cybozu::Exception("bad macro name") << proto;
+		if (findFuncKind(m.name) >= 0) throw cybozu::Exception("macro is a function") << m.name;
+		for (size_t i = 0; i < macroVec.size(); i++) {
+			if (macroVec[i].name == m.name) throw cybozu::Exception("macro twice") << m.name;
+		}
+		begin = skipSpace(begin);
+		if (isEnd(begin) || *begin != '(') throw cybozu::Exception("bad macro proto") << proto;
+		for (;;) {
+			std::string param;
+			begin = parseVar(param, skipSpace(begin + 1), end_);
+			if (begin == 0) throw cybozu::Exception("bad macro param") << proto;
+			for (size_t i = 0; i < m.params.size(); i++) {
+				if (m.params[i] == param) throw cybozu::Exception("macro param twice") << param;
+			}
+			m.params.push_back(param);
+			begin = skipSpace(begin);
+			if (isEnd(begin)) throw cybozu::Exception("bad macro proto") << proto;
+			if (*begin == ')') break;
+			if (*begin != ',') throw cybozu::Exception("bad macro proto") << proto;
+		}
+		if (!isEnd(skipSpace(begin + 1))) throw cybozu::Exception("extra string") << proto;
+		m.body = body;
+		// check that body is an expression of the params
+		TokenList tl;
+		for (size_t i = 0; i < m.params.size(); i++) {
+			tl.setVar(m.params[i]);
+		}
+		const MacroVec *save = macroVec_;
+		setMacroVec(&macroVec);
+		parse(tl, body);
+		setMacroVec(save);
+		if (tl.getOutNum() != 1 || !tl.outName_[0].empty() || tl.getLetNum() > 0 || tl.getReduceFuncType() >= 0) {
+			throw cybozu::Exception("macro body must be an expression") << body;
+		}
+		macroVec.push_back(m);
 	}
 	const char *skipSpace(const char *begin)
 	{
@@ -143,14 +323,30 @@ struct Parser {
 		return begin;
 	}
 	bool isEnd(const char *begin) const { return begin == end_; }
+	bool isPowOp(const char *begin)
+	{
+		begin = skipSpace(begin);
+		return !isEnd(begin) && *begin == '^';
+	}
+	/*
+		parse a number which is not followed by '^' as a constant exponent
+		return the next pointer (after spaces) if success else 0
+	*/
+	const char *parseConstExponent(double *e, const char *begin)
+	{
+		const char *next = parseFloat(e, skipSpace(begin), end_);
+		if (next == 0 || isPowOp(next)) return 0;
+		return skipSpace(next);
+	}
 	const char *parseTerm(const char *begin, TokenList& tl)
 	{
 		begin = skipSpace(begin);
 		if (isEnd(begin)) throw cybozu::Exception("num empty");
 		{
-			float f;
+			double f; // keep the precision for double functions
 			const char *next = parseFloat(&f, begin, end_);
-			if (next) {
+			// -2^2 is -(2^2)
+			if (next && !(*begin == '-' && isPowOp(next))) {
 				tl.appendConst(f);
 				nest_++;
 				tl.updateMaxRegStackNum(nest_);
@@ -158,31 +354,65 @@ struct Parser {
 			}
 		}
 		if (*begin == '-') { // unary neg
-			const char *next = parseTerm(begin + 1, tl);
+			const char *next = parsePow(begin + 1, tl);
 			tl.appendFunc(Neg);
 			return next;
 		}
+		if (*begin == '$') {
+			std::string str;
+			const char *next = parseVar(str, begin + 1, end_);
+			if (next == 0) throw cybozu::Exception("bad param") << std::string(begin, end_);
+			tl.appendParam(str);
+			nest_++;
+			tl.updateMaxRegStackNum(nest_);
+			return next;
+		}
 		{
 			std::string str;
 			const char *next = parseVar(str, begin, end_);
 			if (next && *(next = skipSpace(next)) == '(') {
+				const Macro *m = findMacro(str);
+				if (m) return parseMacro(*m, next + 1, tl);
 				int kind = getFuncKind(str);
-				const char *next2 = parseAddSub(next + 1, tl);
+				if (kind == Poly) return parsePoly(next + 1, tl);
+				const int argN = getFuncArgNum(kind);
+				const char *next2 = parseCmp(next + 1, tl);
+				for (int i = 1; i < argN; i++) {
+					if (isEnd(next2) || *next2 != ',') throw cybozu::Exception("too few args") << str << argN;
+					if (kind == Pow) {
+						// pow(x, e) for a constant e is x^e
+						double e;
+						const char *next3 = parseConstExponent(&e, next2 + 1);
+						if (next3 && !isEnd(next3) && *next3 == ')') {
+							tl.appendPowConst(e);
+							return next3 + 1;
+						}
+					}
+					next2 = parseCmp(next2 + 1, tl);
+				}
 				if (!isEnd(next2) && *next2 == ')') {
 					tl.appendFunc(kind);
+					nest_ -= argN - getFuncRetNum(kind);
+					tl.updateMaxRegStackNum(nest_);
 					return next2 + 1;
 				}
 				throw cybozu::Exception("bad func") << str;
 			}
 			if (next) {
-				tl.appendVar(str);
+				// the name of a previous output is a let-binding
+				const int outIdx = tl.getOutIdx(str);
+				if (outIdx >= 0) {
+					tl.appendLetVar(outIdx);
+				} else {
+					tl.appendVar(str);
+				}
 				nest_++;
 				tl.updateMaxRegStackNum(nest_);
 				return next;
 			}
 			char c = *begin;
 			if (c == '(') {
-				const char *next2 = parseAddSub(begin + 1, tl);
+				const char *next2 = parseCmp(begin + 1, tl);
 				if (!isEnd(next) && *next2 == ')') {
 					return next2 + 1;
 				}
@@ -191,15 +421,55 @@ struct Parser {
 		}
 		throw cybozu::Exception("bad syntax") << std::string(begin, end_);
 	}
+	/*
+		parse "x, c0, c1, ...)" of poly from begin (after '(')
+		the coefficients must be numbers
+		return the pointer after ')'
+	*/
+	const char *parsePoly(const char *begin, TokenList& tl)
+	{
+		begin = parseCmp(begin, tl);
+		std::vector<double> c;
+		while (!isEnd(begin) && *begin == ',') {
+			double f;
+			const char *next = parseFloat(&f, skipSpace(begin + 1), end_);
+			if (next == 0) throw cybozu::Exception("poly:coefficient must be a number") << std::string(begin, end_);
+			c.push_back(f);
+			begin = skipSpace(next);
+		}
+		if (c.empty()) throw cybozu::Exception("poly:no coefficient");
+		if (isEnd(begin) || *begin != ')') throw cybozu::Exception("bad poly") << std::string(begin, end_);
+		tl.appendPoly(c);
+		return begin + 1;
+	}
+	/*
+		x^e for a constant e is PowConst with e
+		the others are Pow with two args
+	*/
+	const char *parsePow(const char *begin, TokenList& tl)
+	{
+		begin = skipSpace(parseTerm(begin, tl));
+		if (isEnd(begin) || *begin != '^') return begin;
+		double e;
+		const char *next = parseConstExponent(&e, begin + 1);
+		if (next) {
+			tl.appendPowConst(e);
+			return next;
+		}
+		begin = parsePow(begin + 1, tl);
+		tl.appendFunc(Pow);
+		nest_--;
+		return begin;
+	}
 	const char *parseMulDiv(const char *begin, TokenList& tl)
 	{
-		begin = parseTerm(begin, tl);
+		begin = parsePow(begin, tl);
 		while (!isEnd(begin)) {
 			begin = skipSpace(begin);
 			if (isEnd(begin)) break;
 			char c = *begin;
 			if (c == '*' || c == '/') {
-				begin = parseTerm(begin + 1, tl);
+				begin = parsePow(begin + 1, tl);
 				tl.appendOp(c == '*' ? Mul : Div);
 				nest_--;
 				continue;
@@ -225,6 +495,73 @@ struct Parser {
 		}
 		return begin;
 	}
+	/*
+		a comparison returns 1 if true else 0
+		return the op and set len to the length of it if found else -1
+	*/
+	int getCmpOp(int *len, const char *begin) const
+	{
+		if (isEnd(begin)) return -1;
+		const bool withEq = begin + 1 != end_ && begin[1] == '=';
+		*len = withEq ? 2 : 1;
+		switch (*begin) {
+		case '<': return withEq ? Le : Lt;
+		case '>': return withEq ? Ge : Gt;
+		case '=': return withEq ? Eq : -1;
+		case '!': return withEq ? Ne : -1;
+		default: return -1;
+		}
+	}
+	const char *parseCmp(const char *begin, TokenList& tl)
+	{
+		begin = skipSpace(parseAddSub(begin, tl));
+		int len;
+		const int kind = getCmpOp(&len, begin);
+		if (kind < 0) return begin;
+		begin = parseAddSub(begin + len, tl);
+		tl.appendOp(kind);
+		nest_--;
+		return begin;
+	}
+	// parse "name=" or "name1, name2=" and return the next pointer if found
+	const char *parseOutName(StrVec& names, const char *begin)
+	{
+		begin = skipSpace(begin);
+		const char *p = begin;
+		for (;;) {
+			std::string name;
+			const char *next = parseVar(name, p, end_);
+			if (next == 0) break;
+			names.push_back(name);
+			next = skipSpace(next);
+			if (isEnd(next)) break;
+			// x == y is not an output name
+			if (*next == '=' && (next + 1 == end_ || next[1] != '=')) return next + 1;
+			if (*next != ',') break;
+			p = skipSpace(next + 1);
+		}
+		names.clear();
+		return begin;
+	}
+	/*
+		return the number of results of the statement which begins at vv[top]
+		a function with several results such as sincos must be the whole statement
+	*/
+	static int getStmtRetNum(const TokenList& tl, size_t top)
+	{
+		const ValueVec& vv = tl.getValueVec();
+		for (size_t i = top; i + 1 < vv.size(); i++) {
+			if (vv[i].type == Func && getFuncRetNum(vv[i].v) > 1) {
+				throw cybozu::Exception("several results in an expression") << getFuncName(vv[i].v);
+			}
+		}
+		const Value& v = vv.back();
+		return v.type == Func ? getFuncRetNum(v.v) : 1;
+	}
+	/*
+		each statement is an output (two outputs for sincos)
+		and its result remains on the stack
+	*/
 	void parse(TokenList& tl, const std::string& str)
 	{
 		const char *begin = str.c_str();
@@ -232,9 +569,29 @@ struct Parser {
 		end_ = begin + str.size();
 		nest_ = 0;
 		tl.clear();
-		begin = parseAddSub(begin, tl);
-		if (!isEnd(begin)) {
-			throw cybozu::Exception("extra string") << std::string(begin, end_);
+		for (;;) {
+			StrVec names;
+			begin = parseOutName(names, begin);
+			const size_t top = tl.getValueVec().size();
+			begin = parseCmp(begin, tl);
+			const int retN = getStmtRetNum(tl, top);
+			if (!names.empty() && (int)names.size() != retN) {
+				throw cybozu::Exception("bad number of names") << names.size() << retN;
+			}
+			for (int i = 0; i < retN; i++) {
+				tl.appendOut(names.empty() ? "" : names[i]);
+			}
+			begin = skipSpace(begin);
+			if (isEnd(begin)) break;
+			if (*begin != ';') {
+				throw cybozu::Exception("extra string") << std::string(begin, end_);
+			}
+			begin = skipSpace(begin + 1);
+			if (isEnd(begin)) break;
+		}
+		tl.setupLet();
+		if (tl.getOutNum() > 1 && tl.getReduceFuncType() >= 0) {
+			throw cybozu::Exception("reduce func with several outputs");
 		}
 	}
 };
@@ -10,6 +10,7 @@
 #include <string>
 #include <memory>
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 #include <cybozu/exception.hpp>
 
@@ -24,6 +25,10 @@ enum ValueType {
 	Var,
 	Op,
 	Func,
+	Param,
+	Out, // the end of an output
+	Let, // the end of a let-binding
+	LetVar, // a let-binding used as a variable
 	ValueTypeN
 };
 
@@ -32,6 +37,12 @@ enum OpType {
 	Sub,
 	Mul,
 	Div,
+	Lt, // comparisons return 1 if true else 0
+	Le,
+	Gt,
+	Ge,
+	Eq,
+	Ne,
 	OpTypeN
 };
 
@@ -40,8 +51,60 @@ enum FuncType {
 	Inv,
 	Exp,
 	Log,
+	Exp2,
+	Log2,
+	Log10,
+	Expm1,
+	Log1p,
 	Cosh,
+	Sinh,
+	SinhCosh,
+	Asinh,
+	Acosh,
+	Atanh,
 	Tanh,
+	Sigmoid,
+	Softplus,
+	Relu,
+	LeakyRelu,
+	Elu,
+	Silu,
+	Mish,
+	Erf,
+	Erfc,
+	NormCdf,
+	NormInv,
+	Lgamma,
+	Digamma,
+	Gelu,
+	GeluTanh,
+	Sin,
+	Cos,
+	Tan,
+	SinCos,
+	Atan,
+	Asin,
+	Acos,
+	Atan2,
+	Sqrt,
+	Rsqrt,
+	Cbrt,
+	Pow,
+	PowConst, // x^e for a constant e in Value::d
+	Floor,
+	Ceil,
+	Round,
+	Trunc,
+	Frac,
+	Fmod,
+	Abs,
+	Sign,
+	CopySign,
+	Min,
+	Max,
+	Clamp,
+	Where,
+	Poly, // poly(x, c0, c1, ...) for constants c0, c1, ... in TokenList::polyTbl_
 	DebugFunc,
 	RedBegin,
 	RedSum = RedBegin,
@@ -55,8 +118,60 @@ inline const char* getFuncName(size_t i)
 		"inv",
 		"exp",
 		"log",
+		"exp2",
+		"log2",
+		"log10",
+		"expm1",
+		"log1p",
 		"cosh",
+		"sinh",
+		"sinhcosh",
+		"asinh",
+		"acosh",
+		"atanh",
 		"tanh",
+		"sigmoid",
+		"softplus",
+		"relu",
+		"leaky_relu",
+		"elu",
+		"silu",
+		"mish",
+		"erf",
+		"erfc",
+		"normcdf",
+		"norminv",
+		"lgamma",
+		"digamma",
+		"gelu",
+		"gelu_tanh",
+		"sin",
+		"cos",
+		"tan",
+		"sincos",
+		"atan",
+		"asin",
+		"acos",
+		"atan2",
+		"sqrt",
+		"rsqrt",
+		"cbrt",
+		"pow",
+		"_pow_const",
+		"floor",
+		"ceil",
+		"round",
+		"trunc",
+		"frac",
+		"fmod",
+		"abs",
+		"sign",
+		"copysign",
+		"min",
+		"max",
+		"clamp",
+		"where",
+		"poly",
 		"_debug_func",
 		"red_sum",
 	};
@@ -66,14 +181,55 @@ inline const char* getFuncName(size_t i)
 	return tbl[i];
 }
 
-inline int getFuncKind(const std::string& str)
+// return the kind of a function if found else -1
+inline int findFuncKind(const std::string& str)
 {
+	if (str == "swish") return Silu;
 	for (int i = 0; i < FuncTypeN; i++) {
 		if (str == getFuncName(i)) {
 			return i;
 		}
 	}
-	throw cybozu::Exception("getFuncKind:bad name") << str;
+	return -1;
+}
+
+inline int getFuncKind(const std::string& str)
+{
+	const int kind = findFuncKind(str);
+	if (kind < 0) throw cybozu::Exception("getFuncKind:bad name") << str;
+	return kind;
+}
+
+// the number of arguments of a function
+inline int getFuncArgNum(int kind)
+{
+	switch (kind) {
+	case LeakyRelu:
+	case Atan2:
+	case Pow:
+	case Fmod:
+	case CopySign:
+	case Min:
+	case Max:
+		return 2;
+	case Clamp:
+	case Where:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+// the number of results of a function
+inline int getFuncRetNum(int kind)
+{
+	switch (kind) {
+	case SinCos:
+	case SinhCosh:
+		return 2;
+	default:
+		return 1;
+	}
 }
 
 
@@ -124,6 +280,7 @@ struct Index {
 	}
 	const T& getVal(uint32_t idx) const { return tbl[idx]; }
 	uint32_t size() const { return tbl.size(); }
+	void clear() { tbl.clear(); }
 };
 
 inline float u2f(uint32_t u)
@@ -140,13 +297,29 @@ inline uint32_t f2u(float f)
 	return u;
 }
 
+inline double u2d(uint64_t u)
+{
+	double d;
+	memcpy(&d, &u, sizeof(d));
+	return d;
+}
+
+inline uint64_t d2u(double d)
+{
+	uint64_t u;
+	memcpy(&u, &d, sizeof(u));
+	return u;
+}
+
 struct Value {
 	ValueType type;
 	// index if type == Var else value
 	uint32_t v;
+	double d; // value as double if type == Const, the exponent if PowConst or the index of polyTbl_ if Poly
 	Value()
 		: type(None)
 		, v(0)
+		, d(0)
 	{
 	}
 	std::string getStr() const
@@ -161,6 +334,18 @@ struct Value {
 		case Var:
 			snprintf(buf, sizeof(buf), "var{%d}", v);
 			break;
+		case Param:
+			snprintf(buf, sizeof(buf), "param{%d}", v);
+			break;
+		case Out:
+			snprintf(buf, sizeof(buf), "out{%d}", v);
+			break;
+		case Let:
+			snprintf(buf, sizeof(buf), "let{%d}", v);
+			break;
+		case LetVar:
+			snprintf(buf, sizeof(buf), "letvar{%d}", v);
+			break;
 		case Op:
 			{
 				const char *tbl[] = {
@@ -168,6 +353,12 @@ struct Value {
 					"sub",
 					"mul",
 					"div",
+					"lt",
+					"le",
+					"gt",
+					"ge",
+					"eq",
+					"ne",
 				};
 				if (v >= CYBOZU_NUM_OF_ARRAY(tbl)) {
 					throw cybozu::Exception("bad Op") << v;
@@ -191,7 +382,11 @@ typedef std::vector<Value> ValueVec;
 
 struct TokenList {
 	Index<std::string> varIdx_;
+	Index<std::string> paramIdx_; // in order of appearance
+	StrVec outName_; // name of each output (may be empty)
+	StrVec letName_; // name of each let-binding
 	ValueVec vv;
+	std::vector<std::vector<double> > polyTbl_; // coefficients of each poly
 	int maxRegStackN_;
 	int reduceFuncType_;
 	bool usedFuncTbl_[FuncTypeN];
@@ -207,6 +402,9 @@ struct TokenList {
 		varIdx_.append(s);
 	}
 	uint32_t getVarNum() const { return varIdx_.size(); }
+	uint32_t getParamNum() const { return paramIdx_.size(); }
+	uint32_t getOutNum() const { return outName_.size(); }
+	uint32_t getLetNum() const { return letName_.size(); }
 	const ValueVec& getValueVec() const { return vv; }
 	int getMaxTmpNum() const { return maxRegStackN_; }
 	void updateMaxRegStackNum(int x)
@@ -228,16 +426,22 @@ struct TokenList {
 	int getReduceFuncType() const { return reduceFuncType_; }
 	void clear()
 	{
+		vv.clear();
+		outName_.clear();
+		letName_.clear();
+		polyTbl_.clear();
+		reduceFuncType_ = -1;
 		maxRegStackN_ = 0;
 		for (size_t i = 0; i < FuncTypeN; i++) {
 			usedFuncTbl_[i] = false;
 		}
 	}
-	void appendConst(float f)
+	void appendConst(double d)
 	{
 		Value v;
 		v.type = Const;
-		v.v = f2u(f);
+		v.v = f2u(float(d));
+		v.d = d;
 		vv.push_back(v);
 	}
 	void appendVar(const std::string& s)
@@ -247,6 +451,122 @@ struct TokenList {
 		v.v = varIdx_.getIdx(s);
 		vv.push_back(v);
 	}
+	void appendParam(const std::string& s)
+	{
+		Value v;
+		v.type = Param;
+		v.v = paramIdx_.append(s);
+		vv.push_back(v);
+	}
+	void appendOut(const std::string& name)
+	{
+		if (!name.empty()) {
+			if (varIdx_.getIdx(name, false) >= 0) throw cybozu::Exception("output is a var") << name;
+			for (size_t i = 0; i < outName_.size(); i++) {
+				if (outName_[i] == name) throw cybozu::Exception("output twice") << name;
+			}
+		}
+		Value v;
+		v.type = Out;
+		v.v = outName_.size();
+		vv.push_back(v);
+		outName_.push_back(name);
+	}
+	// return the index of the output of name if found else -1
+	int getOutIdx(const std::string& name) const
+	{
+		if (name.empty()) return -1;
+		for (size_t i = 0; i < outName_.size(); i++) {
+			if (outName_[i] == name) return int(i);
+		}
+		return -1;
+	}
+	// use the idx-th output as a variable, then it becomes a let-binding by setupLet()
+	void appendLetVar(uint32_t idx)
+	{
+		Value v;
+		v.type = LetVar;
+		v.v = idx;
+		vv.push_back(v);
+	}
+	/*
+		the outputs used by the following statements become let-bindings
+		and they are not stored
+		the Out and Let of a statement are reversed because Let pops the stack
+		and the results of let-bindings must follow the ones of outputs in a statement (s, c = sincos(x))
+	*/
+	void setupLet()
+	{
+		const uint32_t n = getOutNum();
+		std::vector<bool> isLet(n);
+		for (size_t i = 0; i < vv.size(); i++) {
+			if (vv[i].type == LetVar) isLet[vv[i].v] = true;
+		}
+		IntVec idxTbl(n);
+		StrVec outName;
+		for (uint32_t i = 0; i < n; i++) {
+			if (isLet[i]) {
+				idxTbl[i] = letName_.size();
+				letName_.push_back(outName_[i]);
+			} else {
+				idxTbl[i] = outName.size();
+				outName.push_back(outName_[i]);
+			}
+		}
+		if (letName_.empty()) return;
+		outName_.swap(outName);
+		size_t i = 0;
+		while (i < vv.size()) {
+			Value& v = vv[i];
+			if (v.type == LetVar) {
+				v.v = idxTbl[v.v];
+				i++;
+				continue;
+			}
+			if (v.type != Out) {
+				i++;
+				continue;
+			}
+			// [i, j) are the results of a statement
+			size_t j = i;
+			bool hasLet = false;
+			while (j < vv.size() && vv[j].type == Out) {
+				if (isLet[vv[j].v]) {
+					hasLet = true;
+				} else if (hasLet) {
+					throw cybozu::Exception("an output after a let-binding") << outName_[idxTbl[vv[j].v]];
+				}
+				vv[j].type = isLet[vv[j].v] ? Let : Out;
+				vv[j].v = idxTbl[vv[j].v];
+				j++;
+			}
+			std::reverse(vv.begin() + i, vv.begin() + j);
+			i = j;
+		}
+		// the results of let-bindings are popped
+		int nest = 0;
+		maxRegStackN_ = 0;
+		for (size_t k = 0; k < vv.size(); k++) {
+			switch (vv[k].type) {
+			case Const:
+			case Var:
+			case Param:
+			case LetVar:
+				nest++;
+				break;
+			case Op:
+			case Let:
+				nest--;
+				break;
+			case Func:
+				nest -= getFuncArgNum(vv[k].v) - getFuncRetNum(vv[k].v);
+				break;
+			default:
+				break;
+			}
+			updateMaxRegStackNum(nest);
+		}
+	}
 	void appendOp(int kind)
 	{
 		Value v;
@@ -262,6 +582,30 @@ struct TokenList {
 		vv.push_back(v);
 		useFunc(kind);
 	}
+	void appendPowConst(double e)
+	{
+		Value v;
+		v.type = Func;
+		v.v = PowConst;
+		v.d = e;
+		vv.push_back(v);
+		useFunc(PowConst);
+	}
+	// c[i] is the coefficient of x^i
+	void appendPoly(const std::vector<double>& c)
+	{
+		Value v;
+		v.type = Func;
+		v.v = Poly;
+		v.d = double(polyTbl_.size());
+		vv.push_back(v);
+		polyTbl_.push_back(c);
+		useFunc(Poly);
+	}
+	const std::vector<double>& getPolyCoef(const Value& v) const
+	{
+		return polyTbl_[size_t(v.d)];
+	}
 	void putValueVec() const
 	{
 		for (size_t i = 0; i < vv.size(); i++) {
@@ -273,6 +617,8 @@ struct TokenList {
 	{
 		printf("var ");
 		varIdx_.put();
+		printf("param ");
+		paramIdx_.put();
 		printf("token ");
 		putValueVec();
 	}
@@ -3,12 +3,18 @@
 #include <xbyak/xbyak_util.h>
 #include <simdgen/simdgen.h>
 #include <cybozu/exception.hpp>
+#include <list>
 
 using namespace Xbyak;
 using namespace Xbyak::util;
 
-typedef std::vector<Zmm> ZmmVec;
+/*
+	Vmm is Zmm on AVX-512 and Ymm on AVX-512VL/AVX2
+*/
+typedef Xmm Vmm;
+typedef std::vector<Vmm> VmmVec;
 typedef std::vector<Opmask> OpmaskVec;
+typedef std::vector<Reg64> Reg64Vec;
 
 namespace sg {
 
@@ -22,17 +28,28 @@ const int maxFreeN = 7;
 
 struct Generator : CodeGenerator, sg::GeneratorBase {
 	static const size_t dataSize = 4096;
-	static const size_t codeSize = 8192;
-	static const size_t totalSize = dataSize + codeSize;
+	static const size_t minCodeSize = 8192;
+	static const size_t maxCodeSize = 1 << 20;
+	size_t codeSize_; // SgGetFuncAddr doubles it if the code is too big
 	Reg64 dataReg_;
+	Reg64 paramReg_; // params given as the last argument
 	Reg32 tmp32_;
 	Reg64 tmp64_;
+	bool isAVX512_; // use opmask, vrcp14ps, vscalefps, ... if true (zmm or ymm)
+	bool hasBF16_; // use vcvtneps2bf16 if true
+	int tailMaskIdx_; // mask register of the remaining loop on AVX2
+	std::list<Label> skipL_; // labels for gen_beginSkip/gen_endSkip
 
-	Generator()
-		: CodeGenerator(totalSize, DontSetProtectRWE)
+	explicit Generator(size_t codeSize = minCodeSize)
+		: CodeGenerator(dataSize + codeSize, DontSetProtectRWE)
+		, codeSize_(codeSize)
 		, dataReg_(rdx)
+		, paramReg_(rdx)
 		, tmp32_(eax)
 		, tmp64_(rax)
+		, isAVX512_(true)
+		, hasBF16_(false)
+		, tailMaskIdx_(0)
 	{
 		simdByte_ = 512 / 8;
 		maxSimdRegN_ = 32;
@@ -41,13 +58,252 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 	{
 		setProtectModeRW();
 	}
+	bool isCodeSizeError(const std::exception& e) const
+	{
+		const Xbyak::Error *p = dynamic_cast<const Xbyak::Error*>(&e);
+		return p != 0 && int(*p) == ERR_CODE_IS_TOO_BIG;
+	}
+	/*
+		return true if zmm instructions lower the frequency of the core
+		Skylake-SP/Cascade Lake/Cooper Lake, Cannon Lake, Ice Lake, Tiger Lake, Rocket Lake
+	*/
+	static bool isThrottledByZmm(const Cpu& cpu)
+	{
+		if (!cpu.has(Cpu::tINTEL) || cpu.displayFamily != 6) return false;
+		static const int tbl[] = {
+			0x55, 0x66, 0x6a, 0x6c, 0x7d, 0x7e, 0x8c, 0x8d, 0xa7,
+		};
+		for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+			if (cpu.displayModel == tbl[i]) return true;
+		}
+		return false;
+	}
+	/*
+		select the instruction set according to opt.isa and CPU
+		avx512 ; zmm
+		avx512vl ; ymm with EVEX encoding
+		avx2 ; ymm
+	*/
+	void setupIsa()
+	{
+		Cpu cpu;
+		const bool hasAVX512 = cpu.has(Cpu::tAVX512F) && cpu.has(Cpu::tAVX512DQ);
+		const bool hasAVX512VL = hasAVX512 && cpu.has(Cpu::tAVX512VL);
+		const bool hasAVX2 = cpu.has(Cpu::tAVX2) && cpu.has(Cpu::tFMA);
+		int bit = 512;
+		if (opt.isa == "avx512") {
+			if (!hasAVX512) throw cybozu::Exception("AVX-512 is not supported");
+			isAVX512_ = true;
+		} else if (opt.isa == "avx512vl") {
+			if (!hasAVX512VL) throw cybozu::Exception("AVX-512VL is not supported");
+			isAVX512_ = true;
+			bit = 256;
+		} else if (opt.isa == "avx2") {
+			if (!hasAVX2) throw cybozu::Exception("AVX2 is not supported");
+			isAVX512_ = false;
+			bit = 256;
+		} else if (opt.isa.empty() || opt.isa == "auto") {
+			if (!hasAVX512 && !hasAVX2) throw cybozu::Exception("AVX-512 and AVX2 are not supported");
+			isAVX512_ = hasAVX512;
+			if (!hasAVX512 || (hasAVX512VL && isThrottledByZmm(cpu))) bit = 256;
+		} else {
+			throw cybozu::Exception("bad isa") << opt.isa;
+		}
+		if (!isAVX512_ && (srcType_ == SG_FLOAT16 || dstType_ == SG_FLOAT16) && !cpu.has(Cpu::tF16C)) {
+			throw cybozu::Exception("F16C is not supported");
+		}
+		hasBF16_ = isAVX512_ && cpu.has(Cpu::tAVX512_BF16);
+		simdByte_ = bit / 8;
+		if (isAVX512_) {
+			maxSimdRegN_ = 32;
+		} else {
+			maxSimdRegN_ = 16 - 1; // the last one is for tailMaskIdx_
+		}
+		if (debug) printf("isa=%s\n", isAVX512_ ? (bit == 512 ? "avx512" : "avx512vl") : "avx2");
+	}
+	Vmm vmm(int idx) const
+	{
+		if (simdByte_ == 64) return Zmm(idx);
+		return Ymm(idx);
+	}
+	// the register of the half size of vmm
+	Vmm hvmm(int idx) const
+	{
+		if (simdByte_ == 64) return Ymm(idx);
+		return Xmm(idx);
+	}
+	// load src elements at addr to vmm(idx) in the type of computation
+	void loadSrc(int idx, const Address& addr)
+	{
+		const Vmm v = vmm(idx);
+		switch (srcType_) {
+		case SG_FLOAT16:
+			vcvtph2ps(v, addr);
+			break;
+		case SG_BFLOAT16:
+			vpmovzxwd(v, addr);
+			vpslld(v, v, 16);
+			break;
+		case SG_UINT8:
+			vpmovzxbd(v, addr);
+			vcvtdq2ps(v, v);
+			break;
+		case SG_INT8:
+			vpmovsxbd(v, addr);
+			vcvtdq2ps(v, v);
+			break;
+		case SG_INT16:
+			vpmovsxwd(v, addr);
+			vcvtdq2ps(v, v);
+			break;
+		case SG_INT32:
+			vcvtdq2ps(v, addr);
+			break;
+		default:
+			vmovups(v, addr);
+			break;
+		}
+	}
+	/*
+		store vmm(idx) to addr as dst elements
+		vmm(idx) and vmm(w) are broken
+	*/
+	void storeDst(const Address& addr, int idx, int w)
+	{
+		const Vmm v = vmm(idx);
+		switch (dstType_) {
+		case SG_FLOAT16:
+			vcvtps2ph(addr, v, 0); // the nearest even
+			break;
+		case SG_BFLOAT16:
+			if (hasBF16_) {
+				const Vmm h = hvmm(idx);
+				vcvtneps2bf16(h, v);
+				vmovups(addr, h);
+				break;
+			}
+			// round to the nearest even ; (v + 0x7fff + ((v >> 16) & 1)) >> 16
+			vpsrld(vmm(w), v, 16);
+			pand(vmm(w), vmm(w), ptr[dataReg_ + getConstTblOffsetToDataReg(g_bf16Tbl.one, sizeof(g_bf16Tbl.one))]);
+			vpaddd(v, v, vmm(w));
+			vpaddd(v, v, ptr[dataReg_ + getConstTblOffsetToDataReg(g_bf16Tbl.x7fff, sizeof(g_bf16Tbl.x7fff))]);
+			vpsrld(v, v, 16);
+			if (isAVX512_) {
+				vpmovdw(addr, v);
+			} else {
+				vpackusdw(v, v, v);
+				vpermq(Ymm(idx), Ymm(idx), 0x08);
+				vmovdqu(addr, Xmm(idx));
+			}
+			break;
+		case SG_UINT8:
+		case SG_INT8:
+		case SG_INT16:
+		case SG_INT32:
+			storeInt(addr, idx, w);
+			break;
+		default:
+			vmovups(addr, v);
+			break;
+		}
+	}
+	/*
+		round vmm(idx) by opt.roundMode, saturate it and store it as dstType_
+		the range is clamped in float because vcvtps2dq returns 0x80000000 for a large value
+		vmm(idx) and vmm(w) are broken
+	*/
+	void storeInt(const Address& addr, int idx, int w)
+	{
+		const Vmm v = vmm(idx);
+		const IntRangeTbl& tbl = getIntRangeTbl();
+		if (opt.roundMode != 0) {
+			// vcvtps2dq rounds to the nearest even by default
+			if (isAVX512_) {
+				vrndscaleps(v, v, opt.roundMode);
+			} else {
+				vroundps(v, v, opt.roundMode);
+			}
+		}
+		vmaxps(v, v, ptr[dataReg_ + getConstTblOffsetToDataReg(tbl.lo, sizeof(tbl.lo))]);
+		vminps(v, v, ptr[dataReg_ + getConstTblOffsetToDataReg(tbl.hi, sizeof(tbl.hi))]);
+		vcvtps2dq(v, v);
+		if (isAVX512_) {
+			switch (dstType_) {
+			case SG_UINT8: vpmovusdb(addr, v); break;
+			case SG_INT8: vpmovsdb(addr, v); break;
+			case SG_INT16: vpmovsdw(addr, v); break;
+			default: vmovdqu32(addr, v); break;
+			}
+			return;
+		}
+		const Ymm y(idx);
+		const Xmm x(idx), t(w);
+		switch (dstType_) {
+		case SG_UINT8:
+		case SG_INT8:
+			// pack in each 128-bit lane and join the lower 4 bytes of the lanes
+			vpackssdw(y, y, y);
+			if (dstType_ == SG_UINT8) {
+				vpackuswb(y, y, y);
+			} else {
+				vpacksswb(y, y, y);
+			}
+			vextracti128(t, y, 1);
+			vpunpckldq(x, x, t);
+			vmovq(addr, x);
+			break;
+		case SG_INT16:
+			vpackssdw(y, y, y);
+			vpermq(y, y, 0x08);
+			vmovdqu(addr, x);
+			break;
+		default:
+			vmovdqu(addr, y);
+			break;
+		}
+	}
+	// copy n (> 0) elements of size byte from s to d
+	void copyElems(const RegExp& d, const RegExp& s, const Reg64& n, const Reg64& idx, int size)
+	{
+		xor_(idx, idx);
+		Label lp = L();
+		switch (size) {
+		case 1:
+			mov(al, ptr[s + idx]);
+			mov(ptr[d + idx], al);
+			break;
+		case 2:
+			mov(ax, ptr[s + idx * 2]);
+			mov(ptr[d + idx * 2], ax);
+			break;
+		case 4:
+			mov(eax, ptr[s + idx * 4]);
+			mov(ptr[d + idx * 4], eax);
+			break;
+		default:
+			throw cybozu::Exception("copyElems:bad size") << size;
+		}
+		add(idx, 1);
+		cmp(idx, n);
+		jne(lp);
+	}
 	// x[0] = sum(s[0:...15])
 	void reduceOne_sum(int d, int s)
 	{
 		assert(d != s);
-		vextractf64x4(Ymm(d), Zmm(s), 1);
-		vaddps(Ymm(d), Ymm(s), Ymm(d));
-		vextractf128(Xmm(s), Ymm(d), 1);
+		if (isDouble()) {
+			reduceOne_sumD(d, s);
+			return;
+		}
+		if (simdByte_ == 64) {
+			vextractf64x4(Ymm(d), Zmm(s), 1);
+			vaddps(Ymm(d), Ymm(s), Ymm(d));
+			vextractf128(Xmm(s), Ymm(d), 1);
+		} else if (isAVX512_) {
+			vextractf32x4(Xmm(d), Ymm(s), 1);
+		} else {
+			vextractf128(Xmm(d), Ymm(s), 1);
+		}
 		vaddps(Xmm(d), Xmm(s), Xmm(d));
 		vpermilps(Xmm(s), Xmm(d), 0x4e);
 		vaddps(Xmm(s), Xmm(s), Xmm(d));
@@ -55,26 +311,100 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		vshufps(Xmm(s), Xmm(s), Xmm(s), 0x55);
 		vaddss(Xmm(d), Xmm(d), Xmm(s));
 	}
-	void outputOne(const Reg64& dst, int i, const Opmask& k = util::k0)
+	// x[0] = sum(s[0:...7]) for double
+	void reduceOne_sumD(int d, int s)
 	{
+		if (simdByte_ == 64) {
+			vextractf64x4(Ymm(d), Zmm(s), 1);
+			vaddpd(Ymm(d), Ymm(s), Ymm(d));
+			vextractf128(Xmm(s), Ymm(d), 1);
+		} else if (isAVX512_) {
+			vextractf64x2(Xmm(d), Ymm(s), 1);
+		} else {
+			vextractf128(Xmm(d), Ymm(s), 1);
+		}
+		vaddpd(Xmm(d), Xmm(s), Xmm(d));
+		vpermilpd(Xmm(s), Xmm(d), 1);
+		vaddsd(Xmm(d), Xmm(d), Xmm(s));
+	}
+	/*
+		useMask ; output the first n elements by k1 (AVX-512) or tailMaskIdx_ (AVX2)
+	*/
+	// output vmm(idx) for the i-th unroll
+	void outputOne(const RegExp& dst, int i, int idx, bool useMask = false)
+	{
+		const Vmm t = vmm(idx);
 		if (reduceFuncType_ >= 0) {
 			int red = getReduceVarIdx() + i;
-			int src = getTmpIdx(i);
+			int src = idx;
+			if (useMask) {
+				// clear unused elements
+				if (isAVX512_) {
+					if (isDouble()) {
+						vmovapd(t|k1|T_z, t);
+					} else {
+						vmovaps(t|k1|T_z, t);
+					}
+				} else {
+					vandps(t, t, vmm(tailMaskIdx_));
+				}
+			}
 			gen_reduce(red, src);
 		} else {
-			vmovups(ptr[dst + i * simdByte_]|k, Zmm(getTmpIdx(i)));
+			const Address addr = ptr[dst + i * (simdByte_ / getElemByte()) * getDstByte()];
+			if (!useMask) {
+				// the input registers are not used after execOneLoop
+				storeDst(addr, idx, getVarIdx(i));
+			} else if (isDouble()) {
+				if (isAVX512_) {
+					vmovupd(addr|k1, t);
+				} else {
+					vmaskmovpd(addr, vmm(tailMaskIdx_), t);
+				}
+			} else {
+				if (isAVX512_) {
+					vmovups(addr|k1, t);
+				} else {
+					vmaskmovps(addr, vmm(tailMaskIdx_), t);
+				}
+			}
 		}
 	}
 	void exec(const sg::TokenList& tl)
 	{
 		if (debug) puts("x64/exec");
-		Cpu cpu;
-		if (!cpu.has(Xbyak::util::Cpu::tAVX512F)) {
-			throw cybozu::Exception("AVX-512 is not supported");
-		}
+		setupIsa();
 		Label dataL = L();
 
+		/*
+			tailMaskTbl + 8 - n is the mask of the first n floats
+			tailMaskTbl + 8 - 2n is the mask of the first n doubles
+		*/
+		static const uint32_t tailMaskTbl[] = {
+			0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+			0, 0, 0, 0, 0, 0, 0, 0,
+		};
+		if (!isAVX512_) {
+			constTblMem_.append(SimdArray(tailMaskTbl, sizeof(tailMaskTbl)));
+		}
+		if (dstType_ == SG_BFLOAT16 && !hasBF16_) {
+			constTblMem_.append(SimdArray(g_bf16Tbl.one, sizeof(g_bf16Tbl.one)));
+			constTblMem_.append(SimdArray(g_bf16Tbl.x7fff, sizeof(g_bf16Tbl.x7fff)));
+		}
+		if (isIntType(dstType_)) {
+			const IntRangeTbl& tbl = getIntRangeTbl();
+			constTblMem_.append(SimdArray(tbl.lo, sizeof(tbl.lo)));
+			constTblMem_.append(SimdArray(tbl.hi, sizeof(tbl.hi)));
+		}
+
 		detectUnrollN(tl);
+		if (!isAVX512_) {
+			tailMaskIdx_ = totalN_++;
+		}
+		const int elemByte = getElemByte();
+		const int elemN = simdByte_ / elemByte; // # of elements in a register
+		const int srcStep = elemN * getSrcByte(); // byte size of src for a register
+		const int dstStep = elemN * getDstByte();
 
 		setSize(0);
 		for (uint32_t i = 0; i < constTblMem_.size(); i++) {
@@ -84,7 +414,7 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			}
 		}
 		for (uint32_t i = 0; i < constMem_.size(); i++) {
-			dd(constMem_.getVal(i));
+			dq(constMem_.getVal(i));
 		}
 		if (getSize() > dataSize) {
 			throw cybozu::Exception("bad data size") << getSize();
@@ -95,93 +425,169 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		{
 			int keepN = 0;
 			if (totalN_ > maxFreeN) keepN = totalN_ - maxFreeN;
-			StackFrame sf(this, 3, 1 | UseRCX | UseRDX, keepN * simdByte_);
+			// buffer for the remaining elements which need conversion
+			const int bufOffset = keepN * simdByte_;
+			// t[0] ; dataReg_, t[1] ; idx, t[2 + i] ; srcs[1 + i], t[srcN_ + 1 + i] ; dsts[1 + i]
+			const int pNum = 3 + (paramN_ > 0);
+			const int tNum = srcN_ + dstN_;
+			if (pNum + tNum + 2 > 14) throw cybozu::Exception("too many variables and outputs") << srcN_ << dstN_;
+			// close sf explicitly because the epilog in the destructor may throw while an exception is thrown
+			StackFrame sf(this, pNum, tNum | UseRCX | UseRDX, bufOffset + simdByte_, false);
 			// store regs
 			for (int i = 0; i < keepN; i++) {
-				vmovups(ptr[rsp + i * simdByte_], Zmm(maxFreeN + i));
+				vmovups(ptr[rsp + i * simdByte_], vmm(maxFreeN + i));
 			}
 			Reg64 dst, src, n;
 			if (reduceFuncType_ >= 0) {
 				src = sf.p[0];
 				n = sf.p[1];
+				paramReg_ = sf.p[2];
 			} else {
 				dst = sf.p[0];
 				src = sf.p[1];
 				n = sf.p[2];
+				if (paramN_ > 0) paramReg_ = sf.p[3];
 			}
+			// src is srcs[] if srcN_ > 1
+			Reg64Vec srcTbl(srcN_);
+			for (int i = 1; i < srcN_; i++) {
+				srcTbl[i] = sf.t[1 + i];
+				mov(srcTbl[i], ptr[src + i * 8]);
+			}
+			if (srcN_ > 1) mov(src, ptr[src]);
+			srcTbl[0] = src;
+			// dst is dsts[] if dstN_ > 1
+			Reg64Vec dstTbl(dstN_);
+			for (int i = 1; i < dstN_; i++) {
+				dstTbl[i] = sf.t[srcN_ + i];
+				mov(dstTbl[i], ptr[dst + i * 8]);
+			}
+			if (dstN_ > 1) mov(dst, ptr[dst]);
+			dstTbl[0] = dst;
 			dataReg_ = sf.t[0];
 			mov(dataReg_, (size_t)dataL.getAddress());
 			gen_setConst();
 			if (reduceFuncType_ >= 0) {
 				LP_(i, unrollN_) {
-					Zmm red(getReduceVarIdx() + i);
+					const Vmm red = vmm(getReduceVarIdx() + i);
 					vxorps(red, red);
 				}
 			}
 
 			Label cmp1L, cmp2L, exitL;
 			jmp(cmp1L, T_NEAR);
-		Label lp1 = L(); // while (n >= 16 * unrollN_)
-			LP_(i, unrollN_) vmovups(Zmm(getVarIdx(i)), ptr[src + i * simdByte_]);
+		Label lp1 = L(); // while (n >= elemN * unrollN_)
+			for (int j = 0; j < srcN_; j++) {
+				LP_(i, unrollN_) loadSrc(getVarIdx(j, i), ptr[srcTbl[j] + i * srcStep]);
+			}
 			execOneLoop(tl, unrollN_);
-			LP_(i, unrollN_) outputOne(dst, i);
-			add(src, 64 * unrollN_);
-			if (reduceFuncType_ < 0) add(dst, 64 * unrollN_);
-			sub(n, 16 * unrollN_);
+			for (int k = 0; k < dstN_; k++) {
+				LP_(i, unrollN_) outputOne(dstTbl[k], i, getOutIdx(k, i, unrollN_));
+			}
+			for (int j = 0; j < srcN_; j++) add(srcTbl[j], srcStep * unrollN_);
+			if (reduceFuncType_ < 0) {
+				for (int k = 0; k < dstN_; k++) add(dstTbl[k], dstStep * unrollN_);
+			}
+			sub(n, elemN * unrollN_);
 		L(cmp1L);
-			cmp(n, 16  * unrollN_);
+			cmp(n, elemN * unrollN_);
 			jge(lp1, T_NEAR);
 
 			if (unrollN_ > 1) {
 				jmp(cmp2L, T_NEAR);
 			Label lp2 = L();
-				vmovups(Zmm(getVarIdx(0)), ptr[src]);
+				for (int j = 0; j < srcN_; j++) loadSrc(getVarIdx(j, 0), ptr[srcTbl[j]]);
 				execOneLoop(tl, 1);
-				outputOne(dst, 0);
-				add(src, 64);
-				if (reduceFuncType_ < 0) add(dst, 64);
-				sub(n, 16);
+				for (int k = 0; k < dstN_; k++) outputOne(dstTbl[k], 0, getOutIdx(k, 0, 1));
+				for (int j = 0; j < srcN_; j++) add(srcTbl[j], srcStep);
+				if (reduceFuncType_ < 0) {
+					for (int k = 0; k < dstN_; k++) add(dstTbl[k], dstStep);
+				}
+				sub(n, elemN);
 			L(cmp2L);
-				cmp(n, 16);
+				cmp(n, elemN);
 				jge(lp2, T_NEAR);
 			}
 
-			mov(ecx, n);
-			test(ecx, ecx);
-			jz(exitL, T_NEAR);
+			if (isAVX512_) {
+				mov(ecx, n);
+				test(ecx, ecx);
+				jz(exitL, T_NEAR);
+
+				mov(tmp32_, 1);
+				shl(tmp32_, cl);
+				sub(tmp32_, 1);
+				kmovd(k1, tmp32_);
+			} else {
+				cmp(n, 0);
+				jz(exitL, T_NEAR);
 
-			mov(tmp32_, 1);
-			shl(tmp32_, cl);
-			sub(tmp32_, 1);
-			kmovd(k1, tmp32_);
-			vmovups(Zmm(getVarIdx(0))|k1|T_z, ptr[src]);
+				const Vmm mask = vmm(tailMaskIdx_);
+				neg(n);
+				vmovups(mask, ptr[dataReg_ + n * elemByte + getConstTblOffsetToDataReg(tailMaskTbl, sizeof(tailMaskTbl)) + 8 * 4]);
+				neg(n);
+			}
+			const Reg64& idx = sf.t[1];
+			const RegExp buf = rsp + bufOffset;
+			for (int j = 0; j < srcN_; j++) {
+				const Vmm x = vmm(getVarIdx(j, 0));
+				const Reg64& s = srcTbl[j];
+				if (isSrcConv()) {
+					// load from the buffer cleared by zero
+					vxorps(x, x, x);
+					vmovups(ptr[buf], x);
+					copyElems(buf, s, n, idx, getSrcByte());
+					loadSrc(getVarIdx(j, 0), ptr[buf]);
+				} else if (isAVX512_) {
+					if (isDouble()) {
+						vmovupd(x|k1|T_z, ptr[s]);
+					} else {
+						vmovups(x|k1|T_z, ptr[s]);
+					}
+				} else {
+					if (isDouble()) {
+						vmaskmovpd(x, vmm(tailMaskIdx_), ptr[s]);
+					} else {
+						vmaskmovps(x, vmm(tailMaskIdx_), ptr[s]);
+					}
+				}
+			}
 			execOneLoop(tl, 1);
-			outputOne(dst, 0, k1);
+			for (int k = 0; k < dstN_; k++) {
+				if (isDstConv()) {
+					outputOne(buf, 0, getOutIdx(k, 0, 1));
+					copyElems(dstTbl[k], buf, n, idx, getDstByte());
+				} else {
+					outputOne(dstTbl[k], 0, getOutIdx(k, 0, 1), true);
+				}
+			}
 		L(exitL);
 			if (reduceFuncType_ >= 0) {
 				reduceAll();
 			}
 			// restore regs
 			for (int i = 0; i < keepN; i++) {
-				vmovups(Zmm(maxFreeN + i), ptr[rsp + i * simdByte_]);
+				vmovups(vmm(maxFreeN + i), ptr[rsp + i * simdByte_]);
 			}
+			vzeroupper();
+			sf.close();
 		}
 		if (debug) putLayout();
 		setProtectModeRE();
 	}
-	ZmmVec getInputRegVec(int pos, int n)
+	VmmVec getInputRegVec(int pos, int n)
 	{
-		ZmmVec t;
+		VmmVec t;
 		for (int i = 0; i < n; i++) {
-			t.push_back(Zmm(pos + i));
+			t.push_back(vmm(pos + i));
 		}
 		return t;
 	}
-	ZmmVec getTmpRegVec(IndexRangeManager& irm, int n)
+	VmmVec getTmpRegVec(IndexRangeManager& irm, int n)
 	{
-		ZmmVec t;
+		VmmVec t;
 		for (int i = 0; i < n; i++) {
-			t.push_back(Zmm(irm.allocIdx()));
+			t.push_back(vmm(irm.allocIdx()));
 		}
 		return t;
 	}
@@ -193,75 +599,385 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		}
 		return t;
 	}
-	void gen_setInt(int dst, uint32_t u)
+	void gen_setInt(int dst, uint64_t u)
 	{
-		vbroadcastss(Zmm(dst), ptr[dataReg_ + getConstOffsetToDataReg(u)]);
+		if (isDouble()) {
+			setInt64(vmm(dst), u);
+		} else {
+			vbroadcastss(vmm(dst), ptr[dataReg_ + getConstOffsetToDataReg(u)]);
+		}
+	}
+	void gen_loadParam(int dst, int i)
+	{
+		if (isDouble()) {
+			const Address addr = ptr[paramReg_ + i * 8];
+			if (simdByte_ == 64) {
+				vbroadcastsd(Zmm(dst), addr);
+			} else {
+				vbroadcastsd(Ymm(dst), addr);
+			}
+		} else {
+			vbroadcastss(vmm(dst), ptr[paramReg_ + i * 4]);
+		}
 	}
 	// set int u to z using tmp32_ instead of memory
-	void setInt(const Zmm& z, uint32_t u)
+	void setInt(const Vmm& z, uint32_t u)
 	{
 		mov(tmp32_, u);
-		vpbroadcastd(z, tmp32_);
+		if (isAVX512_) {
+			vpbroadcastd(z, tmp32_);
+		} else {
+			vmovd(Xmm(z.getIdx()), tmp32_);
+			vpbroadcastd(z, Xmm(z.getIdx()));
+		}
 	}
 	// set float u to z using tmp32_ instead of memory
-	void setFloat(const Zmm& z, float f)
+	void setFloat(const Vmm& z, float f)
 	{
 		setInt(z, f2u(f));
 	}
+	// set u to each 64-bit element of z from the data area
+	void setInt64(const Vmm& z, uint64_t u)
+	{
+		const Address addr = ptr[dataReg_ + getConstOffsetToDataReg(u)];
+		if (simdByte_ == 64) {
+			vbroadcastsd(Zmm(z.getIdx()), addr);
+		} else {
+			vbroadcastsd(Ymm(z.getIdx()), addr);
+		}
+	}
+	void setDouble(const Vmm& z, double d)
+	{
+		setInt64(z, d2u(d));
+	}
+	/*
+		instructions which depend on ISA
+	*/
+	// y = approximation of 1/x
+	void rcp(const Vmm& y, const Vmm& x)
+	{
+		if (isAVX512_) {
+			vrcp14ps(y, x);
+		} else {
+			vrcpps(y, x);
+		}
+	}
+	// y = round(x) ; the nearest even
+	void round(const Vmm& y, const Vmm& x)
+	{
+		if (isAVX512_) {
+			vrndscaleps(y, x, 0);
+		} else {
+			vroundps(y, x, 0);
+		}
+	}
+	void roundD(const Vmm& y, const Vmm& x)
+	{
+		if (isAVX512_) {
+			vrndscalepd(y, x, 0);
+		} else {
+			vroundpd(y, x, 0);
+		}
+	}
+	void pand(const Vmm& x, const Vmm& y, const Operand& op)
+	{
+		if (isAVX512_) {
+			vpandd(x, y, op);
+		} else {
+			vpand(x, y, op);
+		}
+	}
+	void por(const Vmm& x, const Vmm& y, const Operand& op)
+	{
+		if (isAVX512_) {
+			vpord(x, y, op);
+		} else {
+			vpor(x, y, op);
+		}
+	}
 	void gen_fullLoad(int dst, uint32_t offset)
 	{
-		vmovups(Zmm(dst), ptr[dataReg_ + offset]);
+		vmovups(vmm(dst), ptr[dataReg_ + offset]);
 	}
 	void gen_copy(int dst, int src)
 	{
-		vmovaps(Zmm(dst), Zmm(src));
+		vmovaps(vmm(dst), vmm(src));
 	}
 	void gen_add(int dst, int src1, int src2)
 	{
-		vaddps(Zmm(dst), Zmm(src1), Zmm(src2));
+		if (isDouble()) {
+			vaddpd(vmm(dst), vmm(src1), vmm(src2));
+		} else {
+			vaddps(vmm(dst), vmm(src1), vmm(src2));
+		}
 	}
 	void gen_sub(int dst, int src1, int src2)
 	{
-		vsubps(Zmm(dst), Zmm(src1), Zmm(src2));
+		if (isDouble()) {
+			vsubpd(vmm(dst), vmm(src1), vmm(src2));
+		} else {
+			vsubps(vmm(dst), vmm(src1), vmm(src2));
+		}
 	}
 	void gen_mul(int dst, int src1, int src2)
 	{
-		vmulps(Zmm(dst), Zmm(src1), Zmm(src2));
+		if (isDouble()) {
+			vmulpd(vmm(dst), vmm(src1), vmm(src2));
+		} else {
+			vmulps(vmm(dst), vmm(src1), vmm(src2));
+		}
 	}
 	void gen_div(int dst, int src1, int src2)
 	{
-		vdivps(Zmm(dst), Zmm(src1), Zmm(src2));
+		if (isDouble()) {
+			vdivpd(vmm(dst), vmm(src1), vmm(src2));
+		} else {
+			vdivps(vmm(dst), vmm(src1), vmm(src2));
+		}
+	}
+	void gen_max(int dst, int src1, int src2)
+	{
+		if (isDouble()) {
+			vmaxpd(vmm(dst), vmm(src1), vmm(src2));
+		} else {
+			vmaxps(vmm(dst), vmm(src1), vmm(src2));
+		}
+	}
+	void gen_min(int dst, int src1, int src2)
+	{
+		if (isDouble()) {
+			vminpd(vmm(dst), vmm(src1), vmm(src2));
+		} else {
+			vminps(vmm(dst), vmm(src1), vmm(src2));
+		}
+	}
+	// dst = (neg ? -1 : 1) * src1 * src2 + src3
+	void fmaddT(bool neg, int dst, int src1, int src2, int src3)
+	{
+		const Vmm d = vmm(dst);
+		if (dst == src3) {
+			const Vmm a = vmm(src1);
+			const Vmm b = vmm(src2);
+			if (isDouble()) {
+				if (neg) vfnmadd231pd(d, a, b); else vfmadd231pd(d, a, b);
+			} else {
+				if (neg) vfnmadd231ps(d, a, b); else vfmadd231ps(d, a, b);
+			}
+			return;
+		}
+		if (dst == src2) std::swap(src1, src2);
+		if (dst != src1) vmovaps(d, vmm(src1));
+		const Vmm b = vmm(src2);
+		const Vmm c = vmm(src3);
+		if (isDouble()) {
+			if (neg) vfnmadd213pd(d, b, c); else vfmadd213pd(d, b, c);
+		} else {
+			if (neg) vfnmadd213ps(d, b, c); else vfmadd213ps(d, b, c);
+		}
+	}
+	void gen_fmadd(int dst, int src1, int src2, int src3)
+	{
+		fmaddT(false, dst, src1, src2, src3);
+	}
+	void gen_fnmadd(int dst, int src1, int src2, int src3)
+	{
+		fmaddT(true, dst, src1, src2, src3);
+	}
+	void gen_abs(int dst, int src)
+	{
+		if (isDouble()) {
+			vandpd(vmm(dst), vmm(src), vmm(getConstIdx(uint64_t(0x7fffffffffffffffull))));
+		} else {
+			vandps(vmm(dst), vmm(src), vmm(getFloatIdx(u2f(0x7fffffff))));
+		}
+	}
+	void gen_copysign(int dst, int x, int y)
+	{
+		// share the mask with gen_abs
+		const Vmm mask = vmm(isDouble() ? getConstIdx(uint64_t(0x7fffffffffffffffull)) : getFloatIdx(u2f(0x7fffffff)));
+		IndexRangeManager ftr(funcTmpReg_);
+		const Vmm t = vmm(ftr.allocIdx());
+		vandnps(t, mask, vmm(y));
+		vandps(vmm(dst), vmm(x), mask);
+		vorps(vmm(dst), vmm(dst), t);
+	}
+	void gen_sqrt(int dst, int src)
+	{
+		if (isDouble()) {
+			vsqrtpd(vmm(dst), vmm(src));
+		} else {
+			vsqrtps(vmm(dst), vmm(src));
+		}
+	}
+	void gen_rsqrtEst(int dst, int src)
+	{
+		if (isAVX512_) {
+			if (isDouble()) {
+				vrsqrt14pd(vmm(dst), vmm(src));
+			} else {
+				vrsqrt14ps(vmm(dst), vmm(src));
+			}
+		} else if (isDouble()) {
+			// AVX2 has no estimate for double
+			vsqrtpd(vmm(dst), vmm(src));
+			vdivpd(vmm(dst), vmm(getDoubleIdx(1.0)), vmm(dst));
+		} else {
+			vrsqrtps(vmm(dst), vmm(src));
+		}
+	}
+	// the predicate of vcmpps for CmpType
+	static uint8_t getCmpPred(int cmp)
+	{
+		static const uint8_t predTbl[] = {
+			0, // EQ_OQ
+			4, // NEQ_UQ
+			1, // LT_OS
+			2, // LE_OS
+			14, // GT_OS
+			13, // GE_OS
+		};
+		if (cmp < 0 || cmp >= CmpTypeN) throw cybozu::Exception("bad cmp") << cmp;
+		return predTbl[cmp];
+	}
+	void gen_cmpSelect(int dst, int cmp, int src1, int src2, int x, int y)
+	{
+		const uint8_t pred = getCmpPred(cmp);
+		if (isAVX512_) {
+			IndexRangeManager ftm(funcTmpMask_);
+			const Opmask k = Opmask(ftm.allocIdx());
+			if (isDouble()) {
+				vcmppd(k, vmm(src1), vmm(src2), pred);
+				vblendmpd(vmm(dst)|k, vmm(y), vmm(x));
+			} else {
+				vcmpps(k, vmm(src1), vmm(src2), pred);
+				vblendmps(vmm(dst)|k, vmm(y), vmm(x));
+			}
+		} else {
+			IndexRangeManager ftr(funcTmpReg_);
+			const Vmm m = vmm(ftr.allocIdx());
+			if (isDouble()) {
+				vcmppd(m, vmm(src1), vmm(src2), pred);
+				vblendvpd(vmm(dst), vmm(y), vmm(x), m);
+			} else {
+				vcmpps(m, vmm(src1), vmm(src2), pred);
+				vblendvps(vmm(dst), vmm(y), vmm(x), m);
+			}
+		}
+	}
+	void gen_round(int dst, int src, int mode)
+	{
+		if (isAVX512_) {
+			if (isDouble()) {
+				vrndscalepd(vmm(dst), vmm(src), mode);
+			} else {
+				vrndscaleps(vmm(dst), vmm(src), mode);
+			}
+		} else {
+			if (isDouble()) {
+				vroundpd(vmm(dst), vmm(src), mode);
+			} else {
+				vroundps(vmm(dst), vmm(src), mode);
+			}
+		}
+	}
+	void gen_beginSkip(int cmp, int src1, int src2)
+	{
+		const uint8_t pred = getCmpPred(cmp);
+		if (isAVX512_) {
+			IndexRangeManager ftm(funcTmpMask_);
+			const Opmask k = Opmask(ftm.allocIdx());
+			if (funcTmpReg_.seekMode_) return;
+			if (isDouble()) {
+				vcmppd(k, vmm(src1), vmm(src2), pred);
+			} else {
+				vcmpps(k, vmm(src1), vmm(src2), pred);
+			}
+			kortestw(k, k);
+		} else {
+			IndexRangeManager ftr(funcTmpReg_);
+			const Vmm m = vmm(ftr.allocIdx());
+			if (funcTmpReg_.seekMode_) return;
+			if (isDouble()) {
+				vcmppd(m, vmm(src1), vmm(src2), pred);
+				vtestpd(m, m);
+			} else {
+				vcmpps(m, vmm(src1), vmm(src2), pred);
+				vtestps(m, m);
+			}
+		}
+		skipL_.push_back(Label());
+		jz(skipL_.back(), T_NEAR);
+	}
+	void gen_endSkip()
+	{
+		if (funcTmpReg_.seekMode_) return;
+		L(skipL_.back());
+		skipL_.pop_back();
+	}
+	void resetCode()
+	{
+		setSize(0);
 	}
 	void gen_neg(int inout, int n)
 	{
 		IndexRangeManager ftr(funcTmpReg_);
-		const ZmmVec t = getInputRegVec(inout, n);
-		const Zmm sign(ftr.allocIdx());
-		setInt(sign, 1u << 31);
+		const VmmVec t = getInputRegVec(inout, n);
+		const Vmm sign = vmm(ftr.allocIdx());
+		if (isDouble()) {
+			setDouble(sign, -0.0);
+		} else {
+			setInt(sign, 1u << 31);
+		}
 		LP_(i, n) vxorps(t[i], sign);
 	}
 	void gen_inv(int inout, int n)
 	{
-		const Zmm two(getFloatIdx(2.0));
+		if (isDouble()) {
+			gen_invD(inout, n);
+			return;
+		}
+		const Vmm two = vmm(getFloatIdx(2.0));
 		IndexRangeManager ftr(funcTmpReg_);
-		const ZmmVec t0 = getInputRegVec(inout, n);
-		const ZmmVec t1 = getTmpRegVec(ftr, n);
-		LP_(i, n) vrcp14ps(t1[i], t0[i]);
+		const VmmVec t0 = getInputRegVec(inout, n);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		LP_(i, n) rcp(t1[i], t0[i]);
 		LP_(i, n) vfnmadd213ps(t0[i], t1[i], two);
 		LP_(i, n) vmulps(t0[i], t0[i], t1[i]);
 	}
 	void gen_exp(int inout, int n)
 	{
+		gen_expCore(inout, n, false);
+	}
+	void gen_exp2(int inout, int n)
+	{
+		gen_expCore(inout, n, true);
+	}
+	// inout = exp(inout) or 2^inout if isExp2
+	void gen_expCore(int inout, int n, bool isExp2)
+	{
+		if (isDouble()) {
+			gen_expD(inout, n, isExp2);
+			return;
+		}
 		IndexRangeManager ftr(funcTmpReg_);
-		const ZmmVec t0 = getInputRegVec(inout, n);
-		const ZmmVec t1 = getTmpRegVec(ftr, n);
-		const ZmmVec t2 = getTmpRegVec(ftr, n);
+		const VmmVec t0 = getInputRegVec(inout, n);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		const VmmVec t2 = getTmpRegVec(ftr, n);
 
 		if (opt.use_mem) {
-			Zmm c1(ftr.allocIdx());
-			setFloat(c1, g_expTbl.log2_e);
-			LP_(i, n) vmulps(t0[i], c1);
-			LP_(i, n) vrndscaleps(t1[i], t0[i], 0); // n = round(x)
+			const Vmm c1 = vmm(ftr.allocIdx());
+			if (!isExp2) {
+				setFloat(c1, g_expTbl.log2_e);
+				LP_(i, n) vmulps(t0[i], c1);
+			}
+			if (!isAVX512_) {
+				// clamp x before round to avoid inf - inf ; vmaxps/vminps return the second operand for NaN
+				setFloat(c1, g_expTbl.minX);
+				LP_(i, n) vmaxps(t0[i], c1, t0[i]);
+				setFloat(c1, g_expTbl.maxX);
+				LP_(i, n) vminps(t0[i], c1, t0[i]);
+			}
+			LP_(i, n) round(t1[i], t0[i]); // n = round(x)
 			LP_(i, n) vsubps(t0[i], t1[i]); // a
 			setFloat(c1, g_expTbl.log2);
 			LP_(i, n) vmulps(t0[i], c1);
@@ -276,19 +992,42 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			setFloat(c1, g_expTbl.coef[0]);
 			LP_(i, n) vfmadd213ps(t2[i], t0[i], c1);
 			LP_(i, n) vfmadd213ps(t2[i], t0[i], c1);
-			LP_(i, n) vscalefps(t0[i], t2[i], t1[i]); // t2 * 2^t1
-		} else {
-			const Zmm log2(getFloatIdx(g_expTbl.log2));
-			const Zmm log2_e(getFloatIdx(g_expTbl.log2_e));
-			const Zmm tbl[] = {
-				Zmm(getFloatIdx(g_expTbl.coef[0])),
-				Zmm(getFloatIdx(g_expTbl.coef[1])),
-				Zmm(getFloatIdx(g_expTbl.coef[2])),
-				Zmm(getFloatIdx(g_expTbl.coef[3])),
-				Zmm(getFloatIdx(g_expTbl.coef[4])),
+			if (isAVX512_) {
+				LP_(i, n) vscalefps(t0[i], t2[i], t1[i]); // t2 * 2^t1
+			} else {
+				// 2^t1 = 2^h 2^(t1 - h) for h = t1 >> 1 to get inf and subnormals
+				LP_(i, n) vcvtps2dq(t1[i], t1[i]);
+				LP_(i, n) vpsrad(t0[i], t1[i], 1);
+				LP_(i, n) vpsubd(t1[i], t1[i], t0[i]);
+				setInt(c1, 127);
+				LP_(i, n) vpaddd(t0[i], t0[i], c1);
+				LP_(i, n) vpslld(t0[i], t0[i], 23); // 2^h
+				LP_(i, n) vpaddd(t1[i], t1[i], c1);
+				LP_(i, n) vpslld(t1[i], t1[i], 23); // 2^(t1 - h)
+				LP_(i, n) vmulps(t2[i], t2[i], t0[i]);
+				LP_(i, n) vmulps(t0[i], t2[i], t1[i]);
+			}
+		} else {
+			const Vmm log2 = vmm(getFloatIdx(g_expTbl.log2));
+			const Vmm tbl[] = {
+				vmm(getFloatIdx(g_expTbl.coef[0])),
+				vmm(getFloatIdx(g_expTbl.coef[1])),
+				vmm(getFloatIdx(g_expTbl.coef[2])),
+				vmm(getFloatIdx(g_expTbl.coef[3])),
+				vmm(getFloatIdx(g_expTbl.coef[4])),
 			};
-			LP_(i, n) vmulps(t0[i], log2_e);
-			LP_(i, n) vrndscaleps(t1[i], t0[i], 0); // n = round(x)
+			if (!isExp2) {
+				const Vmm log2_e = vmm(getFloatIdx(g_expTbl.log2_e));
+				LP_(i, n) vmulps(t0[i], log2_e);
+			}
+			if (!isAVX512_) {
+				// clamp x before round to avoid inf - inf ; vmaxps/vminps return the second operand for NaN
+				const Vmm minX = vmm(getFloatIdx(g_expTbl.minX));
+				const Vmm maxX = vmm(getFloatIdx(g_expTbl.maxX));
+				LP_(i, n) vmaxps(t0[i], minX, t0[i]);
+				LP_(i, n) vminps(t0[i], maxX, t0[i]);
+			}
+			LP_(i, n) round(t1[i], t0[i]); // n = round(x)
 			LP_(i, n) vsubps(t0[i], t1[i]); // a
 			LP_(i, n) vmulps(t0[i], log2);
 			LP_(i, n) vmovaps(t2[i], tbl[4]);
@@ -297,97 +1036,140 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 			LP_(i, n) vfmadd213ps(t2[i], t0[i], tbl[1]);
 			LP_(i, n) vfmadd213ps(t2[i], t0[i], tbl[0]);
 			LP_(i, n) vfmadd213ps(t2[i], t0[i], tbl[0]);
-			LP_(i, n) vscalefps(t0[i], t2[i], t1[i]); // t2 * 2^t1
+			if (isAVX512_) {
+				LP_(i, n) vscalefps(t0[i], t2[i], t1[i]); // t2 * 2^t1
+			} else {
+				// 2^t1 = 2^h 2^(t1 - h) for h = t1 >> 1 to get inf and subnormals
+				const Vmm i127 = vmm(getConstIdx(127));
+				LP_(i, n) vcvtps2dq(t1[i], t1[i]);
+				LP_(i, n) vpsrad(t0[i], t1[i], 1);
+				LP_(i, n) vpsubd(t1[i], t1[i], t0[i]);
+				LP_(i, n) vpaddd(t0[i], t0[i], i127);
+				LP_(i, n) vpslld(t0[i], t0[i], 23); // 2^h
+				LP_(i, n) vpaddd(t1[i], t1[i], i127);
+				LP_(i, n) vpslld(t1[i], t1[i], 23); // 2^(t1 - h)
+				LP_(i, n) vmulps(t2[i], t2[i], t0[i]);
+				LP_(i, n) vmulps(t0[i], t2[i], t1[i]);
+			}
 		}
 	}
 	void gen_cosh(int inout, int n)
 	{
-		const Zmm f0p5(getFloatIdx(0.5));
-		const Zmm x7fffffff(getFloatIdx(u2f(0x7fffffff)));
-		const ZmmVec t0 = getInputRegVec(inout, n);
+		if (isDouble()) {
+			gen_coshD(inout, n);
+			return;
+		}
 		/*
-			X = exp(|x|)
-			cosh(x) = (X + 1/X) * 0.5
+			X = exp(|x| - h) for h = log(2) rounded to 9 bits to avoid the overflow of exp(|x|)
+			|x| - h is exact for h <= |x| < 2^15
+			cosh(x) = k (X + (1/4k^2)/X) for k = exp(h)/2
+			1/X is computed for min(X, FLT_MAX) because the inverse of inf is NaN
 		*/
+		const double h = 0.693359375;
+		const double k = std::exp(h) * 0.5;
+		const Vmm x7fffffff = vmm(getFloatIdx(u2f(0x7fffffff)));
+		const Vmm fh = vmm(getFloatIdx(float(h)));
+		const Vmm fk = vmm(getFloatIdx(float(k)));
+		const Vmm fk2 = vmm(getFloatIdx(float(0.25 / (k * k))));
+		const Vmm fmax = vmm(getFloatIdx(FLT_MAX));
+		const VmmVec t0 = getInputRegVec(inout, n);
 		LP_(i, n) vandps(t0[i], t0[i], x7fffffff);
+		LP_(i, n) vsubps(t0[i], t0[i], fh);
 		gen_exp(inout, n);
 		IndexRangeManager ftr(funcTmpReg_);
-		const ZmmVec t1 = getTmpRegVec(ftr, n);
-		LP_(i, n) vmovaps(t1[i], t0[i]);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		LP_(i, n) vminps(t1[i], fmax, t0[i]);
 		gen_inv(t1[0].getIdx(), n);
-		LP_(i, n) vaddps(t0[i], t0[i], t1[i]);
-		LP_(i, n) vmulps(t0[i], t0[i], f0p5);
+		LP_(i, n) vfmadd132ps(t1[i], t0[i], fk2);
+		LP_(i, n) vmulps(t0[i], t1[i], fk);
 	}
 	void gen_log(int inout, int n)
 	{
+		gen_logBase(inout, n, LogBaseE);
+	}
+	void gen_logBase(int inout, int n, int base)
+	{
+		if (isDouble()) {
+			gen_logD(inout, n, base);
+			return;
+		}
+		const double m = getLogScale(base);
 		int logN = g_logTbl.N;
-		ZmmVec tbl;
+		VmmVec tbl;
 		int offset = 0;
 		if (opt.log_use_mem) {
 			offset = getConstTblOffsetToDataReg(g_logTbl.coef, logN * 4);
 		} else {
 			for (int i = 0; i < logN; i++) {
-				tbl.push_back(Zmm(getFloatIdx(g_logTbl.coef[i])));
+				tbl.push_back(vmm(getFloatIdx(g_logTbl.coef[i])));
 			}
 		}
 
 		IndexRangeManager ftr(funcTmpReg_);
 		IndexRangeManager ftm(funcTmpMask_);
-		const ZmmVec t0 = getInputRegVec(inout, n);
-		const ZmmVec t1 = getTmpRegVec(ftr, n);
-		const ZmmVec t2 = getTmpRegVec(ftr, n);
-		ZmmVec keep;
+		const VmmVec t0 = getInputRegVec(inout, n);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		const VmmVec t2 = getTmpRegVec(ftr, n);
+		VmmVec keep;
 		if (opt.logp1) {
 			keep = getTmpRegVec(ftr, n);
 			LP_(i, n) vmovaps(keep[i], t0[i]);
 		}
 
 		if (opt.log_use_mem) {
-			Zmm c1(ftr.allocIdx());
-			Zmm c2(ftr.allocIdx());
+			const Vmm c1 = vmm(ftr.allocIdx());
+			const Vmm c2 = vmm(ftr.allocIdx());
 			setInt(c2, 127 << 23);
 			LP_(i, n) vpsubd(t1[i], t0[i], c2);
 			LP_(i, n) vpsrad(t1[i], t1[i], 23); // e
 			LP_(i, n) vcvtdq2ps(t1[i], t1[i]); // float(e)
 			setInt(c1, 0x7fffff);
-			LP_(i, n) vpandd(t0[i], t0[i], c1);
-			LP_(i, n) vpord(t0[i], t0[i], c2); // y
+			LP_(i, n) pand(t0[i], t0[i], c1);
+			LP_(i, n) por(t0[i], t0[i], c2); // y
 			setFloat(c1, 2.0f / 3);
 			setFloat(c2, 1.0f);
 			LP_(i, n) vfmsub213ps(t0[i], c1, c2); // a
-			setFloat(c1, log(1.5f));
-			setFloat(c2, log(2.0f));
+			setFloat(c1, float(std::log(1.5) * m));
+			setFloat(c2, float(std::log(2.0) * m));
 			LP_(i, n) vfmadd213ps(t1[i], c2, c1); // e
 		} else {
-			const Zmm log1p5(getFloatIdx(log(1.5)));
-			const Zmm i127shl23(getFloatIdx(u2f(g_logTbl.i127shl23)));
-			const Zmm x7fffff(getFloatIdx(u2f(g_logTbl.x7fffff)));
-			const Zmm f2div3(getFloatIdx(g_logTbl.f2div3));
-			const Zmm log2(getFloatIdx(g_logTbl.log2));
-			const Zmm one(getFloatIdx(1.0f));
+			const Vmm log1p5 = vmm(getFloatIdx(float(std::log(1.5) * m)));
+			const Vmm i127shl23 = vmm(getFloatIdx(u2f(g_logTbl.i127shl23)));
+			const Vmm x7fffff = vmm(getFloatIdx(u2f(g_logTbl.x7fffff)));
+			const Vmm f2div3 = vmm(getFloatIdx(g_logTbl.f2div3));
+			const Vmm log2 = vmm(getFloatIdx(float(std::log(2.0) * m)));
+			const Vmm one = vmm(getFloatIdx(1.0f));
 			LP_(i, n) vpsubd(t1[i], t0[i], i127shl23);
 			LP_(i, n) vpsrad(t1[i], t1[i], 23); // e
 			LP_(i, n) vcvtdq2ps(t1[i], t1[i]); // float(e)
-			LP_(i, n) vpandd(t0[i], t0[i], x7fffff);
-			LP_(i, n) vpord(t0[i], t0[i], i127shl23); // y
+			LP_(i, n) pand(t0[i], t0[i], x7fffff);
+			LP_(i, n) por(t0[i], t0[i], i127shl23); // y
 			LP_(i, n) vfmsub213ps(t0[i], f2div3, one); // a
 			LP_(i, n) vfmadd213ps(t1[i], log2, log1p5); // e
 		}
 
 		if (opt.logp1) {
-			OpmaskVec mask = getTmpMaskVec(ftm, n);
-			const Zmm f1div8(getFloatIdx(g_logTbl.f1div8));
-			const Zmm x7fffffff(getFloatIdx(u2f(g_logTbl.x7fffffff)));
-			const Zmm one(getFloatIdx(1.0f));
-			LP_(i, n) vsubps(t2[i], keep[i], one);
-			LP_(i, n) vandps(t2[i], t2[i], x7fffffff);
-			LP_(i, n) vcmpltps(mask[i], t2[i], f1div8);
-			LP_(i, n) vsubps(t0[i]|mask[i], keep[i], one);
-			LP_(i, n) vxorps(t1[i]|mask[i], t1[i]);
+			const Vmm f1div8 = vmm(getFloatIdx(g_logTbl.f1div8));
+			const Vmm x7fffffff = vmm(getFloatIdx(u2f(g_logTbl.x7fffffff)));
+			const Vmm one = vmm(getFloatIdx(1.0f));
+			if (isAVX512_) {
+				OpmaskVec mask = getTmpMaskVec(ftm, n);
+				LP_(i, n) vsubps(t2[i], keep[i], one);
+				LP_(i, n) vandps(t2[i], t2[i], x7fffffff);
+				LP_(i, n) vcmpltps(mask[i], t2[i], f1div8);
+				LP_(i, n) vsubps(t0[i]|mask[i], keep[i], one);
+				LP_(i, n) vxorps(t1[i]|mask[i], t1[i]);
+			} else {
+				LP_(i, n) vsubps(t2[i], keep[i], one);
+				LP_(i, n) vandps(keep[i], t2[i], x7fffffff);
+				LP_(i, n) vcmpltps(keep[i], keep[i], f1div8); // mask
+				LP_(i, n) vblendvps(t0[i], t0[i], t2[i], keep[i]);
+				LP_(i, n) vandnps(t1[i], keep[i], t1[i]);
+			}
 		}
 
 		if (opt.log_use_mem) {
-			Zmm c1(ftr.allocIdx());
+			const Vmm c1 = vmm(ftr.allocIdx());
 			vbroadcastss(c1, ptr[dataReg_ + offset + (logN - 1) * 4]);
 			LP_(i, n) vmovaps(t2[i], c1);
 			for (int j = logN - 2; j >= 0; j--) {
@@ -400,6 +1182,11 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 				LP_(i, n) vfmadd213ps(t2[i], t0[i], tbl[j]);
 			}
 		}
+		if (base != LogBaseE) {
+			IndexRangeManager ftr2(funcTmpReg_);
+			const Vmm c = vmm(getValTmpIdx(ftr2, m));
+			LP_(i, n) vmulps(t2[i], t2[i], c);
+		}
 		LP_(i, n) vfmadd213ps(t0[i], t2[i], t1[i]);
 	}
 	void gen_debugFunc(int inout, int n)
@@ -408,19 +1195,168 @@ struct Generator : CodeGenerator, sg::GeneratorBase {
 		static const float tbl[] = {
 			1, 3, 5, 7, 9, 11, 13, 15, 17
 		};
-		const ZmmVec t0 = getInputRegVec(inout, n);
+		const VmmVec t0 = getInputRegVec(inout, n);
 #if 1
 		LP_(i, n) {
 			vmovups(t0[i], ptr[dataReg_ + getConstTblOffsetToDataReg(tbl, sizeof(tbl))]);
 		}
 #else
-		const Zmm t(getConstTblIdx(tbl, sizeof(tbl)));
+		const Vmm t = vmm(getConstTblIdx(tbl, sizeof(tbl)));
 		LP_(i, n) vmovaps(t0[i], t);
 #endif
 	}
-	void gen_tanh(int inout, int n)
+	/*
+		functions for double
+		coefficients are broadcast from the data area
+	*/
+	void gen_invD(int inout, int n)
 	{
-		throw cybozu::Exception("not support gen_tanh") << inout << n;
+		IndexRangeManager ftr(funcTmpReg_);
+		const VmmVec t0 = getInputRegVec(inout, n);
+		const Vmm one = vmm(ftr.allocIdx());
+		setDouble(one, 1.0);
+		LP_(i, n) vdivpd(t0[i], one, t0[i]);
+	}
+	void gen_expD(int inout, int n, bool isExp2)
+	{
+		const int expN = ExpTblD::N;
+		IndexRangeManager ftr(funcTmpReg_);
+		const VmmVec t0 = getInputRegVec(inout, n);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		const VmmVec t2 = getTmpRegVec(ftr, n);
+		const Vmm c = vmm(ftr.allocIdx());
+
+		// clamp x before the reduction to avoid inf - inf ; vmaxpd/vminpd return the second operand for NaN
+		const double scale = isExp2 ? g_expTblD.log2_e : 1.0;
+		setDouble(c, g_expTblD.minX * scale);
+		LP_(i, n) vmaxpd(t0[i], c, t0[i]);
+		setDouble(c, g_expTblD.maxX * scale);
+		LP_(i, n) vminpd(t0[i], c, t0[i]);
+		if (isExp2) {
+			LP_(i, n) roundD(t1[i], t0[i]); // n = round(x)
+			LP_(i, n) vsubpd(t0[i], t0[i], t1[i]);
+			setDouble(c, std::log(2.0));
+			LP_(i, n) vmulpd(t0[i], t0[i], c); // a = (x - n) log(2)
+		} else {
+			setDouble(c, g_expTblD.log2_e);
+			LP_(i, n) vmulpd(t1[i], t0[i], c);
+			LP_(i, n) roundD(t1[i], t1[i]); // n = round(x/log(2))
+			setDouble(c, g_expTblD.ln2_hi);
+			LP_(i, n) vfnmadd231pd(t0[i], t1[i], c);
+			setDouble(c, g_expTblD.ln2_lo);
+			LP_(i, n) vfnmadd231pd(t0[i], t1[i], c); // a = x - n log(2)
+		}
+		setDouble(c, g_expTblD.coef[expN - 1]);
+		LP_(i, n) vmovaps(t2[i], c);
+		for (int j = expN - 2; j >= 0; j--) {
+			setDouble(c, g_expTblD.coef[j]);
+			LP_(i, n) vfmadd213pd(t2[i], t0[i], c);
+		}
+		if (isAVX512_) {
+			LP_(i, n) vscalefpd(t0[i], t2[i], t1[i]); // t2 * 2^t1
+		} else {
+			// 2^t1 = 2^h 2^(t1 - h) for h = t1 >> 1 to get inf and subnormals
+			LP_(i, n) {
+				const Xmm n32(t1[i].getIdx());
+				const Xmm h32(t0[i].getIdx());
+				vcvtpd2dq(n32, t1[i]);
+				vpsrad(h32, n32, 1);
+				vpsubd(n32, n32, h32);
+				vpmovsxdq(t0[i], h32);
+				vpmovsxdq(t1[i], n32);
+			}
+			setInt64(c, 1023);
+			LP_(i, n) vpaddq(t0[i], t0[i], c);
+			LP_(i, n) vpsllq(t0[i], t0[i], 52); // 2^h
+			LP_(i, n) vpaddq(t1[i], t1[i], c);
+			LP_(i, n) vpsllq(t1[i], t1[i], 52); // 2^(t1 - h)
+			LP_(i, n) vmulpd(t2[i], t2[i], t0[i]);
+			LP_(i, n) vmulpd(t0[i], t2[i], t1[i]);
+		}
+	}
+	// cosh(x) = k (X + (1/4k^2)/X) for X = exp(|x| - h) (see gen_cosh)
+	void gen_coshD(int inout, int n)
+	{
+		const double h = 0.693359375;
+		const double k = std::exp(h) * 0.5;
+		const VmmVec t0 = getInputRegVec(inout, n);
+		{
+			IndexRangeManager ftr(funcTmpReg_);
+			const Vmm c = vmm(ftr.allocIdx());
+			setInt64(c, 0x7fffffffffffffffull);
+			LP_(i, n) vandps(t0[i], t0[i], c);
+			setDouble(c, h);
+			LP_(i, n) vsubpd(t0[i], t0[i], c);
+		}
+		gen_expD(inout, n, false);
+		IndexRangeManager ftr(funcTmpReg_);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		const Vmm c = vmm(ftr.allocIdx());
+		setDouble(c, 0.25 / (k * k));
+		LP_(i, n) vdivpd(t1[i], c, t0[i]);
+		LP_(i, n) vaddpd(t0[i], t0[i], t1[i]);
+		setDouble(c, k);
+		LP_(i, n) vmulpd(t0[i], t0[i], c);
+	}
+	/*
+		log_b(x) = (f - (hfsq - s(hfsq + R))) m + k log_b(2) for base b != e
+		m = 1/log(b) (see getLogScale)
+	*/
+	void gen_logD(int inout, int n, int base)
+	{
+		const int logN = LogTblD::N;
+		IndexRangeManager ftr(funcTmpReg_);
+		const VmmVec t0 = getInputRegVec(inout, n);
+		const VmmVec t1 = getTmpRegVec(ftr, n);
+		const VmmVec t2 = getTmpRegVec(ftr, n);
+		const VmmVec t3 = getTmpRegVec(ftr, n);
+		const VmmVec t4 = getTmpRegVec(ftr, n);
+		const Vmm c = vmm(ftr.allocIdx());
+
+		setInt64(c, g_logTblD.sqrt1_2);
+		LP_(i, n) vpsubq(t1[i], t0[i], c);
+		setInt64(c, g_logTblD.expMask);
+		LP_(i, n) vandps(t1[i], t1[i], c); // k << 52
+		LP_(i, n) vpsubq(t0[i], t0[i], t1[i]); // z
+		LP_(i, n) vpsrlq(t1[i], t1[i], 52);
+		setInt64(c, g_logTblD.kMagic);
+		LP_(i, n) vxorps(t1[i], t1[i], c);
+		setDouble(c, g_logTblD.kMagicD);
+		LP_(i, n) vsubpd(t1[i], t1[i], c); // k
+		setDouble(c, 1.0);
+		LP_(i, n) vsubpd(t0[i], t0[i], c); // f = z - 1
+		setDouble(c, 2.0);
+		LP_(i, n) vaddpd(t2[i], t0[i], c);
+		LP_(i, n) vdivpd(t2[i], t0[i], t2[i]); // s = f/(2 + f)
+		LP_(i, n) vmulpd(t3[i], t2[i], t2[i]); // s^2
+		setDouble(c, g_logTblD.coef[logN - 1]);
+		LP_(i, n) vmovaps(t4[i], c);
+		for (int j = logN - 2; j >= 0; j--) {
+			setDouble(c, g_logTblD.coef[j]);
+			LP_(i, n) vfmadd213pd(t4[i], t3[i], c);
+		}
+		LP_(i, n) vmulpd(t3[i], t3[i], t4[i]); // R
+		setDouble(c, 0.5);
+		LP_(i, n) vmulpd(t4[i], t0[i], t0[i]);
+		LP_(i, n) vmulpd(t4[i], t4[i], c); // hfsq = f^2/2
+		LP_(i, n) vaddpd(t3[i], t3[i], t4[i]);
+		LP_(i, n) vmulpd(t3[i], t3[i], t2[i]); // s(hfsq + R)
+		if (base != LogBaseE) {
+			const double m = getLogScale(base);
+			LP_(i, n) vsubpd(t4[i], t4[i], t3[i]);
+			LP_(i, n) vsubpd(t0[i], t0[i], t4[i]); // f - (hfsq - s(hfsq + R))
+			setDouble(c, m);
+			LP_(i, n) vmulpd(t0[i], t0[i], c);
+			setDouble(c, std::log(2.0) * m);
+			LP_(i, n) vfmadd231pd(t0[i], t1[i], c); // + k log_b(2)
+			return;
+		}
+		setDouble(c, g_logTblD.ln2_lo);
+		LP_(i, n) vfmadd231pd(t3[i], t1[i], c); // s(hfsq + R) + k ln2_lo
+		LP_(i, n) vsubpd(t4[i], t4[i], t3[i]);
+		LP_(i, n) vsubpd(t0[i], t0[i], t4[i]); // f - (hfsq - (s(hfsq + R) + k ln2_lo))
+		setDouble(c, g_logTblD.ln2_hi);
+		LP_(i, n) vfmadd231pd(t0[i], t1[i], c); // + k ln2_hi
 	}
 };
 
@@ -1,8 +1,10 @@
 #include <simdgen/simdgen.h>
 #include <cybozu/test.hpp>
+#include <cybozu/inttype.hpp>
 #include <cmath>
 #include <float.h>
 #include <vector>
+#include <string>
 #include <time.h>
 #ifdef _MSC_VER
 	#pragma warning(disable : 4305)
@@ -18,28 +20,52 @@ void loop(float (*f)(float), float *dst, const float *src, size_t n)
 	}
 }
 
-void bench(const char *msg, float (*f)(float), SgFuncFloat1 g)
+double benchOne(float (*f)(float), SgFuncFloat1 g, const float *x, size_t N)
+{
+	const size_t C = 10000;
+	floatVec y(N);
+	clock_t begin = clock();
+	for (size_t i = 0; i < C; i++) {
+		if (f) {
+			loop(f, &y[0], x, N);
+		} else {
+			g(&y[0], x, N);
+		}
+	}
+	clock_t end = clock();
+	return (end - begin) / (double)CLOCKS_PER_SEC / C * 1e6;
+}
+
+/*
+	compare f with the code of src generated for each isa
+*/
+void bench(const char *msg, float (*f)(float), const char *src)
 {
 	printf("%s\n", msg);
-	clock_t begin, end;
 	const size_t N = 4000;
-	const size_t C = 10000;
-	static float x[N], y1[N], y2[N];
+	static float x[N];
 	for (size_t i = 0; i < N; i++) {
 		x[i] = 5 + sin(i / 3.141592f) * 2;
 	}
-	begin = clock();
-	for (size_t i = 0; i < C; i++) {
-		loop(f, y1, x, N);
-	}
-	end = clock();
-	printf("C  %6.2f usec\n", (end - begin) / (double)CLOCKS_PER_SEC / C * 1e6);
-	begin = clock();
-	for (size_t i = 0; i < C; i++) {
-		g(y2, x, N);
+	printf("C  %6.2f usec\n", benchOne(f, 0, x, N));
+#ifdef SG_X64
+	const char *isaTbl[] = { "avx512", "avx512vl", "avx2" };
+#else
+	const char *isaTbl[] = { "" };
+#endif
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(isaTbl); i++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + isaTbl[i];
+		if (*isaTbl[i] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloat1 g = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		if (g) {
+			printf("sg %6.2f usec %s\n", benchOne(0, g, x, N), isaTbl[i]);
+		}
+		SgDestroy(sg);
 	}
-	end = clock();
-	printf("sg %6.2f usec\n", (end - begin) / (double)CLOCKS_PER_SEC / C * 1e6);
 }
 
 float diff(float x, float y)
@@ -48,6 +74,13 @@ float diff(float x, float y)
 	return std::fabs(x) < 1e-10 ? d : d / x;
 }
 
+uint32_t f2u(float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
 void checkRange(float (*f)(float), SgFuncFloat1 g, float begin, float end, float step)
 {
 	floatVec dst, src;
@@ -91,6 +124,93 @@ void checkRange(float (*f)(float), SgFuncFloat1 g, float begin, float end, float
 	CYBOZU_TEST_ASSERT(maxe <= MAX_E);
 }
 
+#ifdef SG_X64
+const char *g_isaTbl[] = { "avx512", "avx512vl", "avx2" };
+#else
+const char *g_isaTbl[] = { "" };
+#endif
+
+// return false if the types are not supported (NEON supports only float)
+bool setType(SgCode *sg, int dstType, int srcType)
+{
+#ifdef SG_NEON
+	if (dstType != SG_FLOAT || srcType != SG_FLOAT) {
+		CYBOZU_TEST_ASSERT(SgSetType(sg, dstType, srcType) != 0);
+		return false;
+	}
+#endif
+	CYBOZU_TEST_EQUAL(SgSetType(sg, dstType, srcType), 0);
+	return true;
+}
+
+// src(NaN) and src(-NaN) must be NaN for float and double
+void checkNaN(const char *src)
+{
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		for (int isDouble = 0; isDouble < 2; isDouble++) {
+			SgCode *sg = SgCreate();
+			const std::string opt = std::string("isa=") + g_isaTbl[k];
+			if ((*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) || (isDouble && SgSetType(sg, SG_DOUBLE, SG_DOUBLE) != 0)) {
+				SgDestroy(sg);
+				continue;
+			}
+			const void *addr = SgGetFuncAddr(sg, src);
+			CYBOZU_TEST_ASSERT(addr);
+			if (addr) {
+				bool ok = true;
+				if (isDouble) {
+					const double x[] = { NAN, -NAN };
+					double y[2];
+					((SgFuncDouble1)addr)(y, x, 2);
+					ok = std::isnan(y[0]) && std::isnan(y[1]);
+				} else {
+					const float x[] = { NAN, -NAN };
+					float y[2];
+					((SgFuncFloat1)addr)(y, x, 2);
+					ok = std::isnan(y[0]) && std::isnan(y[1]);
+				}
+				if (!ok) printf("err %s isa=%s double=%d\n", src, g_isaTbl[k], isDouble);
+				CYBOZU_TEST_ASSERT(ok);
+			}
+			SgDestroy(sg);
+		}
+	}
+}
+
+// src(x) must be f(x) with the relative error maxe for x in tbl on every isa ; inf must be exact
+template<size_t N>
+void checkEdge(float (*f)(float), const char *src, const float (&tbl)[N], float maxe = MAX_E)
+{
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		const std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float y[N];
+			addr(y, tbl, N);
+			for (size_t i = 0; i < N; i++) {
+				const float y0 = f(tbl[i]);
+				bool ok;
+				if (std::isnan(y0)) {
+					ok = std::isnan(y[i]);
+				} else if (std::isinf(y0)) {
+					ok = f2u(y[i]) == f2u(y0);
+				} else {
+					ok = diff(y0, y[i]) <= maxe;
+				}
+				if (!ok) printf("err %s isa=%s x=%e y0=%e y1=%e\n", src, g_isaTbl[k], tbl[i], y0, y[i]);
+				CYBOZU_TEST_ASSERT(ok);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
 template<size_t N>
 void checkTable(float (*f)(float), SgFuncFloat1 g, const float (&tbl)[N])
 {
@@ -152,7 +272,7 @@ CYBOZU_TEST_AUTO(exp)
 	checkRange(expf, addr, -3, -2, 1e-4);
 	checkRange(expf, addr, 0, 1, 1e-4);
 	checkRange(expf, addr, 10, 11, 1e-4);
-	bench("exp", expf, addr);
+	bench("exp", expf, "exp(x)");
 	SgDestroy(sg);
 }
 
@@ -172,10 +292,71 @@ CYBOZU_TEST_AUTO(log)
 	checkRange(logf, addr, 1 - 1e-5, 1 + 1e-5, 1e-7);
 	checkRange(logf, addr, 10, 11, 1e-4);
 	checkRange(logf, addr, 1000, 1000 + 1, 1e-4);
-	bench("log", logf, addr);
+	bench("log", logf, "log(x)");
 	SgDestroy(sg);
 }
 
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+	float begin;
+	float end;
+} g_expLogTbl[] = {
+	{ "exp2(x)", exp2f, exp2, -120, 120 },
+	{ "log2(x)", log2f, log2, 1e-3f, 1e3f },
+	{ "log10(x)", log10f, log10, 1e-3f, 1e3f },
+	{ "expm1(x)", expm1f, expm1, -50, 10 },
+	{ "log1p(x)", log1pf, log1p, -0.99f, 1e3f },
+};
+
+CYBOZU_TEST_AUTO(expLog)
+{
+	const float tbl[] = {
+		1e-30f, 1e-7f, -1e-7f, 1e-4f, -1e-4f, 0.5f, 1, 2, 3, 8, 10, 100, 1e10f
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_expLogTbl); i++) {
+		const char *src = g_expLogTbl[i].src;
+		const float begin = g_expLogTbl[i].begin;
+		const float end = g_expLogTbl[i].end;
+		printf("%s\n", src);
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float x[CYBOZU_NUM_OF_ARRAY(tbl)];
+			size_t n = 0;
+			for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+				if (begin <= tbl[j] && tbl[j] <= end) x[n++] = tbl[j];
+			}
+			float y[CYBOZU_NUM_OF_ARRAY(tbl)];
+			addr(y, x, n);
+			for (size_t j = 0; j < n; j++) {
+				CYBOZU_TEST_ASSERT(diff(g_expLogTbl[i].f(x[j]), y[j]) <= MAX_E);
+			}
+			checkRange(g_expLogTbl[i].f, addr, begin, end, (end - begin) / 1e5f);
+			checkRange(g_expLogTbl[i].f, addr, 1 - 1e-5f, 1 + 1e-5f, 1e-7f);
+		}
+		SgDestroy(sg);
+	}
+	bench("exp2", exp2f, "exp2(x)");
+	bench("log2", log2f, "log2(x)");
+	bench("expm1", expm1f, "expm1(x)");
+	bench("log1p", log1pf, "log1p(x)");
+}
+
+// -inf at the pole, NaN out of the domain and inf at inf
+CYBOZU_TEST_AUTO(log_special)
+{
+	const float inf = INFINITY;
+	const float tbl[] = {
+		-inf, -2, -1, -0.5f, -0.0f, 0, 1e-30f, 1, 8, 1e30f, 3e38f, inf, NAN,
+	};
+	checkEdge(log2f, "log2(x)", tbl);
+	checkEdge(log10f, "log10(x)", tbl);
+	checkEdge(log1pf, "log1p(x)", tbl);
+}
+
 float inv(float x) { return 1 / x; }
 
 CYBOZU_TEST_AUTO(inv)
@@ -191,7 +372,7 @@ CYBOZU_TEST_AUTO(inv)
 		FLT_MIN, 0.5, 1, 5.3, 80, 100, 1000, FLT_MAX
 	};
 	checkTable(inv, addr, tbl);
-	bench("inv", inv, addr);
+	bench("inv", inv, "inv(x)");
 	SgDestroy(sg);
 }
 
@@ -207,8 +388,453 @@ CYBOZU_TEST_AUTO(cosh)
 		-20, -10, -3, -2, -0.3, 0, 0.4, 1, 2, 3, 10, 20
 	};
 	checkTable(coshf, addr, tbl);
-	bench("cosh", coshf, addr);
+	bench("cosh", coshf, "cosh(x)");
+	SgDestroy(sg);
+}
+
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+	float begin;
+	float end;
+} g_hyperTbl[] = {
+	{ "sinh(x)", sinhf, sinh, -10, 10 }, // the error of exp(x) for float exceeds MAX_E for x > 10
+	{ "asinh(x)", asinhf, asinh, -1e3f, 1e3f },
+	{ "acosh(x)", acoshf, acosh, 1, 1e3f },
+	{ "atanh(x)", atanhf, atanh, -0.999f, 0.999f },
+};
+
+CYBOZU_TEST_AUTO(hyperbolic)
+{
+	const float tbl[] = {
+		1e-30f, -1e-30f, 1e-7f, -1e-7f, 1e-4f, -1e-4f, 0.5f, -0.5f, 0.999f, 1, 1.0001f, 2, 3, 10, 1e10f, -1e10f, 1e30f,
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_hyperTbl); i++) {
+		const char *src = g_hyperTbl[i].src;
+		const float begin = g_hyperTbl[i].begin;
+		const float end = g_hyperTbl[i].end;
+		printf("%s\n", src);
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float x[CYBOZU_NUM_OF_ARRAY(tbl)];
+			size_t n = 0;
+			for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+				// skip x out of the domain and the overflow of sinh
+				if (g_hyperTbl[i].f == sinhf && std::fabs(tbl[j]) > 10) continue;
+				if (g_hyperTbl[i].f == atanhf && std::fabs(tbl[j]) >= 1) continue;
+				if (g_hyperTbl[i].f == acoshf && tbl[j] < 1) continue;
+				x[n++] = tbl[j];
+			}
+			float y[CYBOZU_NUM_OF_ARRAY(tbl)];
+			addr(y, x, n);
+			for (size_t j = 0; j < n; j++) {
+				CYBOZU_TEST_ASSERT(diff(g_hyperTbl[i].f(x[j]), y[j]) <= MAX_E);
+			}
+			checkRange(g_hyperTbl[i].f, addr, begin, end, (end - begin) / 1e5f);
+		}
+		SgDestroy(sg);
+	}
+	bench("sinh", sinhf, "sinh(x)");
+	bench("asinh", asinhf, "asinh(x)");
+}
+
+CYBOZU_TEST_AUTO(hyperbolic_special)
+{
+	const float inf = INFINITY;
+	const struct {
+		const char *src;
+		float x;
+		float y;
+	} tbl[] = {
+		{ "atanh(x)", 1, inf },
+		{ "atanh(x)", -1, -inf },
+		{ "atanh(x)", 0, 0 },
+		{ "atanh(x)", -0.0f, -0.0f },
+		{ "sinh(x)", -0.0f, -0.0f },
+		{ "asinh(x)", -0.0f, -0.0f },
+		{ "acosh(x)", 1, 0 },
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, tbl[i].src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float y;
+			addr(&y, &tbl[i].x, 1);
+			CYBOZU_TEST_EQUAL(f2u(y), f2u(tbl[i].y));
+		}
+		SgDestroy(sg);
+	}
+	const char *nanTbl[][2] = {
+		{ "atanh(x)", "1.5" }, { "atanh(x)", "-2" }, { "acosh(x)", "0.5" }, { "acosh(x)", "-3" },
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nanTbl); i++) {
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, nanTbl[i][0]);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			const float x = float(atof(nanTbl[i][1]));
+			float y;
+			addr(&y, &x, 1);
+			CYBOZU_TEST_ASSERT(std::isnan(y));
+		}
+		SgDestroy(sg);
+	}
+	// large arguments where exp(|x|), 1/exp(|x|) and x^2 overflow
+	const float bigTbl[] = { -inf, -3e38f, -1e30f, -1e9f, -100, -89, 89, 89.4f, 100, 1e9f, 1e30f, 3e38f, inf };
+	checkEdge(sinhf, "sinh(x)", bigTbl, 1e-5f);
+	checkEdge(asinhf, "asinh(x)", bigTbl);
+	const float bigTbl2[] = { 1, 2.7e8f, 1e9f, 1e30f, 3e38f, inf };
+	checkEdge(acoshf, "acosh(x)", bigTbl2);
+	SgCode *sg = SgCreate();
+	SgFuncFloatM g = (SgFuncFloatM)SgGetFuncAddr(sg, "s, c = sinhcosh(x)");
+	CYBOZU_TEST_ASSERT(g);
+	if (g) {
+		const size_t N = CYBOZU_NUM_OF_ARRAY(bigTbl);
+		float s[N], c[N];
+		float *const dsts[] = { s, c };
+		g(dsts, bigTbl, N);
+		for (size_t i = 0; i < N; i++) {
+			const float s0 = sinhf(bigTbl[i]), c0 = coshf(bigTbl[i]);
+			if (std::isinf(s0)) {
+				CYBOZU_TEST_EQUAL(f2u(s[i]), f2u(s0));
+				CYBOZU_TEST_EQUAL(f2u(c[i]), f2u(c0));
+			} else {
+				CYBOZU_TEST_ASSERT(diff(s0, s[i]) <= 1e-5f);
+				CYBOZU_TEST_ASSERT(diff(c0, c[i]) <= 1e-5f);
+			}
+		}
+	}
+	SgDestroy(sg);
+}
+
+CYBOZU_TEST_AUTO(sinhcosh)
+{
+	const size_t N = 300;
+	floatVec x(N), s(N + 1, 123), c(N + 1, 123);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.1f - 15;
+	}
+	SgCode *sg = SgCreate();
+	SgFuncFloatM g = (SgFuncFloatM)SgGetFuncAddr(sg, "s, c = sinhcosh(x)");
+	CYBOZU_TEST_ASSERT(g);
+	if (g) {
+		float *const dsts[] = { &s[0], &c[0] };
+		g(dsts, &x[0], N);
+		for (size_t i = 0; i < N; i++) {
+			CYBOZU_TEST_ASSERT(diff(sinhf(x[i]), s[i]) <= MAX_E);
+			CYBOZU_TEST_ASSERT(diff(coshf(x[i]), c[i]) <= MAX_E);
+		}
+		CYBOZU_TEST_EQUAL(f2u(s[N]), f2u(123));
+		CYBOZU_TEST_EQUAL(f2u(c[N]), f2u(123));
+	}
+	SgDestroy(sg);
+}
+
+double sigmoidD(double x) { return 1 / (1 + exp(-x)); }
+double softplusD(double x) { return x > 0 ? x + log1p(exp(-x)) : log1p(exp(x)); }
+double reluD(double x) { return x <= 0 ? 0 : x; }
+double leakyReluD(double x) { return x < 0 ? x * 0.1 : x; }
+double eluD(double x) { return x > 0 ? x : expm1(x); }
+double siluD(double x) { return x * sigmoidD(x); }
+double mishD(double x) { return x * tanh(softplusD(x)); }
+
+float sigmoid(float x) { return float(sigmoidD(x)); }
+float softplus(float x) { return float(softplusD(x)); }
+float relu(float x) { return x <= 0 ? 0 : x; }
+float leakyRelu(float x) { return x < 0 ? x * 0.1f : x; }
+float elu(float x) { return float(eluD(x)); }
+float silu(float x) { return float(siluD(x)); }
+float mish(float x) { return float(mishD(x)); }
+
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+} g_actTbl[] = {
+	{ "tanh(x)", tanhf, tanh },
+	{ "sigmoid(x)", sigmoid, sigmoidD },
+	{ "softplus(x)", softplus, softplusD },
+	{ "relu(x)", relu, reluD },
+	{ "leaky_relu(x, 0.1)", leakyRelu, leakyReluD },
+	{ "elu(x)", elu, eluD },
+	{ "silu(x)", silu, siluD },
+	{ "swish(x)", silu, siluD },
+	{ "mish(x)", mish, mishD },
+};
+
+CYBOZU_TEST_AUTO(activation)
+{
+	const float tbl[] = {
+		-1000, -100, -20, -3, -1, -1e-5, 0, 1e-5, 1, 3, 20, 100, 1000
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_actTbl); i++) {
+		const char *src = g_actTbl[i].src;
+		printf("%s\n", src);
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float (*f)(float) = g_actTbl[i].f;
+			checkTable(f, addr, tbl);
+			checkRange(f, addr, -10, 10, 1e-3);
+			checkRange(f, addr, -1e-3, 1e-3, 1e-7);
+		}
+		SgDestroy(sg);
+		checkNaN(src);
+	}
+	bench("tanh", tanhf, "tanh(x)");
+	bench("sigmoid", sigmoid, "sigmoid(x)");
+}
+
+/*
+	exp and the functions using it around the overflow and at +-inf
+	AVX2 and NEON build 2^n without vscalefps
+	the error of x log2(e) - n is about |x| 2^-24, so maxe is 1e-5
+*/
+CYBOZU_TEST_AUTO(exp_edge)
+{
+	const float inf = INFINITY;
+	const float tbl[] = {
+		-inf, -3e38f, -110, -87, -80, -1, 0, 1, 80, 88.5f, 88.7f, 89, 89.4f, 100, 3e38f, inf
+	};
+	const struct {
+		const char *src;
+		float (*f)(float);
+	} funcTbl[] = {
+		{ "exp(x)", expf },
+		{ "exp2(x)", exp2f },
+		{ "expm1(x)", expm1f },
+		{ "cosh(x)", coshf },
+		{ "sigmoid(x)", sigmoid },
+		{ "softplus(x)", softplus },
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(funcTbl); i++) {
+		checkEdge(funcTbl[i].f, funcTbl[i].src, tbl, 1e-5f);
+	}
+}
+
+double normcdfD(double x) { return erfc(-x / sqrt(2.0)) / 2; }
+double geluD(double x) { return x * normcdfD(x); }
+// x (1 + tanh(y)) / 2 = x / (1 + exp(-2y))
+double geluTanhD(double x) { return x / (1 + exp(-2 * 0.79788456080286536 * (x + 0.044715 * x * x * x))); }
+
+float normcdf(float x) { return float(normcdfD(x)); }
+float gelu(float x) { return float(geluD(x)); }
+float geluTanh(float x) { return float(geluTanhD(x)); }
+
+/*
+	the error of erfc(x) for float increases with x^2
+	because of the error of exp(-x^2)
+*/
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+	float begin;
+	float end;
+} g_erfTbl[] = {
+	{ "erf(x)", erff, erf, -5, 5 },
+	{ "erfc(x)", erfcf, erfc, -5, 2 },
+	{ "normcdf(x)", normcdf, normcdfD, -2.5, 5 },
+	{ "gelu(x)", gelu, geluD, -2.5, 5 },
+	{ "gelu_tanh(x)", geluTanh, geluTanhD, -3, 5 },
+};
+
+CYBOZU_TEST_AUTO(erf)
+{
+	const float tbl[] = {
+		-1, -0.5, -1e-5, 0, 1e-5, 0.3, 1, 1.5
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_erfTbl); i++) {
+		const char *src = g_erfTbl[i].src;
+		printf("%s\n", src);
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float (*f)(float) = g_erfTbl[i].f;
+			checkTable(f, addr, tbl);
+			checkRange(f, addr, g_erfTbl[i].begin, g_erfTbl[i].end, 1e-3);
+			checkRange(f, addr, -1e-3, 1e-3, 1e-7);
+		}
+		SgDestroy(sg);
+		checkNaN(src);
+	}
+	bench("erf", erff, "erf(x)");
+	bench("gelu", gelu, "gelu(x)");
+	bench("gelu_tanh", geluTanh, "gelu_tanh(x)");
+}
+
+/*
+	sinf etc. for x in [1e5, 1e6] and the table cover
+	the large argument reduction for |x| > 2^18
+*/
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+} g_trigTbl[] = {
+	{ "sin(x)", sinf, sin },
+	{ "cos(x)", cosf, cos },
+	{ "tan(x)", tanf, tan },
+};
+
+CYBOZU_TEST_AUTO(trig)
+{
+	const float tbl[] = {
+		-1e30f, -1e6f, -100, -3, -1, -1e-5f, 0, 1e-5f, 0.5f, 1, 1.5707964f, 3, 100, 262145, 1e6f, 1e30f, FLT_MAX
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_trigTbl); i++) {
+		const char *src = g_trigTbl[i].src;
+		printf("%s\n", src);
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float (*f)(float) = g_trigTbl[i].f;
+			checkTable(f, addr, tbl);
+			checkRange(f, addr, -10, 10, 1e-3);
+			checkRange(f, addr, -1e-3, 1e-3, 1e-7);
+			checkRange(f, addr, 1e5, 1e6, 31);
+		}
+		SgDestroy(sg);
+	}
+	bench("sin", sinf, "sin(x)");
+	bench("tan", tanf, "tan(x)");
+}
+
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+	float begin;
+	float end;
+} g_invTrigTbl[] = {
+	{ "atan(x)", atanf, atan, -10, 10 },
+	{ "asin(x)", asinf, asin, -1, 0.999f },
+	{ "acos(x)", acosf, acos, -1, 0.999f },
+};
+
+CYBOZU_TEST_AUTO(invTrig)
+{
+	const float tbl[] = {
+		-1, -0.5f, -1e-5f, 0, 1e-5f, 0.41421357f, 0.5f, 0.70710677f, 1
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_invTrigTbl); i++) {
+		const char *src = g_invTrigTbl[i].src;
+		printf("%s\n", src);
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float (*f)(float) = g_invTrigTbl[i].f;
+			checkTable(f, addr, tbl);
+			checkRange(f, addr, g_invTrigTbl[i].begin, g_invTrigTbl[i].end, 1e-4);
+			checkRange(f, addr, -1e-3, 1e-3, 1e-7);
+		}
+		SgDestroy(sg);
+	}
+	{
+		const float tbl2[] = { -1e30f, -1e5f, 1e5f, 1e30f, FLT_MAX };
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, "atan(x)");
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) checkTable(atanf, addr, tbl2);
+		SgDestroy(sg);
+	}
+	bench("atan", atanf, "atan(x)");
+	bench("asin", asinf, "asin(x)");
+}
+
+float rsqrt(float x) { return 1 / std::sqrt(x); }
+double rsqrtD(double x) { return 1 / std::sqrt(x); }
+
+const struct {
+	const char *src;
+	float (*f)(float);
+	double (*fD)(double);
+} g_sqrtTbl[] = {
+	{ "sqrt(x)", sqrtf, sqrt },
+	{ "rsqrt(x)", rsqrt, rsqrtD },
+};
+
+CYBOZU_TEST_AUTO(sqrt)
+{
+	const float tbl[] = {
+		1e-30f, FLT_MIN, 1e-5f, 0.5f, 1, 2, 3, 1e5f, 1e30f, FLT_MAX
+	};
+	const char *modeTbl[] = { "sqrt=exact", "sqrt=newton" };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(modeTbl); k++) {
+		for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_sqrtTbl); i++) {
+			const char *src = g_sqrtTbl[i].src;
+			printf("%s %s\n", src, modeTbl[k]);
+			SgCode *sg = SgCreate();
+			CYBOZU_TEST_EQUAL(SgSetOpt(sg, modeTbl[k]), 0);
+			SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, src);
+			CYBOZU_TEST_ASSERT(addr);
+			if (addr) {
+				checkTable(g_sqrtTbl[i].f, addr, tbl);
+				checkRange(g_sqrtTbl[i].f, addr, 1e-3, 100, 1e-3);
+				if (i == 0) {
+					const float x[] = { 0, INFINITY, -1 };
+					float y[3];
+					addr(y, x, 3);
+					CYBOZU_TEST_EQUAL(f2u(y[0]), f2u(x[0]));
+					CYBOZU_TEST_EQUAL(f2u(y[1]), f2u(x[1]));
+					CYBOZU_TEST_ASSERT(std::isnan(y[2]));
+				}
+			}
+			SgDestroy(sg);
+		}
+	}
+	// the estimate of vrsqrtps has the relative error 1.5 * 2^-12 at most
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_sqrtTbl); i++) {
+		SgCode *sg = SgCreate();
+		CYBOZU_TEST_EQUAL(SgSetOpt(sg, "sqrt=approx"), 0);
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, g_sqrtTbl[i].src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			float y[CYBOZU_NUM_OF_ARRAY(tbl)];
+			addr(y, tbl, CYBOZU_NUM_OF_ARRAY(tbl));
+			for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+				CYBOZU_TEST_ASSERT(diff(g_sqrtTbl[i].f(tbl[j]), y[j]) < 1.0f / 2048);
+			}
+		}
+		SgDestroy(sg);
+	}
+	{
+		SgCode *sg = SgCreate();
+		CYBOZU_TEST_ASSERT(SgSetOpt(sg, "sqrt=fast") != 0);
+		SgDestroy(sg);
+	}
+	bench("sqrt", sqrtf, "sqrt(x)");
+	bench("rsqrt", rsqrt, "rsqrt(x)");
+}
+
+CYBOZU_TEST_AUTO(cbrt)
+{
+	const float tbl[] = {
+		-1e30f, -8, -1, -1e-5f, -1e-40f, 1e-40f, FLT_MIN, 1e-5f, 0.125f, 1, 27, 1e30f, FLT_MAX
+	};
+	SgCode *sg = SgCreate();
+	SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, "cbrt(x)");
+	CYBOZU_TEST_ASSERT(addr);
+	if (addr) {
+		checkTable(cbrtf, addr, tbl);
+		checkRange(cbrtf, addr, -10, 10, 1e-3);
+		const float x[] = { 0, -0.0f, INFINITY, -INFINITY };
+		float y[4];
+		addr(y, x, 4);
+		for (size_t i = 0; i < 4; i++) {
+			CYBOZU_TEST_EQUAL(f2u(y[i]), f2u(x[i]));
+		}
+	}
 	SgDestroy(sg);
+	bench("cbrt", cbrtf, "cbrt(x)");
 }
 
 CYBOZU_TEST_AUTO(red_sum)
@@ -231,3 +857,1627 @@ CYBOZU_TEST_AUTO(red_sum)
 	}
 	SgDestroy(sg);
 }
+
+CYBOZU_TEST_AUTO(red_sum_tail)
+{
+	SgCode *sg = SgCreate();
+	SgFuncFloat1Reduce addr = (SgFuncFloat1Reduce)SgGetFuncAddr(sg, "red_sum(x*x+1)");
+	if (addr == 0) {
+		CYBOZU_TEST_ASSERT(false);
+		return;
+	}
+	const size_t N = 100;
+	float tbl[N];
+	for (size_t i = 0; i < N; i++) {
+		tbl[i] = float(i);
+	}
+	for (size_t n = 0; n <= N; n++) {
+		float r = addr(tbl, n);
+		float ok = float((n - 1) * n * (2 * n - 1) / 6 + n);
+		if (n == 0) ok = 0;
+		CYBOZU_TEST_EQUAL(r, ok);
+	}
+	SgDestroy(sg);
+}
+
+/*
+	double
+*/
+typedef std::vector<double> doubleVec;
+const double MAX_E_D = 1e-14;
+
+double diffD(double x, double y)
+{
+	double d = std::fabs(x - y);
+	return std::fabs(x) < 1e-300 ? d : d / std::fabs(x);
+}
+
+
+/*
+	return the function of src for double generated for isa
+	return 0 if the isa is not supported
+*/
+const void *getFuncAddrD(SgCode *sg, const char *isa, const char *src)
+{
+	std::string opt = std::string("isa=") + isa;
+	if (*isa && SgSetOpt(sg, opt.c_str()) != 0) return 0;
+	if (!setType(sg, SG_DOUBLE, SG_DOUBLE)) return 0;
+	const void *addr = SgGetFuncAddr(sg, src);
+	CYBOZU_TEST_ASSERT(addr);
+	return addr;
+}
+
+void checkD(double (*f)(double), const char *src, const doubleVec& x)
+{
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		SgFuncDouble1 g = (SgFuncDouble1)getFuncAddrD(sg, g_isaTbl[k], src);
+		if (g) {
+			// check every length for the tail
+			for (size_t n = 0; n <= x.size(); n += (n < 20 ? 1 : 97)) {
+				doubleVec y(n + 1);
+				const double keep = 9999;
+				y[n] = keep;
+				g(&y[0], &x[0], n);
+				double maxe = 0;
+				for (size_t i = 0; i < n; i++) {
+					double e = diffD(f(x[i]), y[i]);
+					if (!(e <= MAX_E_D)) {
+						printf("err %s %s x=%.17e y0=%.17e y1=%.17e e=%e\n", src, g_isaTbl[k], x[i], f(x[i]), y[i], e);
+					}
+					if (e > maxe) maxe = e;
+				}
+				CYBOZU_TEST_ASSERT(maxe <= MAX_E_D);
+				CYBOZU_TEST_EQUAL(y[n], keep);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+// the double version of checkEdge
+void checkEdgeD(double (*f)(double), const char *src, const doubleVec& x)
+{
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		SgFuncDouble1 g = (SgFuncDouble1)getFuncAddrD(sg, g_isaTbl[k], src);
+		if (g) {
+			doubleVec y(x.size());
+			g(&y[0], &x[0], x.size());
+			for (size_t i = 0; i < x.size(); i++) {
+				const double y0 = f(x[i]);
+				bool ok;
+				if (std::isnan(y0)) {
+					ok = std::isnan(y[i]);
+				} else if (std::isinf(y0)) {
+					ok = std::isinf(y[i]) && std::signbit(y[i]) == std::signbit(y0);
+				} else {
+					ok = diffD(y0, y[i]) <= MAX_E_D;
+				}
+				if (!ok) printf("err %s isa=%s x=%.17e y0=%.17e y1=%.17e\n", src, g_isaTbl[k], x[i], y0, y[i]);
+				CYBOZU_TEST_ASSERT(ok);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+doubleVec makeRangeD(double begin, double end, size_t n)
+{
+	doubleVec v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i] = begin + (end - begin) * i / n;
+	}
+	return v;
+}
+
+double addD(double x) { return x * 0.1 + 3; }
+double invD(double x) { return 1 / x; }
+
+CYBOZU_TEST_AUTO(double_op)
+{
+	checkD(addD, "x*0.1+3", makeRangeD(-10, 10, 1000));
+	checkD(invD, "inv(x)", makeRangeD(0.1, 100, 1000));
+}
+
+CYBOZU_TEST_AUTO(double_exp)
+{
+	const double tbl[] = {
+		-1000, -700, -100, -5.3, -1, -DBL_MIN, 0, DBL_MIN, 0.5, 1, 5.3, 100, 700,
+	};
+	checkD(exp, "exp(x)", doubleVec(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl)));
+	checkD(exp, "exp(x)", makeRangeD(-3, 3, 1000));
+	checkD(exp, "exp(x)", makeRangeD(10, 11, 1000));
+}
+
+// exp saturates to 0 or inf and the functions using it
+CYBOZU_TEST_AUTO(double_exp_edge)
+{
+	const double inf = HUGE_VAL;
+	const double tbl[] = {
+		-inf, -1e300, -746, -745.2, -745.1, -700, -1, 0, 1, 700, 709.7, 709.8, 710.4, 1e300, inf,
+	};
+	const doubleVec x(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl));
+	checkEdgeD(exp, "exp(x)", x);
+	checkEdgeD(expm1, "expm1(x)", x);
+	checkEdgeD(cosh, "cosh(x)", x);
+	checkEdgeD(sigmoidD, "sigmoid(x)", x);
+	checkEdgeD(softplusD, "softplus(x)", x);
+	checkEdgeD(mishD, "mish(x)", x);
+	const double tbl2[] = {
+		-inf, -1e300, -1076, -1074, -1000, -1, 0, 1, 1000, 1023.9, 1024, 1e300, inf,
+	};
+	checkEdgeD(exp2, "exp2(x)", doubleVec(tbl2, tbl2 + CYBOZU_NUM_OF_ARRAY(tbl2)));
+}
+
+CYBOZU_TEST_AUTO(double_log)
+{
+	const double tbl[] = {
+		DBL_MIN, 0.5, 1, 5.3, 80, 100, 1000, 1e100, DBL_MAX,
+	};
+	checkD(log, "log(x)", doubleVec(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl)));
+	checkD(log, "log(x)", makeRangeD(1e-5, 1, 1000));
+	checkD(log, "log(x)", makeRangeD(1 - 1e-5, 1 + 1e-5, 1000));
+	checkD(log, "log(x)", makeRangeD(1000, 1001, 1000));
+}
+
+CYBOZU_TEST_AUTO(double_expLog)
+{
+	const double tbl[] = {
+		1e-300, 1e-100, 1e-7, -1e-7, 1e-4, -1e-4, 0.5, 1, 2, 3, 8, 10, 100, 1e10, 1e300
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_expLogTbl); i++) {
+		const double begin = g_expLogTbl[i].begin;
+		const double end = g_expLogTbl[i].end;
+		doubleVec x;
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+			if (begin <= tbl[j] && tbl[j] <= end) x.push_back(tbl[j]);
+		}
+		checkD(g_expLogTbl[i].fD, g_expLogTbl[i].src, x);
+		checkD(g_expLogTbl[i].fD, g_expLogTbl[i].src, makeRangeD(begin, end, 1000));
+		checkD(g_expLogTbl[i].fD, g_expLogTbl[i].src, makeRangeD(1 - 1e-5, 1 + 1e-5, 1000));
+	}
+}
+
+CYBOZU_TEST_AUTO(double_log_special)
+{
+	const double tbl[] = {
+		-HUGE_VAL, -2, -1, -0.5, -0.0, 0, 1e-300, 1, 8, 1e300, DBL_MAX, HUGE_VAL, NAN,
+	};
+	const doubleVec x(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl));
+	checkEdgeD(log2, "log2(x)", x);
+	checkEdgeD(log10, "log10(x)", x);
+	checkEdgeD(log1p, "log1p(x)", x);
+}
+
+CYBOZU_TEST_AUTO(double_cosh)
+{
+	checkD(cosh, "cosh(x)", makeRangeD(-20, 20, 1000));
+}
+
+CYBOZU_TEST_AUTO(double_hyperbolic)
+{
+	const double tbl[] = {
+		1e-300, 1e-7, -1e-7, 1e-4, -1e-4, 0.5, -0.5, 0.999, 1, 1.0001, 2, 3, 10, 1e10, 1e300
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_hyperTbl); i++) {
+		const double begin = g_hyperTbl[i].begin;
+		const double end = g_hyperTbl[i].end;
+		doubleVec x;
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+			if (begin <= tbl[j] && tbl[j] <= end) x.push_back(tbl[j]);
+		}
+		checkD(g_hyperTbl[i].fD, g_hyperTbl[i].src, x);
+		checkD(g_hyperTbl[i].fD, g_hyperTbl[i].src, makeRangeD(begin, end, 1000));
+	}
+	const double hugeTbl[] = { 1e10, 1e100, 1e300, 1e308, DBL_MAX, HUGE_VAL };
+	checkEdgeD(asinh, "asinh(x)", doubleVec(hugeTbl, hugeTbl + CYBOZU_NUM_OF_ARRAY(hugeTbl)));
+	checkEdgeD(acosh, "acosh(x)", doubleVec(hugeTbl, hugeTbl + CYBOZU_NUM_OF_ARRAY(hugeTbl)));
+	const double bigTbl[] = { -HUGE_VAL, -1e300, -711, -709, -100, 100, 709, 710, 710.4, 711, 1e300, HUGE_VAL };
+	checkEdgeD(sinh, "sinh(x)", doubleVec(bigTbl, bigTbl + CYBOZU_NUM_OF_ARRAY(bigTbl)));
+	checkEdgeD(asinh, "asinh(x)", doubleVec(bigTbl, bigTbl + CYBOZU_NUM_OF_ARRAY(bigTbl)));
+}
+
+CYBOZU_TEST_AUTO(double_activation)
+{
+	const double tbl[] = {
+		-1000, -100, -20, -3, -1, -1e-5, 0, 1e-5, 1, 3, 20, 100, 1000
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_actTbl); i++) {
+		checkD(g_actTbl[i].fD, g_actTbl[i].src, doubleVec(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl)));
+		checkD(g_actTbl[i].fD, g_actTbl[i].src, makeRangeD(-20, 20, 1000));
+		checkD(g_actTbl[i].fD, g_actTbl[i].src, makeRangeD(-1e-3, 1e-3, 1000));
+	}
+}
+
+CYBOZU_TEST_AUTO(double_erf)
+{
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_erfTbl); i++) {
+		checkD(g_erfTbl[i].fD, g_erfTbl[i].src, makeRangeD(-5, 5, 1000));
+		checkD(g_erfTbl[i].fD, g_erfTbl[i].src, makeRangeD(-1e-3, 1e-3, 1000));
+	}
+}
+
+/*
+	unroll=<num> is lowered if the registers are not enough
+	such as double log and exp on AVX2 (15 ymm registers)
+*/
+CYBOZU_TEST_AUTO(double_unroll)
+{
+#ifdef SG_X64
+	const char *isa = " isa=avx2";
+#else
+	const char *isa = "";
+#endif
+	const struct {
+		const char *src;
+		double (*f)(double);
+	} tbl[] = {
+		{ "log(x)", log },
+		{ "exp(x)", exp },
+		{ "tanh(x)", tanh },
+	};
+	const doubleVec x = makeRangeD(0.1, 10, 100);
+	for (int unrollN = 1; unrollN <= 5; unrollN++) {
+		for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+			SgCode *sg = SgCreate();
+			char opt[64];
+			snprintf(opt, sizeof(opt), "unroll=%d%s", unrollN, isa);
+			if (SgSetOpt(sg, opt) != 0 || SgSetType(sg, SG_DOUBLE, SG_DOUBLE) != 0) {
+				SgDestroy(sg);
+				continue;
+			}
+			SgFuncDouble1 g = (SgFuncDouble1)SgGetFuncAddr(sg, tbl[i].src);
+			CYBOZU_TEST_ASSERT(g);
+			if (g) {
+				doubleVec y(x.size());
+				g(&y[0], &x[0], x.size());
+				double maxe = 0;
+				for (size_t j = 0; j < x.size(); j++) {
+					double e = diffD(tbl[i].f(x[j]), y[j]);
+					if (e > maxe) maxe = e;
+				}
+				CYBOZU_TEST_ASSERT(maxe <= MAX_E_D);
+			}
+			SgDestroy(sg);
+		}
+	}
+}
+
+double digammaRef(double x)
+{
+	const long double pi = 3.141592653589793238462643383279502884L;
+	if (x <= 0 && std::floor(x) >= x) return NAN;
+	if (x < 0) {
+		const long double r = x - std::round(x);
+		return digammaRef(1 - x) - double(pi / std::tan(pi * r));
+	}
+	long double z = x, s = 0;
+	while (z < 30) {
+		s += 1 / z;
+		z += 1;
+	}
+	const long double w = 1 / (z * z);
+	return double(std::log(z) - 0.5L / z - w * (1.0L / 12 - w * (1.0L / 120 - w * (1.0L / 252 - w * (1.0L / 240 - w / 132)))) - s);
+}
+
+// the inverse of normcdf by the bisection
+double normInvRef(double p)
+{
+	if (!(0 <= p && p <= 1)) return NAN;
+	if (p > 0.5) return -normInvRef(1 - p);
+	if (p <= 0) return -HUGE_VAL;
+	long double lo = -40, hi = 0;
+	for (int i = 0; i < 200; i++) {
+		const long double mid = (lo + hi) / 2;
+		if (std::erfc(-mid / std::sqrt(2.0L)) / 2 < p) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	return double((lo + hi) / 2);
+}
+
+// |x - y| / max(|x|, 1) ; the relative error of lgamma and digamma is large around their zeros
+double diffAbsRel(double x, double y)
+{
+	if (std::isnan(x) || std::isnan(y)) return std::isnan(x) && std::isnan(y) ? 0 : HUGE_VAL;
+	if (std::isinf(x) || std::isinf(y)) return std::isinf(x) && std::isinf(y) && (x > 0) == (y > 0) ? 0 : HUGE_VAL;
+	const double d = std::fabs(x - y);
+	return std::fabs(x) < 1 ? d : d / std::fabs(x);
+}
+
+double lgammaD(double x) { return std::lgamma(x); }
+
+const struct {
+	const char *src;
+	double (*fD)(double);
+	double begin;
+	double end;
+	float maxe;
+	double maxeD;
+} g_specialTbl[] = {
+	// the reflection loses a few bits of float around the poles
+	{ "lgamma(x)", lgammaD, -10, 30, 5e-6f, 1e-14 },
+	{ "digamma(x)", digammaRef, -10, 30, 2e-6f, 1e-14 },
+	{ "norminv(x)", normInvRef, 0, 1, 1e-6f, 1e-14 },
+};
+
+/*
+	check float and double versions of special functions for all isa
+*/
+CYBOZU_TEST_AUTO(special)
+{
+	const double tbl[] = {
+		-0.0, 1e-30, 1e-7, 1e-4, 0.02, 0.3, 0.5, 0.5 + 1e-7, 0.9, 1, 1 - 1e-7, 1.4616321449683622, 2, 2.5, 7.9, 8, 10, 100, 1e5, 1e10, 1e30,
+		-0.5, -1, -1.5, -2.99, -3, -7.25, -1e-7, 1e-300, 1 - 1e-12, 1e-12, HUGE_VAL, -HUGE_VAL, NAN, 1.5, -0.1,
+		// tiny and denormal
+		1e-38, -1e-38, 1e-40, -1e-40, 1e-45, -1e-35, -1e-20, 1e-310, -1e-310, 5e-324, -1e-200,
+	};
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_specialTbl); k++) {
+		const char *src = g_specialTbl[k].src;
+		double (*fD)(double) = g_specialTbl[k].fD;
+		doubleVec x = makeRangeD(g_specialTbl[k].begin, g_specialTbl[k].end, 2000);
+		x.insert(x.end(), tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl));
+		const size_t n = x.size();
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(g_isaTbl); j++) {
+			for (int isDouble = 0; isDouble < 2; isDouble++) {
+				SgCode *sg = SgCreate();
+				std::string opt = std::string("isa=") + g_isaTbl[j];
+				if (*g_isaTbl[j] && SgSetOpt(sg, opt.c_str()) != 0) {
+					SgDestroy(sg);
+					continue;
+				}
+				if (isDouble && !setType(sg, SG_DOUBLE, SG_DOUBLE)) {
+					SgDestroy(sg);
+					continue;
+				}
+				const void *addr = SgGetFuncAddr(sg, src);
+				CYBOZU_TEST_ASSERT(addr);
+				if (addr) {
+					doubleVec y(n);
+					if (isDouble) {
+						((SgFuncDouble1)addr)(y.data(), x.data(), n);
+					} else {
+						floatVec xf(n), yf(n);
+						for (size_t i = 0; i < n; i++) xf[i] = float(x[i]);
+						((SgFuncFloat1)addr)(yf.data(), xf.data(), n);
+						for (size_t i = 0; i < n; i++) y[i] = yf[i];
+					}
+					int err = 0;
+					for (size_t i = 0; i < n; i++) {
+						double ok;
+						if (isDouble) {
+							ok = fD(x[i]);
+						} else {
+							ok = float(fD(float(x[i])));
+						}
+						const double e = diffAbsRel(ok, y[i]);
+						if (!(e <= (isDouble ? g_specialTbl[k].maxeD : g_specialTbl[k].maxe))) {
+							if (err++ < 4) printf("err %s %s %s x=%.17e ok=%.17e y=%.17e\n", src, g_isaTbl[j], isDouble ? "double" : "float", x[i], ok, y[i]);
+						}
+					}
+					CYBOZU_TEST_EQUAL(err, 0);
+				}
+				SgDestroy(sg);
+			}
+		}
+	}
+}
+
+/*
+	use_mem=0 and log_use_mem=0 must fall back to the constants in memory
+	for the functions whose constants do not fit in registers
+*/
+CYBOZU_TEST_AUTO(use_mem)
+{
+	const struct {
+		const char *src;
+		double (*fD)(double);
+	} tbl[] = {
+		{ "erf(x)", erf },
+		{ "mish(x)", mishD },
+		{ "cos(x)", cos },
+		{ "lgamma(x)", lgammaD },
+	};
+	const char *optTbl[] = { "use_mem=0", "log_use_mem=0" };
+	const doubleVec x = makeRangeD(2.5, 5, 100);
+	const size_t n = x.size();
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(optTbl); i++) {
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(g_isaTbl); j++) {
+			for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(tbl); k++) {
+				for (int isDouble = 0; isDouble < 2; isDouble++) {
+					SgCode *sg = SgCreate();
+					std::string opt = optTbl[i];
+					if (*g_isaTbl[j]) opt += std::string(" isa=") + g_isaTbl[j];
+					if (SgSetOpt(sg, opt.c_str()) != 0 || (isDouble && !setType(sg, SG_DOUBLE, SG_DOUBLE))) {
+						SgDestroy(sg);
+						continue;
+					}
+					const void *addr = SgGetFuncAddr(sg, tbl[k].src);
+					CYBOZU_TEST_ASSERT(addr);
+					if (addr) {
+						doubleVec y(n);
+						if (isDouble) {
+							((SgFuncDouble1)addr)(y.data(), x.data(), n);
+						} else {
+							floatVec xf(n), yf(n);
+							for (size_t m = 0; m < n; m++) xf[m] = float(x[m]);
+							((SgFuncFloat1)addr)(yf.data(), xf.data(), n);
+							for (size_t m = 0; m < n; m++) y[m] = yf[m];
+						}
+						int err = 0;
+						for (size_t m = 0; m < n; m++) {
+							const double ok = isDouble ? tbl[k].fD(x[m]) : float(tbl[k].fD(float(x[m])));
+							const double e = diffAbsRel(ok, y[m]);
+							if (!(e <= (isDouble ? MAX_E_D : 5e-6))) {
+								if (err++ < 4) printf("err %s %s %s %s x=%.17e ok=%.17e y=%.17e\n", tbl[k].src, opt.c_str(), g_isaTbl[j], isDouble ? "double" : "float", x[m], ok, y[m]);
+							}
+						}
+						CYBOZU_TEST_EQUAL(err, 0);
+					}
+					SgDestroy(sg);
+				}
+			}
+		}
+	}
+}
+
+double sinCosTanD(double x) { return sin(x) + cos(x) + tan(x); }
+
+CYBOZU_TEST_AUTO(double_trig)
+{
+	const double tbl[] = {
+		-1e300, -1e20, -1e9, -3, -1e-5, 0, DBL_MIN, 1, 1.5707963267948966, 1e9, 1073741825, 1e20,
+		std::ldexp(6381956970095103.0, 797), // the hardest case for the argument reduction
+		1e300, DBL_MAX,
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_trigTbl); i++) {
+		checkD(g_trigTbl[i].fD, g_trigTbl[i].src, doubleVec(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl)));
+		checkD(g_trigTbl[i].fD, g_trigTbl[i].src, makeRangeD(-10, 10, 1000));
+		checkD(g_trigTbl[i].fD, g_trigTbl[i].src, makeRangeD(1e8, 1e12, 1000));
+	}
+	// the code buffer is enlarged several times for the three reductions
+	checkD(sinCosTanD, "sin(x) + cos(x) + tan(x)", makeRangeD(0.1, 1, 100));
+}
+
+CYBOZU_TEST_AUTO(double_invTrig)
+{
+	const double tbl[] = {
+		-1, -0.5, -1e-5, 0, DBL_MIN, 0.41421356237309503, 0.5, 1
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_invTrigTbl); i++) {
+		checkD(g_invTrigTbl[i].fD, g_invTrigTbl[i].src, doubleVec(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl)));
+		checkD(g_invTrigTbl[i].fD, g_invTrigTbl[i].src, makeRangeD(g_invTrigTbl[i].begin, g_invTrigTbl[i].end, 1000));
+		checkD(g_invTrigTbl[i].fD, g_invTrigTbl[i].src, makeRangeD(-1e-3, 1e-3, 1000));
+	}
+	checkD(atan, "atan(x)", makeRangeD(-1e10, 1e10, 1000));
+}
+
+CYBOZU_TEST_AUTO(double_sqrt)
+{
+	const double tbl[] = {
+		DBL_MIN, 1e-100, 0.5, 1, 2, 3, 1e100, DBL_MAX
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(g_sqrtTbl); i++) {
+		checkD(g_sqrtTbl[i].fD, g_sqrtTbl[i].src, doubleVec(tbl, tbl + CYBOZU_NUM_OF_ARRAY(tbl)));
+		checkD(g_sqrtTbl[i].fD, g_sqrtTbl[i].src, makeRangeD(1e-3, 100, 1000));
+	}
+	const double tbl2[] = {
+		-DBL_MAX, -1e100, -8, -1e-310, DBL_MIN, 0.125, 1, 27, 1e300
+	};
+	checkD(cbrt, "cbrt(x)", doubleVec(tbl2, tbl2 + CYBOZU_NUM_OF_ARRAY(tbl2)));
+	checkD(cbrt, "cbrt(x)", makeRangeD(-10, 10, 1000));
+}
+
+CYBOZU_TEST_AUTO(double_red_sum)
+{
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		SgFuncDouble1Reduce g = (SgFuncDouble1Reduce)getFuncAddrD(sg, g_isaTbl[k], "red_sum(x*x+1)");
+		if (g) {
+			const size_t N = 100;
+			double tbl[N];
+			for (size_t i = 0; i < N; i++) {
+				tbl[i] = double(i);
+			}
+			for (size_t n = 0; n <= N; n++) {
+				double ok = n == 0 ? 0 : double((n - 1) * n * (2 * n - 1) / 6 + n);
+				CYBOZU_TEST_EQUAL(g(tbl, n), ok);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(double_bench)
+{
+	const size_t N = 4000;
+	doubleVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = 5 + sin(i / 3.141592) * 2;
+	}
+	const struct {
+		double (*f)(double);
+		const char *src;
+	} tbl[] = {
+		{ exp, "exp(x)" },
+		{ log, "log(x)" },
+	};
+	for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+		const size_t C = 10000;
+		printf("%s double\n", tbl[j].src);
+		clock_t begin = clock();
+		for (size_t c = 0; c < C; c++) {
+			for (size_t i = 0; i < N; i++) y[i] = tbl[j].f(x[i]);
+		}
+		printf("C  %6.2f usec\n", (clock() - begin) / (double)CLOCKS_PER_SEC / C * 1e6);
+		for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+			SgCode *sg = SgCreate();
+			SgFuncDouble1 g = (SgFuncDouble1)getFuncAddrD(sg, g_isaTbl[k], tbl[j].src);
+			if (g) {
+				begin = clock();
+				for (size_t c = 0; c < C; c++) g(&y[0], &x[0], N);
+				printf("sg %6.2f usec %s\n", (clock() - begin) / (double)CLOCKS_PER_SEC / C * 1e6, g_isaTbl[k]);
+			}
+			SgDestroy(sg);
+		}
+	}
+}
+
+/*
+	float16/bfloat16
+*/
+typedef std::vector<uint16_t> u16Vec;
+
+float u2f(uint32_t u)
+{
+	float f;
+	memcpy(&f, &u, sizeof(f));
+	return f;
+}
+
+float bf16ToFloat(uint16_t x)
+{
+	return u2f(uint32_t(x) << 16);
+}
+
+// normal numbers only
+float f16ToFloat(uint16_t x)
+{
+	uint32_t sign = uint32_t(x & 0x8000) << 16;
+	uint32_t e = (x >> 10) & 0x1f;
+	uint32_t m = x & 0x3ff;
+	if (e == 0) return 0;
+	return u2f(sign | ((e - 15 + 127) << 23) | (m << 13));
+}
+
+float (*getToFloat(int type))(uint16_t)
+{
+	return type == SG_FLOAT16 ? f16ToFloat : bf16ToFloat;
+}
+
+/*
+	check f on x in [begin, end) given as bit patterns of srcType
+	eps is the relative error of dstType
+*/
+void checkHalf(float (*f)(float), const char *src, int dstType, int srcType, uint16_t begin, uint16_t end, float eps)
+{
+	const size_t n = end - begin;
+	floatVec x(n);
+	u16Vec xh(n);
+	for (size_t i = 0; i < n; i++) {
+		xh[i] = uint16_t(begin + i);
+		x[i] = srcType == SG_FLOAT ? getToFloat(dstType)(xh[i]) : getToFloat(srcType)(xh[i]);
+	}
+	const void *px = srcType == SG_FLOAT ? (const void*)&x[0] : (const void*)&xh[0];
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		if (!setType(sg, dstType, srcType)) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFunc1 g = (SgFunc1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t len = 0; len <= n; len += (len < 40 ? 1 : 101)) {
+				floatVec y(len + 1);
+				u16Vec yh(len + 1);
+				const uint16_t keep = 0x1234;
+				yh[len] = keep;
+				void *py = dstType == SG_FLOAT ? (void*)&y[0] : (void*)&yh[0];
+				g(py, px, len);
+				int err = 0;
+				for (size_t i = 0; i < len; i++) {
+					float y0 = f(x[i]);
+					float y1 = dstType == SG_FLOAT ? y[i] : getToFloat(dstType)(yh[i]);
+					if (!(diff(y0, y1) <= eps)) {
+						if (err++ < 4) printf("err %s %s type=%d,%d x=%e y0=%e y1=%e\n", src, g_isaTbl[k], dstType, srcType, x[i], y0, y1);
+					}
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+				if (dstType != SG_FLOAT) CYBOZU_TEST_EQUAL(yh[len], keep);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+float mul1(float x) { return x * 1; }
+
+CYBOZU_TEST_AUTO(float16)
+{
+	const float eps = 1.0f / 2048 + MAX_E; // rounding error of float16
+	// [0.5, 8)
+	checkHalf(mul1, "x*1", SG_FLOAT, SG_FLOAT16, 0x3800, 0x4800, MAX_E);
+	checkHalf(expf, "exp(x)", SG_FLOAT, SG_FLOAT16, 0x3800, 0x4800, MAX_E);
+	checkHalf(logf, "log(x)", SG_FLOAT16, SG_FLOAT, 0x3800, 0x4800, eps);
+	checkHalf(expf, "exp(x)", SG_FLOAT16, SG_FLOAT16, 0x3800, 0x4800, eps);
+}
+
+CYBOZU_TEST_AUTO(bfloat16)
+{
+	const float eps = 1.0f / 256 + MAX_E; // rounding error of bfloat16
+	// [0.5, 8)
+	checkHalf(mul1, "x*1", SG_FLOAT, SG_BFLOAT16, 0x3f00, 0x4100, MAX_E);
+	checkHalf(expf, "exp(x)", SG_FLOAT, SG_BFLOAT16, 0x3f00, 0x4100, MAX_E);
+	checkHalf(logf, "log(x)", SG_BFLOAT16, SG_FLOAT, 0x3f00, 0x4100, eps);
+	checkHalf(expf, "exp(x)", SG_BFLOAT16, SG_BFLOAT16, 0x3f00, 0x4100, eps);
+	checkHalf(mul1, "x*1", SG_FLOAT16, SG_BFLOAT16, 0x3f00, 0x4100, 1.0f / 2048);
+}
+
+CYBOZU_TEST_AUTO(half_red_sum)
+{
+	const int typeTbl[] = { SG_FLOAT16, SG_BFLOAT16 };
+	for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(typeTbl); j++) {
+		const int type = typeTbl[j];
+		const size_t N = 100;
+		u16Vec x(N);
+		for (size_t i = 0; i < N; i++) {
+			// 1, 2, ..., 100
+			x[i] = type == SG_FLOAT16 ? uint16_t(0x3c00 + i * 0x20) : uint16_t(0x3f80 + i * 4);
+		}
+		for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+			SgCode *sg = SgCreate();
+			std::string opt = std::string("isa=") + g_isaTbl[k];
+			if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+				SgDestroy(sg);
+				continue;
+			}
+			if (!setType(sg, SG_FLOAT, type)) {
+				SgDestroy(sg);
+				continue;
+			}
+			SgFunc1Reduce g = (SgFunc1Reduce)SgGetFuncAddr(sg, "red_sum(x*2)");
+			CYBOZU_TEST_ASSERT(g);
+			if (g) {
+				for (size_t n = 0; n <= N; n++) {
+					float ok = 0;
+					for (size_t i = 0; i < n; i++) ok += getToFloat(type)(x[i]) * 2;
+					CYBOZU_TEST_NEAR(g(&x[0], n), ok, ok * 1e-6 + 1e-6);
+				}
+			}
+			SgDestroy(sg);
+		}
+	}
+}
+
+CYBOZU_TEST_AUTO(badType)
+{
+	SgCode *sg = SgCreate();
+	CYBOZU_TEST_ASSERT(SgSetType(sg, SG_DOUBLE, SG_FLOAT) != 0);
+	CYBOZU_TEST_ASSERT(SgSetType(sg, SG_FLOAT16, SG_DOUBLE) != 0);
+	CYBOZU_TEST_ASSERT(SgSetType(sg, 100, SG_FLOAT) != 0);
+	SgDestroy(sg);
+}
+
+/*
+	integer src
+*/
+template<class T>
+void checkIntSrc(int srcType, float (*f)(float), const char *src, T begin, T end, size_t step)
+{
+	std::vector<T> x;
+	for (int64_t v = begin; v <= end; v += step) x.push_back(T(v));
+	const size_t n = x.size();
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		if (!setType(sg, SG_FLOAT, srcType)) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFunc1 g = (SgFunc1)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t len = 0; len <= n; len += (len < 40 ? 1 : 37)) {
+				floatVec y(len + 1);
+				g(&y[0], &x[0], len);
+				int err = 0;
+				for (size_t i = 0; i < len; i++) {
+					float y0 = f(float(x[i]));
+					if (!(diff(y0, y[i]) <= MAX_E)) {
+						if (err++ < 4) printf("err %s %s type=%d x=%d y0=%e y1=%e\n", src, g_isaTbl[k], srcType, int(x[i]), y0, y[i]);
+					}
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+			}
+		}
+		SgDestroy(sg);
+		// sum of all elements
+		sg = SgCreate();
+		if (*g_isaTbl[k]) SgSetOpt(sg, opt.c_str());
+		SgSetType(sg, SG_FLOAT, srcType);
+		SgFunc1Reduce h = (SgFunc1Reduce)SgGetFuncAddr(sg, "red_sum(x*0.5)");
+		CYBOZU_TEST_ASSERT(h);
+		if (h) {
+			double ok = 0;
+			for (size_t i = 0; i < n; i++) ok += x[i] * 0.5;
+			CYBOZU_TEST_NEAR(h(&x[0], n), ok, fabs(ok) * 1e-5 + 1e-5);
+		}
+		SgDestroy(sg);
+	}
+}
+
+float logScale(float x) { return std::log(x * 0.0039f + 1); }
+float mulAdd(float x) { return x * 0.5f + 3; }
+
+CYBOZU_TEST_AUTO(intSrc)
+{
+	checkIntSrc<uint8_t>(SG_UINT8, logScale, "log(x*0.0039+1)", 0, 255, 1);
+	checkIntSrc<int8_t>(SG_INT8, mulAdd, "x*0.5+3", -128, 127, 1);
+	checkIntSrc<int16_t>(SG_INT16, mulAdd, "x*0.5+3", -32768, 32767, 97);
+	checkIntSrc<int32_t>(SG_INT32, mulAdd, "x*0.5+3", -1000000, 1000000, 3001);
+	SgCode *sg = SgCreate();
+	CYBOZU_TEST_ASSERT(SgSetType(sg, SG_UINT8, SG_DOUBLE) != 0);
+	CYBOZU_TEST_ASSERT(SgSetType(sg, SG_DOUBLE, SG_INT32) != 0);
+	SgDestroy(sg);
+}
+
+/*
+	integer dst
+*/
+float roundByMode(float x, int mode)
+{
+	switch (mode) {
+	case 0: return nearbyintf(x); // the default is the nearest even
+	case 1: return floorf(x);
+	case 2: return ceilf(x);
+	default: return truncf(x);
+	}
+}
+
+template<class T>
+void checkIntDst(int dstType, int mode, double lo, double hi)
+{
+	static const char *modeTbl[] = { "even", "down", "up", "zero" };
+	floatVec x;
+	for (int i = -600; i <= 600; i++) x.push_back(i * 0.25f); // the ties of x*2
+	const float bigTbl[] = { 1e10f, -1e10f, 32767.5f, -32768.5f, 70000, -70000, 3e9f, -3e9f };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(bigTbl); i++) x.push_back(bigTbl[i] / 2);
+	const size_t n = x.size();
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("round=") + modeTbl[mode];
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		if (!setType(sg, dstType, SG_FLOAT)) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFunc1 g = (SgFunc1)SgGetFuncAddr(sg, "x*2");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t len = 0; len <= n; len += (len < 40 ? 1 : 37)) {
+				std::vector<T> y(len + 1);
+				const T keep = 0x5a;
+				y[len] = keep;
+				g(&y[0], &x[0], len);
+				int err = 0;
+				for (size_t i = 0; i < len; i++) {
+					double ok = roundByMode(x[i] * 2, mode);
+					if (ok < lo) ok = lo;
+					if (ok > hi) ok = hi;
+					if (y[i] != T(ok)) {
+						if (err++ < 4) printf("err %s type=%d %s x=%e ok=%e y=%e\n", opt.c_str(), dstType, g_isaTbl[k], x[i] * 2, ok, double(y[i]));
+					}
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+				CYBOZU_TEST_EQUAL(y[len], keep);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(intDst)
+{
+	for (int mode = 0; mode < 4; mode++) {
+		checkIntDst<uint8_t>(SG_UINT8, mode, 0, 255);
+		checkIntDst<int8_t>(SG_INT8, mode, -128, 127);
+		checkIntDst<int16_t>(SG_INT16, mode, -32768, 32767);
+		checkIntDst<int32_t>(SG_INT32, mode, -2147483648.0, 2147483520.0);
+	}
+}
+
+CYBOZU_TEST_AUTO(quantize)
+{
+	const size_t N = 1000;
+	floatVec x(N);
+	for (size_t i = 0; i < N; i++) x[i] = i * 0.006f - 3;
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		if (!setType(sg, SG_UINT8, SG_FLOAT)) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFunc1 g = (SgFunc1)SgGetFuncAddr(sg, "exp(x)*20");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			std::vector<uint8_t> y(N);
+			g(&y[0], &x[0], N);
+			for (size_t i = 0; i < N; i++) {
+				float ok = std::min(nearbyintf(expf(x[i]) * 20), 255.0f);
+				CYBOZU_TEST_ASSERT(fabs(y[i] - ok) <= 1);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+/*
+	several variables
+*/
+typedef float (*FloatFunc3)(float, float, float);
+
+void checkVar3(FloatFunc3 f, const char *src, const char *var)
+{
+	const size_t N = 300;
+	floatVec x(N), y(N), z(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.01f + 0.5f;
+		y[i] = 2 - i * 0.013f;
+		z[i] = i * 0.02f - 1;
+	}
+	const float *srcs[] = { &x[0], &y[0], &z[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("var=") + var;
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloatN g = (SgFuncFloatN)SgGetFuncAddr(sg, src);
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n += (n < 70 ? 1 : 23)) {
+				floatVec w(n + 1);
+				g(&w[0], srcs, n);
+				int err = 0;
+				for (size_t i = 0; i < n; i++) {
+					float ok = f(x[i], y[i], z[i]);
+					if (!(diff(ok, w[i]) <= MAX_E * 4)) {
+						if (err++ < 4) printf("err %s %s i=%zd ok=%e w=%e\n", src, g_isaTbl[k], i, ok, w[i]);
+					}
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+float f3_1(float x, float y, float z) { return x * expf(y) - z; }
+float f3_2(float x, float y, float) { return (x + 1) * 2 + (y + 3); }
+float f3_3(float x, float, float z) { return 2 / (x + 1) - z / (x * x); }
+float f3_4(float, float y, float) { return y; }
+
+CYBOZU_TEST_AUTO(var3)
+{
+	checkVar3(f3_1, "x*exp(y)-z", "x,y,z");
+	checkVar3(f3_2, "(x+1)*2+(y+3)", "x,y,z");
+	checkVar3(f3_3, "2/(x+1)-z/(x*x)", "x,y,z");
+	checkVar3(f3_4, "y", "x,y,z");
+	// the order of srcs is given by var
+	checkVar3(f3_1, "a*exp(b)-c", "a,b,c");
+}
+
+CYBOZU_TEST_AUTO(dot)
+{
+	const size_t N = 300;
+	floatVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.01f;
+		y[i] = 1 - i * 0.003f;
+	}
+	const float *srcs[] = { &x[0], &y[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = "var=x,y";
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloatNReduce g = (SgFuncFloatNReduce)SgGetFuncAddr(sg, "red_sum(x*y)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n++) {
+				double ok = 0;
+				for (size_t i = 0; i < n; i++) ok += x[i] * y[i];
+				CYBOZU_TEST_NEAR(g(srcs, n), ok, fabs(ok) * 1e-5 + 1e-5);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+/*
+	runtime parameters
+*/
+CYBOZU_TEST_AUTO(param)
+{
+	const size_t N = 100;
+	floatVec x(N);
+	for (size_t i = 0; i < N; i++) x[i] = i * 0.03f - 1;
+	const float paramTbl[][2] = {
+		{ 1, 0 }, { 0.5f, 3 }, { -2, -1.5f }, { 0, 100 },
+	};
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		// compile once
+		SgFuncFloat1Param g = (SgFuncFloat1Param)SgGetFuncAddr(sg, "exp(x*$a)+$b*$a");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(paramTbl); j++) {
+				const float a = paramTbl[j][0], b = paramTbl[j][1];
+				for (size_t n = 0; n <= N; n++) {
+					floatVec y(n + 1);
+					g(&y[0], &x[0], n, paramTbl[j]);
+					int err = 0;
+					for (size_t i = 0; i < n; i++) {
+						float ok = expf(x[i] * a) + b * a;
+						if (!(diff(ok, y[i]) <= MAX_E * 2)) {
+							if (err++ < 4) printf("err %s a=%f b=%f x=%e ok=%e y=%e\n", g_isaTbl[k], a, b, x[i], ok, y[i]);
+						}
+					}
+					CYBOZU_TEST_EQUAL(err, 0);
+				}
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(paramReduceDouble)
+{
+	typedef double (*FuncType)(const double *const *srcs, size_t n, const double *params);
+	const size_t N = 100;
+	std::vector<double> x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.1;
+		y[i] = 2 - i * 0.01;
+	}
+	const double *srcs[] = { &x[0], &y[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = "var=x,y";
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		if (!setType(sg, SG_DOUBLE, SG_DOUBLE)) {
+			SgDestroy(sg);
+			continue;
+		}
+		FuncType g = (FuncType)SgGetFuncAddr(sg, "red_sum($s*x*y+$t)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			const double params[] = { 0.25, -1 };
+			for (size_t n = 0; n <= N; n++) {
+				double ok = 0;
+				for (size_t i = 0; i < n; i++) ok += params[0] * x[i] * y[i] + params[1];
+				CYBOZU_TEST_NEAR(g(srcs, n, params), ok, fabs(ok) * 1e-12 + 1e-12);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+/*
+	several outputs
+*/
+float sq(float x) { return x * x; }
+float id(float x) { return x; }
+
+CYBOZU_TEST_AUTO(multiOut)
+{
+	const size_t N = 300;
+	floatVec x(N);
+	for (size_t i = 0; i < N; i++) x[i] = i * 0.01f + 0.1f;
+	float (*fTbl[])(float) = { expf, logf, sq, id };
+	const size_t M = CYBOZU_NUM_OF_ARRAY(fTbl);
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloatM g = (SgFuncFloatM)SgGetFuncAddr(sg, "y0=exp(x); y1=log(x); x*x; x;");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n += (n < 70 ? 1 : 23)) {
+				std::vector<floatVec> y(M, floatVec(n + 1, 123));
+				float *dsts[M];
+				for (size_t j = 0; j < M; j++) dsts[j] = &y[j][0];
+				g(dsts, &x[0], n);
+				for (size_t j = 0; j < M; j++) {
+					int err = 0;
+					for (size_t i = 0; i < n; i++) {
+						float ok = fTbl[j](x[i]);
+						if (!(diff(ok, y[j][i]) <= MAX_E)) {
+							if (err++ < 4) printf("err %s j=%zd i=%zd ok=%e y=%e\n", g_isaTbl[k], j, i, ok, y[j][i]);
+						}
+					}
+					CYBOZU_TEST_EQUAL(err, 0);
+					CYBOZU_TEST_EQUAL(f2u(y[j][n]), f2u(123));
+				}
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(sincos)
+{
+	const size_t N = 100;
+	floatVec x(N);
+	for (size_t i = 0; i < N; i++) x[i] = i * 0.37f - 10;
+	x[N - 1] = 1e10f;
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloatM g = (SgFuncFloatM)SgGetFuncAddr(sg, "s, c = sincos(x); tan(x)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n++) {
+				floatVec s(n + 1, 123), c(n + 1, 123), t(n + 1, 123);
+				float *dsts[] = { &s[0], &c[0], &t[0] };
+				g(dsts, &x[0], n);
+				int err = 0;
+				for (size_t i = 0; i < n; i++) {
+					if (!(diff(sinf(x[i]), s[i]) <= MAX_E)) err++;
+					if (!(diff(cosf(x[i]), c[i]) <= MAX_E)) err++;
+					if (!(diff(tanf(x[i]), t[i]) <= MAX_E)) err++;
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+				CYBOZU_TEST_EQUAL(f2u(s[n]), f2u(123));
+				CYBOZU_TEST_EQUAL(f2u(c[n]), f2u(123));
+				CYBOZU_TEST_EQUAL(f2u(t[n]), f2u(123));
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(let)
+{
+	const size_t N = 40;
+	floatVec x(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.1f - 2;
+	}
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = std::string("isa=") + g_isaTbl[k];
+		if (*g_isaTbl[k] && SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		// a and b are let-bindings
+		SgFuncFloatM g = (SgFuncFloatM)SgGetFuncAddr(sg, "a = x*x; b = exp(-a); a*b; b/(1+a)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n++) {
+				floatVec y0(n + 1, 123), y1(n + 1, 123);
+				float *dsts[] = { &y0[0], &y1[0] };
+				g(dsts, &x[0], n);
+				int err = 0;
+				for (size_t i = 0; i < n; i++) {
+					const float a = x[i] * x[i];
+					if (!(diff(a * expf(-a), y0[i]) <= MAX_E)) err++;
+					if (!(diff(expf(-a) / (1 + a), y1[i]) <= MAX_E)) err++;
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+				CYBOZU_TEST_EQUAL(f2u(y0[n]), f2u(123));
+				CYBOZU_TEST_EQUAL(f2u(y1[n]), f2u(123));
+			}
+		}
+		SgDestroy(sg);
+		sg = SgCreate();
+		if (*g_isaTbl[k]) CYBOZU_TEST_EQUAL(SgSetOpt(sg, opt.c_str()), 0);
+		// s is an output and c is a let-binding
+		g = (SgFuncFloatM)SgGetFuncAddr(sg, "s, c = sinhcosh(x); c*2");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			floatVec y0(N), y1(N);
+			float *dsts[] = { &y0[0], &y1[0] };
+			g(dsts, &x[0], N);
+			int err = 0;
+			for (size_t i = 0; i < N; i++) {
+				if (!(diff(sinhf(x[i]), y0[i]) <= MAX_E)) err++;
+				if (!(diff(coshf(x[i]) * 2, y1[i]) <= MAX_E)) err++;
+			}
+			CYBOZU_TEST_EQUAL(err, 0);
+		}
+		SgDestroy(sg);
+	}
+	checkD(sigmoidD, "t = exp(x); t/(1+t)", makeRangeD(-10, 10, 1000));
+}
+
+CYBOZU_TEST_AUTO(atan2)
+{
+	const size_t N = 200;
+	floatVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		float t = i * 0.0321f - 3.2f;
+		float r = (i % 7) * 10.0f + 0.01f;
+		x[i] = r * cosf(t);
+		y[i] = r * sinf(t);
+	}
+	x[0] = 0; y[0] = 0;
+	x[1] = -2; y[1] = 0;
+	x[2] = 0; y[2] = -3;
+	const float *srcs[] = { &y[0], &x[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = "var=y,x";
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloatN g = (SgFuncFloatN)SgGetFuncAddr(sg, "atan2(y, x)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n += (n < 20 ? 1 : 31)) {
+				floatVec z(n + 1, 123);
+				g(&z[0], srcs, n);
+				int err = 0;
+				for (size_t i = 0; i < n; i++) {
+					float ok = atan2f(y[i], x[i]);
+					if (!(diff(ok, z[i]) <= MAX_E)) {
+						if (err++ < 4) printf("err %s y=%e x=%e ok=%e z=%e\n", g_isaTbl[k], y[i], x[i], ok, z[i]);
+					}
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+				CYBOZU_TEST_EQUAL(f2u(z[n]), f2u(123));
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+float pow2_5(float x) { return powf(x, 2.5f); }
+double pow2_5D(double x) { return pow(x, 2.5); }
+double cubeD(double x) { return x * x * x; }
+
+CYBOZU_TEST_AUTO(pow)
+{
+	// constant exponents
+	const struct {
+		const char *src;
+		double e;
+		float maxe;
+	} tbl[] = {
+		{ "x^2", 2, MAX_E },
+		{ "x^3", 3, MAX_E },
+		{ "x^-2", -2, MAX_E },
+		{ "pow(x, 5)", 5, MAX_E },
+		{ "x^16", 16, MAX_E },
+		{ "x^0.5", 0.5, MAX_E },
+		{ "x^-0.5", -0.5, MAX_E },
+		// the error of exp(y log(x)) is about |y log(x)| ulp
+		{ "x^2.5", 2.5, 5e-6f },
+		{ "pow(x, -1.3)", -1.3, 5e-6f },
+	};
+	const size_t N = 1000;
+	floatVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = 0.01f + i * 0.01f;
+	}
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(tbl); k++) {
+		SgCode *sg = SgCreate();
+		SgFuncFloat1 addr = (SgFuncFloat1)SgGetFuncAddr(sg, tbl[k].src);
+		CYBOZU_TEST_ASSERT(addr);
+		if (addr) {
+			addr(&y[0], &x[0], N);
+			float maxe = 0;
+			for (size_t i = 0; i < N; i++) {
+				float e = diff(float(pow(double(x[i]), tbl[k].e)), y[i]);
+				if (e > maxe) maxe = e;
+			}
+			printf("%s maxe=%e\n", tbl[k].src, maxe);
+			CYBOZU_TEST_ASSERT(maxe <= tbl[k].maxe);
+		}
+		SgDestroy(sg);
+	}
+	bench("pow", pow2_5, "x^2.5");
+}
+
+CYBOZU_TEST_AUTO(pow_special)
+{
+	const float inf = INFINITY;
+	const float nan = NAN;
+	const float tbl[][2] = {
+		{ 0, -1 }, { -0.0f, -1 }, { -0.0f, 3 }, { -0.0f, 2 }, { 0, 0.5f }, { 0, nan },
+		{ nan, 0 }, { 1, nan }, { 1, inf }, { -1, inf }, { -1, -inf }, { -1, 3 },
+		{ 2, inf }, { 0.5f, inf }, { 2, -inf }, { 0.5f, -inf },
+		{ -2, 3 }, { -2, 4 }, { -2, 0.5f }, { -8, -1 }, { -3, 1e30f },
+		{ inf, 2 }, { inf, -2 }, { -inf, 3 }, { -inf, -3 }, { -inf, 2 }, { -inf, 0.5f },
+		{ 2, 1e-40f }, { 1e-40f, 0.5f }, { 1e-40f, -0.5f }, { 2, 0.5f }, { 10, -5 }, { 0.1f, 5 },
+	};
+	const size_t N = CYBOZU_NUM_OF_ARRAY(tbl);
+	floatVec x(N), y(N), z(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = tbl[i][0];
+		y[i] = tbl[i][1];
+	}
+	const float *srcs[] = { &x[0], &y[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = "var=x,y";
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncFloatN g = (SgFuncFloatN)SgGetFuncAddr(sg, "x^y");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			g(&z[0], srcs, N);
+			for (size_t i = 0; i < N; i++) {
+				float ok = powf(x[i], y[i]);
+				if (std::isnan(ok)) {
+					CYBOZU_TEST_ASSERT(std::isnan(z[i]));
+				} else if (std::isinf(ok) || std::fabs(ok) < FLT_MIN) {
+					CYBOZU_TEST_EQUAL(f2u(z[i]), f2u(ok));
+				} else {
+					CYBOZU_TEST_ASSERT(diff(ok, z[i]) <= 5e-6f);
+				}
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(double_pow)
+{
+	checkD(cubeD, "x^3", makeRangeD(-10, 10, 1000));
+	checkD(sqrt, "x^0.5", makeRangeD(0, 100, 1000));
+	checkD(pow2_5D, "x^2.5", makeRangeD(0, 10, 1000));
+}
+
+float frac(float x) { return x - floorf(x); }
+float sign(float x) { return x > 0 ? 1 : x < 0 ? -1 : x; }
+float clamp(float x, float lo, float hi)
+{
+	float t = x < lo ? lo : x;
+	return t > hi ? hi : t;
+}
+
+CYBOZU_TEST_AUTO(roundAbs)
+{
+	const float inf = INFINITY;
+	const float nan = NAN;
+	const float xTbl[] = {
+		0, -0.0f, 0.5f, -0.5f, 1.5f, -1.5f, 2.5f, -2.5f, 0.49999997f, -0.49999997f,
+		1.2f, -1.7f, 3.99f, -1e-10f, 8388607.5f, -8388609.0f, 1e20f, -1e20f, inf, -inf, nan,
+	};
+	const float yTbl[] = { 1, -1, 0.3f, -2.5f, 7, 1e-3f, inf, -0.0f, 0, nan };
+	const size_t xN = CYBOZU_NUM_OF_ARRAY(xTbl);
+	const size_t yN = CYBOZU_NUM_OF_ARRAY(yTbl);
+	const size_t N = xN * yN;
+	floatVec x(N), y(N), z(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = xTbl[i % xN];
+		y[i] = yTbl[i / xN];
+	}
+	const struct {
+		const char *src;
+		float (*f1)(float);
+		float (*f2)(float, float);
+	} tbl[] = {
+		{ "floor(x)", floorf, 0 },
+		{ "ceil(x)", ceilf, 0 },
+		{ "round(x)", roundf, 0 },
+		{ "trunc(x)", truncf, 0 },
+		{ "frac(x)", frac, 0 },
+		{ "abs(x)", fabsf, 0 },
+		{ "sign(x)", sign, 0 },
+		{ "copysign(x, y)", 0, copysignf },
+		{ "fmod(x, y)", 0, fmodf },
+		{ "min(x, y)", 0, fminf },
+		{ "max(x, y)", 0, fmaxf },
+	};
+	const float *srcs[] = { &x[0], &y[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(tbl); j++) {
+			SgCode *sg = SgCreate();
+			std::string opt = "var=x,y";
+			if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+			if (SgSetOpt(sg, opt.c_str()) != 0) {
+				SgDestroy(sg);
+				break;
+			}
+			const char *src = tbl[j].src;
+			SgFuncFloatN g = (SgFuncFloatN)SgGetFuncAddr(sg, src);
+			CYBOZU_TEST_ASSERT(g);
+			if (g) {
+				g(&z[0], srcs, N);
+				int err = 0;
+				for (size_t i = 0; i < N; i++) {
+					const float ok = tbl[j].f1 ? tbl[j].f1(x[i]) : tbl[j].f2(x[i], y[i]);
+					bool eq;
+					if (tbl[j].f2 == fminf || tbl[j].f2 == fmaxf) {
+						// NaN and the sign of zero depend on the CPU
+						if (std::isnan(x[i]) || std::isnan(y[i])) continue;
+						eq = !(ok < z[i] || z[i] < ok);
+					} else if (tbl[j].f2 == fmodf && std::fabs(x[i] / y[i]) >= 16777216.0f && !std::isinf(y[i])) {
+						continue;
+					} else {
+						eq = std::isnan(ok) ? std::isnan(z[i]) : f2u(ok) == f2u(z[i]);
+					}
+					if (!eq && err++ < 4) printf("err %s %s x=%e y=%e ok=%e z=%e\n", src, g_isaTbl[k], x[i], y[i], ok, z[i]);
+				}
+				CYBOZU_TEST_EQUAL(err, 0);
+			}
+			SgDestroy(sg);
+		}
+	}
+}
+
+CYBOZU_TEST_AUTO(clamp)
+{
+	const float nan = NAN;
+	const float xTbl[] = { -3, -1, -0.5f, 0, 0.5f, 1, 3, nan };
+	const size_t N = CYBOZU_NUM_OF_ARRAY(xTbl);
+	floatVec x(xTbl, xTbl + N), lo(N), hi(N), z(N);
+	for (size_t i = 0; i < N; i++) {
+		lo[i] = -1.0f + i * 0.1f;
+		hi[i] = 2.0f - i * 0.5f; // lo > hi for the last ones
+	}
+	const float *srcs[] = { &x[0], &lo[0], &hi[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = "var=x,lo,hi";
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		// args of var only, a tmp first arg and tmp args after a var
+		SgFuncFloatMN g = (SgFuncFloatMN)SgGetFuncAddr(sg, "clamp(x, lo, hi); clamp(x*2, lo, hi+1); clamp(x, lo*2, hi+1) + 1");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			floatVec z1(N), z2(N);
+			float *const dsts[] = { &z[0], &z1[0], &z2[0] };
+			g(dsts, srcs, N);
+			for (size_t i = 0; i < N; i++) {
+				const float ok[] = {
+					clamp(x[i], lo[i], hi[i]),
+					clamp(x[i] * 2, lo[i], hi[i] + 1),
+					clamp(x[i], lo[i] * 2, hi[i] + 1) + 1,
+				};
+				for (size_t j = 0; j < 3; j++) {
+					const float w = dsts[j][i];
+					if (std::isnan(ok[j])) {
+						CYBOZU_TEST_ASSERT(std::isnan(w));
+					} else {
+						CYBOZU_TEST_EQUAL(f2u(w), f2u(ok[j]));
+					}
+				}
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(where)
+{
+	const float nan = NAN;
+	const float xTbl[] = { -3, -1, -0.5f, 0, 0.5f, 1, 1.5f, 3, nan };
+	const size_t N = CYBOZU_NUM_OF_ARRAY(xTbl);
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		if (*g_isaTbl[k] && SgSetOpt(sg, (std::string("isa=") + g_isaTbl[k]).c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		// the Huber loss and comparisons
+		SgFuncFloatM g = (SgFuncFloatM)SgGetFuncAddr(sg, "where(abs(x) <= 1, 0.5*x*x, abs(x) - 0.5); (x < 0) + (x >= 1)*2; where(x == 0.5, 1, x != 1)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			floatVec z0(N), z1(N), z2(N);
+			float *const dsts[] = { &z0[0], &z1[0], &z2[0] };
+			g(dsts, xTbl, N);
+			for (size_t i = 0; i < N; i++) {
+				const float x = xTbl[i];
+				const float ok[] = {
+					std::fabs(x) <= 1 ? 0.5f * x * x : std::fabs(x) - 0.5f,
+					float(x < 0) + float(x >= 1) * 2,
+					f2u(x) == f2u(0.5f) ? 1 : float(!(f2u(x) == f2u(1.0f))),
+				};
+				for (size_t j = 0; j < 3; j++) {
+					const float w = dsts[j][i];
+					if (std::isnan(ok[j])) {
+						CYBOZU_TEST_ASSERT(std::isnan(w));
+					} else {
+						CYBOZU_TEST_EQUAL(f2u(w), f2u(ok[j]));
+					}
+				}
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+CYBOZU_TEST_AUTO(define)
+{
+	const size_t N = 40;
+	floatVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.25f - 5;
+	}
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		if (*g_isaTbl[k] && SgSetOpt(sg, (std::string("isa=") + g_isaTbl[k]).c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		CYBOZU_TEST_EQUAL(SgDefine(sg, "sq(x)", "x*x"), 0);
+		CYBOZU_TEST_EQUAL(SgDefine(sg, "huber(x,d)", "where(abs(x) <= d, 0.5*sq(x), d*(abs(x) - 0.5*d))"), 0);
+		CYBOZU_TEST_EQUAL(SgDefine(sg, "huber(x,d)", "x"), -1);
+		SgFuncFloat1 g = (SgFuncFloat1)SgGetFuncAddr(sg, "huber(x - 1, 1.5) + sq(x)");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			g(&y[0], &x[0], N);
+			for (size_t i = 0; i < N; i++) {
+				const float t = std::fabs(x[i] - 1);
+				const float ok = (t <= 1.5f ? 0.5f * t * t : 1.5f * (t - 0.75f)) + x[i] * x[i];
+				CYBOZU_TEST_ASSERT(diff(ok, y[i]) <= MAX_E);
+			}
+		}
+		SgDestroy(sg);
+	}
+}
+
+// exp(x) by the Taylor series of degree 12 for |x| <= 1
+std::string getExpPolyStr()
+{
+	std::string s = "poly(x";
+	double c = 1;
+	for (int i = 0; i <= 12; i++) {
+		if (i > 0) c /= i;
+		char buf[64];
+		snprintf(buf, sizeof(buf), ", %.17g", c);
+		s += buf;
+	}
+	return s + ")";
+}
+
+CYBOZU_TEST_AUTO(poly)
+{
+	const std::string src = getExpPolyStr();
+	const size_t N = 100;
+	floatVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.02f - 1;
+	}
+	const char *modeTbl[] = { "poly=horner", "poly=estrin" };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(modeTbl); j++) {
+			SgCode *sg = SgCreate();
+			std::string opt = modeTbl[j];
+			if (*g_isaTbl[k]) opt = opt + " isa=" + g_isaTbl[k];
+			if (SgSetOpt(sg, opt.c_str()) != 0) {
+				SgDestroy(sg);
+				continue;
+			}
+			SgFuncFloat1 g = (SgFuncFloat1)SgGetFuncAddr(sg, src.c_str());
+			CYBOZU_TEST_ASSERT(g);
+			if (g) {
+				g(&y[0], &x[0], N);
+				for (size_t i = 0; i < N; i++) {
+					CYBOZU_TEST_ASSERT(diff(expf(x[i]), y[i]) <= MAX_E);
+				}
+			}
+			SgDestroy(sg);
+		}
+	}
+	checkD(exp, "poly(x, 1)*exp(x)", makeRangeD(-1, 1, 1000));
+}
+
+double fmod0_7D(double x) { return fmod(x, 0.7); }
+
+CYBOZU_TEST_AUTO(double_round)
+{
+	checkD(floor, "floor(x)", makeRangeD(-10, 10, 1000));
+	checkD(round, "round(x)", makeRangeD(-10, 10, 1000));
+	checkD(trunc, "trunc(x)", makeRangeD(-10, 10, 1000));
+	checkD(fmod0_7D, "fmod(x, 0.7)", makeRangeD(-10, 10, 1000));
+}
+
+CYBOZU_TEST_AUTO(multiOutVar)
+{
+	const size_t N = 100;
+	floatVec x(N), y(N);
+	for (size_t i = 0; i < N; i++) {
+		x[i] = i * 0.5f;
+		y[i] = 3 - i * 0.25f;
+	}
+	const float *srcs[] = { &x[0], &y[0] };
+	for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(g_isaTbl); k++) {
+		SgCode *sg = SgCreate();
+		std::string opt = "var=x,y";
+		if (*g_isaTbl[k]) opt += std::string(" isa=") + g_isaTbl[k];
+		if (SgSetOpt(sg, opt.c_str()) != 0) {
+			SgDestroy(sg);
+			continue;
+		}
+		if (!setType(sg, SG_FLOAT16, SG_FLOAT)) {
+			SgDestroy(sg);
+			continue;
+		}
+		SgFuncMN g = (SgFuncMN)SgGetFuncAddr(sg, "s=x+y; d=x-y");
+		CYBOZU_TEST_ASSERT(g);
+		if (g) {
+			for (size_t n = 0; n <= N; n++) {
+				u16Vec s(n + 1), d(n + 1);
+				void *dsts[] = { &s[0], &d[0] };
+				g(dsts, (const void *const *)srcs, n);
+				for (size_t i = 0; i < n; i++) {
+					CYBOZU_TEST_EQUAL(f16ToFloat(s[i]), x[i] + y[i]);
+					CYBOZU_TEST_EQUAL(f16ToFloat(d[i]), x[i] - y[i]);
+				}
+			}
+		}
+		SgDestroy(sg);
+	}
+	SgCode *sg = SgCreate();
+	CYBOZU_TEST_ASSERT(SgGetFuncAddr(sg, "y=x; y=x") == 0);
+	SgDestroy(sg);
+	sg = SgCreate();
+	CYBOZU_TEST_ASSERT(SgGetFuncAddr(sg, "red_sum(x); x") == 0);
+	SgDestroy(sg);
+}
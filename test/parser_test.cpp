@@ -90,6 +90,286 @@ CYBOZU_TEST_AUTO(parse)
 	gen.exec(tl);
 }
 
+CYBOZU_TEST_AUTO(param)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	sg::Parser parser;
+	parser.parse(tl, "x*$a+$b-$a");
+	CYBOZU_TEST_EQUAL(tl.getParamNum(), 2u);
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(vv.size(), 8u);
+	CYBOZU_TEST_EQUAL(vv[7].type, sg::Out);
+	CYBOZU_TEST_EQUAL(vv[1].type, sg::Param);
+	CYBOZU_TEST_EQUAL(vv[1].v, 0u);
+	CYBOZU_TEST_EQUAL(vv[3].type, sg::Param);
+	CYBOZU_TEST_EQUAL(vv[3].v, 1u);
+	CYBOZU_TEST_EQUAL(vv[5].type, sg::Param);
+	CYBOZU_TEST_EQUAL(vv[5].v, 0u);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "x*$"), cybozu::Exception);
+}
+
+CYBOZU_TEST_AUTO(funcArgs)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	sg::Parser parser;
+	parser.parse(tl, "leaky_relu(x*2, $a) + swish(x)");
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(vv.size(), 9u);
+	CYBOZU_TEST_EQUAL(vv[4].type, sg::Func);
+	CYBOZU_TEST_EQUAL(vv[4].v, uint32_t(sg::LeakyRelu));
+	CYBOZU_TEST_EQUAL(vv[6].type, sg::Func);
+	CYBOZU_TEST_EQUAL(vv[6].v, uint32_t(sg::Silu));
+	CYBOZU_TEST_EQUAL(tl.getMaxTmpNum(), 2);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "leaky_relu(x)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "tanh(x, 1)"), cybozu::Exception);
+}
+
+CYBOZU_TEST_AUTO(funcArgs3)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	sg::Parser parser;
+	parser.parse(tl, "clamp(x, $lo, 2*x) + 1");
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(vv.size(), 9u);
+	CYBOZU_TEST_EQUAL(vv[5].type, sg::Func);
+	CYBOZU_TEST_EQUAL(vv[5].v, uint32_t(sg::Clamp));
+	CYBOZU_TEST_EQUAL(vv[7].type, sg::Op);
+	CYBOZU_TEST_EQUAL(tl.getMaxTmpNum(), 4);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "clamp(x, 1)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "clamp(x, 1, 2, 3)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "min(x)"), cybozu::Exception);
+}
+
+CYBOZU_TEST_AUTO(multiRet)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	sg::Parser parser;
+	parser.parse(tl, "s, c = sincos(x*2); t = tan(x)");
+	CYBOZU_TEST_EQUAL(tl.getOutNum(), 3u);
+	CYBOZU_TEST_EQUAL(tl.getMaxTmpNum(), 3);
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(vv.size(), 9u);
+	CYBOZU_TEST_EQUAL(vv[3].type, sg::Func);
+	CYBOZU_TEST_EQUAL(vv[3].v, uint32_t(sg::SinCos));
+	CYBOZU_TEST_EQUAL(vv[4].type, sg::Out);
+	CYBOZU_TEST_EQUAL(vv[5].type, sg::Out);
+	parser.parse(tl, "sincos(x)");
+	CYBOZU_TEST_EQUAL(tl.getOutNum(), 2u);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "sincos(x)+1"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "exp(sincos(x))"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "s = sincos(x)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "s, c, t = sincos(x)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "s, s = sincos(x)"), cybozu::Exception);
+}
+
+CYBOZU_TEST_AUTO(cmp)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	sg::Parser parser;
+	parser.parse(tl, "y = where(x*2 <= 1, x, -x)");
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(vv.size(), 10u);
+	CYBOZU_TEST_EQUAL(vv[4].type, sg::Op);
+	CYBOZU_TEST_EQUAL(vv[4].v, uint32_t(sg::Le));
+	CYBOZU_TEST_EQUAL(vv[8].type, sg::Func);
+	CYBOZU_TEST_EQUAL(vv[8].v, uint32_t(sg::Where));
+	CYBOZU_TEST_EQUAL(tl.outName_[0], "y");
+	const struct {
+		const char *s;
+		int op;
+	} tbl[] = {
+		{ "x < 1", sg::Lt },
+		{ "x<=1", sg::Le },
+		{ "x > 1", sg::Gt },
+		{ "x >= 1", sg::Ge },
+		{ "x == 1", sg::Eq },
+		{ "x != 1", sg::Ne },
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		parser.parse(tl, tbl[i].s);
+		CYBOZU_TEST_EQUAL(tl.getOutNum(), 1u);
+		CYBOZU_TEST_EQUAL(tl.outName_[0], "");
+		CYBOZU_TEST_EQUAL(tl.getValueVec()[2].v, uint32_t(tbl[i].op));
+	}
+	// the comparison has the lowest precedence
+	parser.parse(tl, "(x + 1 < 2*x) + 1");
+	CYBOZU_TEST_EQUAL(tl.getValueVec()[6].v, uint32_t(sg::Lt));
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "x < 1 < 2"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "x = 1"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "x ! 1"), cybozu::Exception);
+}
+
+CYBOZU_TEST_AUTO(let)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	sg::Parser parser;
+	parser.parse(tl, "t = exp(x); y = t/(1+t); u = t*2");
+	CYBOZU_TEST_EQUAL(tl.getOutNum(), 2u);
+	CYBOZU_TEST_EQUAL(tl.getLetNum(), 1u);
+	CYBOZU_TEST_EQUAL(tl.outName_[0], "y");
+	CYBOZU_TEST_EQUAL(tl.outName_[1], "u");
+	CYBOZU_TEST_EQUAL(tl.getMaxTmpNum(), 3);
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(vv.size(), 13u);
+	CYBOZU_TEST_EQUAL(vv[2].type, sg::Let);
+	CYBOZU_TEST_EQUAL(vv[2].v, 0u);
+	CYBOZU_TEST_EQUAL(vv[3].type, sg::LetVar);
+	CYBOZU_TEST_EQUAL(vv[3].v, 0u);
+	CYBOZU_TEST_EQUAL(vv[8].type, sg::Out);
+	CYBOZU_TEST_EQUAL(vv[8].v, 0u);
+	CYBOZU_TEST_EQUAL(vv[12].type, sg::Out);
+	CYBOZU_TEST_EQUAL(vv[12].v, 1u);
+	// Let pops the stack in the reverse order
+	parser.parse(tl, "s, c = sincos(x); s/c");
+	CYBOZU_TEST_EQUAL(tl.getOutNum(), 1u);
+	CYBOZU_TEST_EQUAL(tl.getLetNum(), 2u);
+	CYBOZU_TEST_EQUAL(vv[2].type, sg::Let);
+	CYBOZU_TEST_EQUAL(vv[2].v, 1u);
+	CYBOZU_TEST_EQUAL(vv[3].type, sg::Let);
+	CYBOZU_TEST_EQUAL(vv[3].v, 0u);
+	parser.parse(tl, "s, c = sincos(x); c*2");
+	CYBOZU_TEST_EQUAL(tl.getOutNum(), 2u);
+	CYBOZU_TEST_EQUAL(tl.getLetNum(), 1u);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "s, c = sincos(x); s*2"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "t = t*2; t"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "t*2; t = x"), cybozu::Exception);
+}
+
+std::string getTokenStr(const sg::TokenList& tl)
+{
+	std::string s;
+	const sg::ValueVec& vv = tl.getValueVec();
+	for (size_t i = 0; i < vv.size(); i++) {
+		s += vv[i].getStr() + ' ';
+	}
+	return s;
+}
+
+CYBOZU_TEST_AUTO(macro)
+{
+	sg::MacroVec mv;
+	sg::Parser parser;
+	parser.define(mv, "softclip(x,a)", "a*tanh(x/a)");
+	parser.define(mv, " huber ( x , d ) ", "where(abs(x) <= d, 0.5*x*x, d*(abs(x) - 0.5*d))");
+	// the number 2e-1 and the runtime parameter $d are not replaced
+	parser.define(mv, "f(e, d)", "softclip(e, 2e-1) + $d*d");
+	CYBOZU_TEST_EQUAL(mv.size(), 3u);
+	sg::StrVec args;
+	args.push_back("x*2");
+	args.push_back("3");
+	CYBOZU_TEST_EQUAL(mv[0].expand(args), "((3)*tanh((x*2)/(3)))");
+	args[0] = "y";
+	args[1] = "z";
+	CYBOZU_TEST_EQUAL(mv[2].expand(args), "(softclip((y), 2e-1) + $d*(z))");
+	const struct {
+		const char *src;
+		const char *expanded;
+	} tbl[] = {
+		{ "softclip(x*2, 3) + 1", "((3)*tanh((x*2)/(3))) + 1" },
+		{ "softclip(softclip(x, 1), min(x, 2))", "(min(x, 2))*tanh(((1)*tanh(x/(1)))/(min(x, 2)))" },
+		{ "huber(x - 1, 1.5)", "where(abs(x - 1) <= 1.5, 0.5*(x - 1)*(x - 1), 1.5*(abs(x - 1) - 0.5*1.5))" },
+		{ "-f(x, x)^2", "-(((0.2)*tanh(x/(0.2))) + $d*x)^2" },
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		sg::TokenList tl1, tl2;
+		tl1.setVar("x");
+		tl2.setVar("x");
+		parser.setMacroVec(&mv);
+		parser.parse(tl1, tbl[i].src);
+		parser.setMacroVec(0);
+		parser.parse(tl2, tbl[i].expanded);
+		CYBOZU_TEST_EQUAL(getTokenStr(tl1), getTokenStr(tl2));
+		CYBOZU_TEST_EQUAL(tl1.getMaxTmpNum(), tl2.getMaxTmpNum());
+	}
+	sg::TokenList tl;
+	tl.setVar("x");
+	parser.setMacroVec(&mv);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "softclip(x)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "softclip(x, 1, 2)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "softclip(x, )"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "softclip(x, 1"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "softclip(x)", "x"), cybozu::Exception); // twice
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "exp(x)", "x"), cybozu::Exception); // builtin
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x, x)", "x"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x", "x"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x) y", "x"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x)", "x*y"), cybozu::Exception); // y is not a param
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x)", "g(x)"), cybozu::Exception); // recursive
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x)", "x; x"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x)", "y = x"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.define(mv, "g(x)", "sincos(x)"), cybozu::Exception);
+	CYBOZU_TEST_EQUAL(mv.size(), 3u);
+}
+
+CYBOZU_TEST_AUTO(poly)
+{
+	sg::Parser parser;
+	sg::TokenList tl;
+	tl.setVar("x");
+	parser.parse(tl, "poly(x*2, 1, -0.5, 2e-3) + poly(x, 3)");
+	CYBOZU_TEST_EQUAL(getTokenStr(tl), "var{0} float{2.000000(0x40000000)} mul poly var{0} poly add out{0} ");
+	const sg::ValueVec& vv = tl.getValueVec();
+	CYBOZU_TEST_EQUAL(tl.getPolyCoef(vv[3]).size(), 3u);
+	CYBOZU_TEST_EQUAL(sg::d2u(tl.getPolyCoef(vv[3])[1]), sg::d2u(-0.5));
+	CYBOZU_TEST_EQUAL(tl.getPolyCoef(vv[5]).size(), 1u);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "poly(x)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "poly(x, )"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "poly(x, x)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "poly(x, 1, $a)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "poly(x, 1 2)"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "poly(x, 1"), cybozu::Exception);
+}
+
+CYBOZU_TEST_AUTO(pow)
+{
+	sg::TokenList tl;
+	tl.setVar("x");
+	tl.setVar("y");
+	sg::Parser parser;
+	parser.parse(tl, "x^3");
+	{
+		const sg::ValueVec& vv = tl.getValueVec();
+		CYBOZU_TEST_EQUAL(vv.size(), 3u);
+		CYBOZU_TEST_EQUAL(vv[1].type, sg::Func);
+		CYBOZU_TEST_EQUAL(vv[1].v, uint32_t(sg::PowConst));
+		CYBOZU_TEST_EQUAL(sg::d2u(vv[1].d), sg::d2u(3));
+		CYBOZU_TEST_EQUAL(tl.getMaxTmpNum(), 1);
+	}
+	parser.parse(tl, "pow(x, -0.5)*2");
+	{
+		const sg::ValueVec& vv = tl.getValueVec();
+		CYBOZU_TEST_EQUAL(vv.size(), 5u);
+		CYBOZU_TEST_EQUAL(vv[1].v, uint32_t(sg::PowConst));
+		CYBOZU_TEST_EQUAL(sg::d2u(vv[1].d), sg::d2u(-0.5));
+	}
+	// right associative
+	parser.parse(tl, "x^y^2");
+	{
+		const sg::ValueVec& vv = tl.getValueVec();
+		CYBOZU_TEST_EQUAL(vv.size(), 5u);
+		CYBOZU_TEST_EQUAL(vv[2].v, uint32_t(sg::PowConst));
+		CYBOZU_TEST_EQUAL(vv[3].v, uint32_t(sg::Pow));
+		CYBOZU_TEST_EQUAL(tl.getMaxTmpNum(), 2);
+	}
+	// -x^2 = -(x^2)
+	const char *negTbl[] = { "-x^2", "-2^x" };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(negTbl); i++) {
+		parser.parse(tl, negTbl[i]);
+		const sg::ValueVec& vv = tl.getValueVec();
+		CYBOZU_TEST_EQUAL(vv[vv.size() - 2].v, uint32_t(sg::Neg));
+	}
+	parser.parse(tl, "pow(x, y+1)");
+	CYBOZU_TEST_EQUAL(tl.getValueVec()[4].v, uint32_t(sg::Pow));
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "x^"), cybozu::Exception);
+	CYBOZU_TEST_EXCEPTION(parser.parse(tl, "pow(x)"), cybozu::Exception);
+}
+
 #define TEST_FUNC (1+x*(2+x*(3+x)+2*x))
 #define STR_(x) #x
 #define STR(x) STR_(x)